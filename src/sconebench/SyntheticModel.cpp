@@ -0,0 +1,478 @@
+/*
+** SyntheticModel.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "SyntheticModel.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/profiler_config.h"
+#include "scone/core/string_tools.h"
+#include "scone/model/Leg.h"
+#include "xo/geometry/vec3.h"
+#include "xo/numerical/constants.h"
+#include "xo/numerical/math.h"
+#include "xo/time/timer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace scone
+{
+	// scoped timer that accumulates into a timing slot
+	template< typename T > struct ScopedTiming
+	{
+		ScopedTiming( T& t ) : timing_( t ) {}
+		~ScopedTiming() { timing_.total += timer_(); ++timing_.count; }
+		T& timing_;
+		xo::timer timer_;
+	};
+
+	SyntheticBody::SyntheticBody( SyntheticModel& model, const String& name, Real mass, const Vec3& joint_ofs, const Vec3& local_com ) :
+		model_( model ),
+		name_( name ),
+		mass_( mass ),
+		joint_ofs_( joint_ofs ),
+		local_com_( local_com )
+	{}
+
+	Quat SyntheticBody::GetOrientation() const
+	{
+		return Quat( std::cos( 0.5 * angle_ ), 0, 0, std::sin( 0.5 * angle_ ) );
+	}
+
+	Vec3 SyntheticBody::GetLinVelOfPointOnBody( Vec3 point ) const
+	{
+		auto r = Rotate( point );
+		return vel_ + Vec3( -ang_vel_ * r.y, ang_vel_ * r.x, 0 );
+	}
+
+	const Model& SyntheticBody::GetModel() const { return model_; }
+	Model& SyntheticBody::GetModel() { return model_; }
+
+	Vec3 SyntheticBody::Rotate( const Vec3& v ) const
+	{
+		auto c = std::cos( angle_ ), s = std::sin( angle_ );
+		return Vec3( c * v.x - s * v.y, s * v.x + c * v.y, v.z );
+	}
+
+	void SyntheticBody::UpdateKinematics( Real angle, double dt, bool reset )
+	{
+		auto prev_pos = pos_, prev_vel = vel_, prev_com = com_pos_, prev_com_vel = com_vel_;
+		auto prev_angle = angle_, prev_ang_vel = ang_vel_;
+
+		// position follows from the parent body, or from the pelvis dofs for the root
+		angle_ = angle;
+		if ( auto* parent = static_cast<const SyntheticBody*>( GetParentBody() ) )
+			pos_ = parent->GetPosOfPointOnBody( joint_ofs_ );
+		else pos_ = joint_ofs_;
+		com_pos_ = GetPosOfPointOnBody( local_com_ );
+
+		// velocities and accelerations are finite differences
+		if ( reset || dt <= 0 )
+		{
+			vel_ = acc_ = com_vel_ = com_acc_ = Vec3::zero();
+			ang_vel_ = ang_acc_ = 0;
+		}
+		else
+		{
+			vel_ = ( pos_ - prev_pos ) / dt;
+			acc_ = ( vel_ - prev_vel ) / dt;
+			com_vel_ = ( com_pos_ - prev_com ) / dt;
+			com_acc_ = ( com_vel_ - prev_com_vel ) / dt;
+			ang_vel_ = ( angle_ - prev_angle ) / dt;
+			ang_acc_ = ( ang_vel_ - prev_ang_vel ) / dt;
+		}
+	}
+
+	SyntheticJoint::SyntheticJoint( SyntheticBody& body, SyntheticBody& parent_body, const String& name ) :
+		Joint( body, parent_body ),
+		name_( name )
+	{}
+
+	Vec3 SyntheticJoint::GetReactionForce() const
+	{
+		return Vec3( 0, 2 * m_Body.GetMass() * 9.81, 0 );
+	}
+
+	SyntheticDof::SyntheticDof( SyntheticModel& model, const String& name, const Joint* joint, Real offset, Real amplitude, Real phase, Real drift ) :
+		Dof( joint ),
+		model_( model ),
+		name_( name ),
+		offset_( offset ),
+		amplitude_( amplitude ),
+		phase_( phase ),
+		drift_( drift )
+	{}
+
+	Real SyntheticDof::GetMoment() const
+	{
+		Real moment = 0;
+		for ( auto& m : model_.GetMuscles() )
+			moment += m->GetMomentArm( *this ) * m->GetForce();
+		return moment;
+	}
+
+	void SyntheticDof::UpdateKinematics( double time, Real frequency )
+	{
+		auto w = 2 * xo::constantsd::pi() * frequency;
+		pos_ = offset_ + drift_ * time + amplitude_ * std::sin( w * time + phase_ );
+		vel_ = drift_ + amplitude_ * w * std::cos( w * time + phase_ );
+	}
+
+	SyntheticMuscle::SyntheticMuscle( SyntheticModel& model, const String& name, const Body& origin, const Body& insertion,
+		std::vector< std::pair< const Dof*, Real > > moment_arms, Real max_isometric_force ) :
+		model_( model ),
+		name_( name ),
+		origin_( origin ),
+		insertion_( insertion ),
+		moment_arms_( std::move( moment_arms ) ),
+		max_isometric_force_( max_isometric_force ),
+		optimal_fiber_length_( 0.1 ),
+		tendon_slack_length_( 0.2 )
+	{}
+
+	const Model& SyntheticMuscle::GetModel() const { return model_; }
+
+	Real SyntheticMuscle::GetMomentArm( const Dof& dof ) const
+	{
+		for ( auto& [d, r] : moment_arms_ )
+			if ( d == &dof )
+				return r;
+		return 0;
+	}
+
+	Real SyntheticMuscle::GetLength() const
+	{
+		// fibers are at optimal length when all dofs are zero
+		Real l = optimal_fiber_length_ + tendon_slack_length_;
+		for ( auto& [d, r] : moment_arms_ )
+			l -= r * d->GetPos();
+		return l;
+	}
+
+	Real SyntheticMuscle::GetVelocity() const
+	{
+		Real v = 0;
+		for ( auto& [d, r] : moment_arms_ )
+			v -= r * d->GetVel();
+		return v;
+	}
+
+	Real SyntheticMuscle::GetActiveForceLengthMultipler() const
+	{
+		auto x = ( GetNormalizedFiberLength() - 1 ) / 0.5;
+		return std::exp( -x * x );
+	}
+
+	Real SyntheticMuscle::GetActiveFiberForce() const
+	{
+		auto fv = xo::clamped( 1 + 0.8 * GetNormalizedFiberVelocity(), 0.0, 1.5 );
+		return max_isometric_force_ * activation_ * GetActiveForceLengthMultipler() * fv;
+	}
+
+	Real SyntheticMuscle::GetPassiveFiberForce() const
+	{
+		auto x = std::max( 0.0, GetNormalizedFiberLength() - 1 );
+		return max_isometric_force_ * 5 * x * x;
+	}
+
+	void SyntheticMuscle::UpdateActivation( double dt )
+	{
+		excitation_ = xo::clamped( GetInput(), 0.0, 1.0 );
+		auto tau = excitation_ > activation_ ? 0.01 : 0.04;
+		activation_ += dt * ( excitation_ - activation_ ) / tau;
+	}
+
+	SyntheticModel::SyntheticModel( const PropNode& props, Params& par ) :
+		Model( props, par ),
+		time_( 0 ),
+		prev_time_( 0 ),
+		end_time_( 1e12 ),
+		step_( 0 ),
+		prev_step_( 0 ),
+		mass_( 0 )
+	{
+		SCONE_PROFILE_FUNCTION( GetProfiler() );
+
+		name_ = props.get< String >( "name", "SyntheticModel" );
+		INIT_PROP( props, legs, 2 );
+		INIT_PROP( props, leg_dofs, 3 );
+		INIT_PROP( props, leg_muscles, 8 );
+		INIT_PROP( props, extra_bodies, 1 );
+		INIT_PROP( props, frequency, 1.0 );
+		INIT_PROP( props, amplitude, 0.4 );
+		INIT_PROP( props, velocity, 1.2 );
+		SCONE_ERROR_IF( leg_dofs == 0, "leg_dofs must be > 0" );
+
+		const Real leg_length = 0.9;
+		const Real segment_length = leg_length / leg_dofs;
+		const Real pi = xo::constantsd::pi();
+
+		// pelvis with planar root dofs
+		auto* pelvis = new SyntheticBody( *this, "pelvis", 11.0, Vec3::zero(), Vec3::zero() );
+		m_Bodies.emplace_back( pelvis );
+		m_Dofs.emplace_back( new SyntheticDof( *this, "pelvis_tilt", nullptr, 0, 0.05, 0 ) );
+		auto* pelvis_tilt = static_cast<SyntheticDof*>( m_Dofs.back().get() );
+		m_Dofs.emplace_back( new SyntheticDof( *this, "pelvis_tx", nullptr, 0, 0, 0, velocity ) );
+		m_Dofs.emplace_back( new SyntheticDof( *this, "pelvis_ty", nullptr, 0.98 * leg_length, 0.02, 0 ) );
+		body_dofs_.emplace_back( pelvis, pelvis_tilt );
+
+		// bodies without dofs
+		SyntheticBody* parent = pelvis;
+		for ( index_t i = 0; i < extra_bodies; ++i )
+		{
+			auto* b = new SyntheticBody( *this, stringf( "body%d", int( i ) ), 20.0 / extra_bodies, Vec3( 0, i == 0 ? 0.1 : 0.3, 0 ), Vec3( 0, 0.15, 0 ) );
+			m_Bodies.emplace_back( b );
+			m_Joints.emplace_back( new SyntheticJoint( *b, *parent, b->GetName() + "_joint" ) );
+			body_dofs_.emplace_back( b, nullptr );
+			parent = b;
+		}
+
+		// legs
+		for ( index_t leg = 0; leg < legs; ++leg )
+		{
+			auto side = leg % 2 == 0 ? RightSide : LeftSide;
+			auto postfix = ( legs > 2 ? stringf( "%d", int( leg / 2 ) ) : String() ) + ( side == RightSide ? "_r" : "_l" );
+			auto phase = leg * 2 * pi / std::max<size_t>( legs, 1 );
+
+			// chain of bodies with one dof each
+			std::vector< SyntheticBody* > leg_bodies;
+			std::vector< SyntheticDof* > dofs;
+			SyntheticBody* leg_parent = pelvis;
+			for ( index_t i = 0; i < leg_dofs; ++i )
+			{
+				auto ofs = i == 0 ? Vec3( 0, -0.05, side == RightSide ? 0.08 : -0.08 ) : Vec3( 0, -segment_length, 0 );
+				auto* b = new SyntheticBody( *this, stringf( "segment%d", int( i ) ) + postfix, 8.0 / ( i + 1 ), ofs, Vec3( 0, -0.5 * segment_length, 0 ) );
+				m_Bodies.emplace_back( b );
+				m_Joints.emplace_back( new SyntheticJoint( *b, *leg_parent, stringf( "joint%d", int( i ) ) + postfix ) );
+				m_Dofs.emplace_back( new SyntheticDof( *this, stringf( "dof%d", int( i ) ) + postfix, m_Joints.back().get(), 0, amplitude, phase + 0.7 * i ) );
+				leg_bodies.push_back( b );
+				dofs.push_back( static_cast<SyntheticDof*>( m_Dofs.back().get() ) );
+				body_dofs_.emplace_back( b, dofs.back() );
+				leg_parent = b;
+			}
+
+			// flexor / extensor pairs, every other pair crosses two joints
+			for ( index_t i = 0; i < leg_muscles; ++i )
+			{
+				auto d = ( i / 2 ) % leg_dofs;
+				auto biarticular = ( i / 2 / leg_dofs ) % 2 == 1 && d + 1 < leg_dofs;
+				auto sign = i % 2 == 0 ? 1.0 : -1.0;
+				std::vector< std::pair< const Dof*, Real > > moment_arms{ { dofs[ d ], sign * 0.04 } };
+				if ( biarticular )
+					moment_arms.emplace_back( dofs[ d + 1 ], -sign * 0.03 );
+				const Body& origin = d == 0 ? *pelvis : *leg_bodies[ d - 1 ];
+				const Body& insertion = *leg_bodies[ biarticular ? d + 1 : d ];
+				m_Muscles.emplace_back( new SyntheticMuscle( *this, stringf( "muscle%d", int( i ) ) + postfix, origin, insertion, moment_arms, 1000.0 + 200.0 * ( i % 5 ) ) );
+				m_Actuators.push_back( m_Muscles.back().get() );
+			}
+
+			// contact force at the foot
+			feet_.push_back( leg_bodies.back() );
+			contact_forces_.push_back( new SyntheticContactForce( "foot" + postfix ) );
+			m_ContactForces.emplace_back( contact_forces_.back() );
+		}
+
+		for ( auto& b : m_Bodies )
+			mass_ += b->GetMass();
+
+		// state, initial kinematics and muscle activation
+		for ( auto& d : m_Dofs )
+		{
+			state_.AddVariable( d->GetName() );
+			state_.AddVariable( d->GetName() + "_u" );
+		}
+		for ( auto& m : m_Muscles )
+		{
+			static_cast<SyntheticMuscle&>( *m ).activation_ = initial_equilibration_activation;
+			state_.AddVariable( m->GetName() + ".activation" );
+		}
+		for ( auto& d : m_Dofs )
+			static_cast<SyntheticDof&>( *d ).UpdateKinematics( time_, frequency );
+		UpdateKinematics( 0, true );
+		UpdateStateFromModel();
+
+		// legs are created after the initial kinematics, because Leg measures its length on construction
+		for ( index_t leg = 0; leg < legs; ++leg )
+		{
+			auto* upper = body_dofs_[ 1 + extra_bodies + leg * leg_dofs ].first;
+			auto side = leg % 2 == 0 ? RightSide : LeftSide;
+			m_Legs.emplace_back( new Leg( *upper, *feet_[ leg ], leg, side, leg / 2, contact_forces_[ leg ] ) );
+		}
+
+		CreateControllers( props, par );
+	}
+
+	SyntheticModel::~SyntheticModel()
+	{}
+
+	void SyntheticModel::SetState( const State& state, TimeInSeconds timestamp )
+	{
+		SetStateValues( state.GetValues(), timestamp );
+	}
+
+	void SyntheticModel::SetStateValues( const std::vector< Real >& state, TimeInSeconds timestamp )
+	{
+		SCONE_ASSERT( state.size() >= state_.GetSize() );
+		index_t idx = 0;
+		for ( auto& d : m_Dofs )
+		{
+			d->SetPos( state[ idx++ ] );
+			d->SetVel( state[ idx++ ] );
+		}
+		for ( auto& m : m_Muscles )
+			static_cast<SyntheticMuscle&>( *m ).activation_ = state[ idx++ ];
+
+		time_ = prev_time_ = timestamp;
+		UpdateKinematics( 0, true );
+		UpdateStateFromModel();
+		InvalidateStepCache();
+	}
+
+	void SyntheticModel::AdvanceSimulationTo( double time )
+	{
+		SCONE_PROFILE_FUNCTION( GetProfiler() );
+		ScopedTiming sim_timing( t_sim_ );
+
+		if ( step_ == 0 && GetStoreData() )
+			StoreCurrentFrame();
+
+		auto dt = fixed_control_step_size;
+		int number_of_steps = static_cast<int>( 0.5 + ( time - GetTime() ) / dt );
+		for ( int current_step = 0; current_step < number_of_steps; ++current_step )
+		{
+			{
+				ScopedTiming t( t_controls_ );
+				UpdateControlValues();
+			}
+
+			{
+				// advance the scripted motion and muscle activation
+				ScopedTiming t( t_model_ );
+				{
+					ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Step" );
+					prev_time_ = time_;
+					prev_step_ = step_;
+					time_ += dt;
+					++step_;
+					for ( auto& d : m_Dofs )
+						static_cast<SyntheticDof&>( *d ).UpdateKinematics( time_, frequency );
+					for ( auto& m : m_Muscles )
+						static_cast<SyntheticMuscle&>( *m ).UpdateActivation( dt );
+				}
+				{
+					ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Realize" );
+					UpdateKinematics( dt, false );
+					UpdateStateFromModel();
+					InvalidateStepCache();
+				}
+			}
+
+			{
+				ScopedTiming t( t_sensors_ );
+				UpdateSensorDelayAdapters();
+			}
+
+			{
+				ScopedTiming t( t_analyses_ );
+				UpdateAnalyses();
+			}
+
+			if ( GetStoreData() )
+			{
+				ScopedTiming t( t_store_ );
+				StoreCurrentFrame();
+			}
+
+			if ( HasSimulationEnded() )
+				break;
+		}
+	}
+
+	std::vector<std::pair<String, std::pair<xo::time, size_t>>> SyntheticModel::GetBenchmarks() const
+	{
+		std::vector<std::pair<String, std::pair<xo::time, size_t>>> benchmarks;
+		for ( auto& [name, t] : { std::pair{ "Simulation", &t_sim_ }, { "Model", &t_model_ }, { "Controls", &t_controls_ },
+			{ "SensorDelays", &t_sensors_ }, { "Analyses", &t_analyses_ }, { "StoreData", &t_store_ } } )
+			if ( t->count > 0 )
+				benchmarks.push_back( { name, { t->total, t->count } } );
+		return benchmarks;
+	}
+
+	Vec3 SyntheticModel::GetComPos() const
+	{
+		Vec3 com = Vec3::zero();
+		for ( auto& b : m_Bodies )
+			com += b->GetMass() * b->GetComPos();
+		return com / mass_;
+	}
+
+	Vec3 SyntheticModel::GetComVel() const
+	{
+		Vec3 vel = Vec3::zero();
+		for ( auto& b : m_Bodies )
+			vel += b->GetMass() * b->GetComVel();
+		return vel / mass_;
+	}
+
+	Vec3 SyntheticModel::GetComAcc() const
+	{
+		Vec3 acc = Vec3::zero();
+		for ( auto& b : m_Bodies )
+			acc += b->GetMass() * b->GetComAcc();
+		return acc / mass_;
+	}
+
+	Vec3 SyntheticModel::GetAngMom() const
+	{
+		auto com = GetComPos();
+		auto com_vel = GetComVel();
+		Vec3 ang_mom = Vec3::zero();
+		for ( auto& b : m_Bodies )
+			ang_mom += b->GetMass() * xo::cross_product( b->GetComPos() - com, b->GetComVel() - com_vel );
+		return ang_mom;
+	}
+
+	void SyntheticModel::UpdateKinematics( double dt, bool reset )
+	{
+		// pelvis position comes from the root dofs, other bodies add their dof angle to the parent orientation
+		auto& pelvis = *body_dofs_.front().first;
+		pelvis.joint_ofs_ = Vec3( m_Dofs[ 1 ]->GetPos(), m_Dofs[ 2 ]->GetPos(), 0 );
+		for ( auto& [body, dof] : body_dofs_ )
+		{
+			auto* parent = static_cast<const SyntheticBody*>( body->GetParentBody() );
+			auto angle = ( parent ? parent->angle_ : 0.0 ) + ( dof ? dof->GetPos() : 0.0 );
+			body->UpdateKinematics( angle, dt, reset );
+		}
+
+		// scripted foot loads, alternating between legs
+		auto w = 2 * xo::constantsd::pi() * frequency;
+		for ( index_t i = 0; i < feet_.size(); ++i )
+		{
+			auto phase = i * 2 * xo::constantsd::pi() / feet_.size();
+			auto load = 1.2 * GetBW() * std::max( 0.0, std::sin( w * time_ + phase ) );
+			auto& foot = *feet_[ i ];
+			auto& cf = *contact_forces_[ i ];
+			cf.force_ = Vec3( 0.1 * load, load, 0 );
+			cf.point_ = Vec3( foot.pos_.x, 0, foot.pos_.z );
+			cf.moment_ = Vec3::zero();
+			foot.contact_force_ = cf.force_;
+			foot.contact_point_ = cf.point_;
+		}
+	}
+
+	void SyntheticModel::UpdateStateFromModel()
+	{
+		index_t idx = 0;
+		for ( auto& d : m_Dofs )
+		{
+			state_.SetValue( idx++, d->GetPos() );
+			state_.SetValue( idx++, d->GetVel() );
+		}
+		for ( auto& m : m_Muscles )
+			state_.SetValue( idx++, m->GetActivation() );
+	}
+}
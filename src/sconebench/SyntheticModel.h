@@ -0,0 +1,280 @@
+/*
+** SyntheticModel.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/model/Model.h"
+#include "scone/model/Body.h"
+#include "scone/model/ContactForce.h"
+#include "scone/model/Dof.h"
+#include "scone/model/Joint.h"
+#include "scone/model/Muscle.h"
+#include "scone/model/State.h"
+#include "xo/time/time.h"
+
+namespace scone
+{
+	class SyntheticModel;
+
+	/// Body with kinematics computed by SyntheticModel.
+	class SyntheticBody : public Body
+	{
+	public:
+		SyntheticBody( SyntheticModel& model, const String& name, Real mass, const Vec3& joint_ofs, const Vec3& local_com );
+
+		virtual const String& GetName() const override { return name_; }
+		virtual Real GetMass() const override { return mass_; }
+		virtual Vec3 GetInertiaTensorDiagonal() const override { return Vec3( 0.1, 0.1, 0.1 ) * mass_; }
+
+		virtual Vec3 GetOriginPos() const override { return pos_; }
+		virtual Vec3 GetComPos() const override { return com_pos_; }
+		virtual Vec3 GetLocalComPos() const override { return local_com_; }
+		virtual Quat GetOrientation() const override;
+		virtual Vec3 GetPosOfPointOnBody( Vec3 point ) const override { return pos_ + Rotate( point ); }
+
+		virtual Vec3 GetComVel() const override { return com_vel_; }
+		virtual Vec3 GetOriginVel() const override { return vel_; }
+		virtual Vec3 GetAngVel() const override { return Vec3( 0, 0, ang_vel_ ); }
+		virtual Vec3 GetLinVelOfPointOnBody( Vec3 point ) const override;
+
+		virtual Vec3 GetComAcc() const override { return com_acc_; }
+		virtual Vec3 GetOriginAcc() const override { return acc_; }
+		virtual Vec3 GetAngAcc() const override { return Vec3( 0, 0, ang_acc_ ); }
+		virtual Vec3 GetLinAccOfPointOnBody( Vec3 point ) const override { return acc_; }
+
+		virtual Vec3 GetContactForce() const override { return contact_force_; }
+		virtual Vec3 GetContactMoment() const override { return Vec3::zero(); }
+		virtual Vec3 GetContactPoint() const override { return contact_point_; }
+
+		virtual void SetExternalForce( const Vec3& force ) override { ext_force_ = force; }
+		virtual void SetExternalForceAtPoint( const Vec3& force, const Vec3& point ) override { ext_force_ = force; ext_point_ = point; }
+		virtual void SetExternalMoment( const Vec3& torque ) override { ext_moment_ = torque; }
+		virtual void AddExternalForce( const Vec3& f ) override { ext_force_ += f; }
+		virtual void AddExternalMoment( const Vec3& torque ) override { ext_moment_ += torque; }
+
+		virtual Vec3 GetExternalForce() const override { return ext_force_; }
+		virtual Vec3 GetExternalForcePoint() const override { return ext_point_; }
+		virtual Vec3 GetExternalMoment() const override { return ext_moment_; }
+
+		virtual const Model& GetModel() const override;
+		virtual Model& GetModel() override;
+
+	private:
+		friend class SyntheticModel;
+		Vec3 Rotate( const Vec3& v ) const;
+		void UpdateKinematics( Real angle, double dt, bool reset );
+
+		SyntheticModel& model_;
+		String name_;
+		Real mass_;
+		Vec3 joint_ofs_; // joint position in parent frame
+		Vec3 local_com_;
+
+		Vec3 pos_, vel_, acc_;
+		Vec3 com_pos_, com_vel_, com_acc_;
+		Real angle_ = 0, ang_vel_ = 0, ang_acc_ = 0;
+		Vec3 contact_force_, contact_point_;
+		Vec3 ext_force_, ext_point_, ext_moment_;
+	};
+
+	/// Joint between two SyntheticBodies.
+	class SyntheticJoint : public Joint
+	{
+	public:
+		SyntheticJoint( SyntheticBody& body, SyntheticBody& parent_body, const String& name );
+
+		virtual const String& GetName() const override { return name_; }
+		virtual Vec3 GetPos() const override { return m_Body.GetOriginPos(); }
+		virtual Vec3 GetReactionForce() const override;
+
+	private:
+		String name_;
+	};
+
+	/// Degree of freedom following a scripted sine wave trajectory, with optional constant drift velocity.
+	class SyntheticDof : public Dof
+	{
+	public:
+		SyntheticDof( SyntheticModel& model, const String& name, const Joint* joint, Real offset, Real amplitude, Real phase, Real drift = 0 );
+
+		virtual const String& GetName() const override { return name_; }
+		virtual Real GetPos() const override { return pos_; }
+		virtual Real GetVel() const override { return vel_; }
+		virtual Real GetLimitForce() const override { return 0; }
+		virtual Real GetMoment() const override;
+
+		virtual void SetPos( Real pos, bool enforce_constraints = true ) override { pos_ = pos; }
+		virtual void SetVel( Real vel ) override { vel_ = vel; }
+
+		virtual Vec3 GetRotationAxis() const override { return Vec3::unit_z(); }
+		virtual Range< Real > GetRange() const override { return Range< Real >( offset_ - 2 * amplitude_, offset_ + 2 * amplitude_ ); }
+
+	private:
+		friend class SyntheticModel;
+		void UpdateKinematics( double time, Real frequency );
+
+		SyntheticModel& model_;
+		String name_;
+		Real offset_, amplitude_, phase_, drift_;
+		Real pos_ = 0, vel_ = 0;
+	};
+
+	/// Muscle with rigid tendon, first-order activation dynamics and constant moment arms.
+	class SyntheticMuscle : public Muscle
+	{
+	public:
+		SyntheticMuscle( SyntheticModel& model, const String& name, const Body& origin, const Body& insertion,
+			std::vector< std::pair< const Dof*, Real > > moment_arms, Real max_isometric_force );
+
+		virtual const String& GetName() const override { return name_; }
+		virtual const Body& GetOriginBody() const override { return origin_; }
+		virtual const Body& GetInsertionBody() const override { return insertion_; }
+		virtual const Model& GetModel() const override;
+
+		virtual Real GetMomentArm( const Dof& dof ) const override;
+
+		virtual Real GetMaxIsometricForce() const override { return max_isometric_force_; }
+		virtual Real GetOptimalFiberLength() const override { return optimal_fiber_length_; }
+		virtual Real GetTendonSlackLength() const override { return tendon_slack_length_; }
+
+		virtual Real GetForce() const override { return GetFiberForce(); }
+		virtual Real GetNormalizedForce() const override { return GetForce() / max_isometric_force_; }
+
+		virtual Real GetLength() const override;
+		virtual Real GetVelocity() const override;
+
+		virtual Real GetFiberForce() const override { return GetActiveFiberForce() + GetPassiveFiberForce(); }
+		virtual Real GetActiveFiberForce() const override;
+		virtual Real GetPassiveFiberForce() const override;
+
+		virtual Real GetFiberLength() const override { return GetLength() - tendon_slack_length_; }
+		virtual Real GetNormalizedFiberLength() const override { return GetFiberLength() / optimal_fiber_length_; }
+		virtual Real GetCosPennationAngle() const override { return 1; }
+		virtual Real GetFiberVelocity() const override { return GetVelocity(); }
+		virtual Real GetNormalizedFiberVelocity() const override { return GetFiberVelocity() / ( optimal_fiber_length_ * GetMaxContractionVelocity() ); }
+
+		virtual Real GetTendonLength() const override { return tendon_slack_length_; }
+		virtual Real GetNormalizedTendonLength() const override { return 1; }
+
+		virtual Real GetActiveForceLengthMultipler() const override;
+		virtual Real GetMaxContractionVelocity() const override { return 10; }
+
+		virtual std::vector< Vec3 > GetMusclePath() const override { return { origin_.GetComPos(), insertion_.GetComPos() }; }
+
+		virtual Real GetActivation() const override { return activation_; }
+		virtual Real GetExcitation() const override { return excitation_; }
+		virtual void SetExcitation( Real u ) override { excitation_ = u; }
+
+	private:
+		friend class SyntheticModel;
+		void UpdateActivation( double dt );
+
+		SyntheticModel& model_;
+		String name_;
+		const Body& origin_;
+		const Body& insertion_;
+		std::vector< std::pair< const Dof*, Real > > moment_arms_;
+		Real max_isometric_force_;
+		Real optimal_fiber_length_;
+		Real tendon_slack_length_;
+		Real excitation_ = 0;
+		Real activation_ = 0;
+	};
+
+	/// Contact force with a scripted load pattern.
+	class SyntheticContactForce : public ContactForce
+	{
+	public:
+		SyntheticContactForce( const String& name ) : name_( name ) {}
+
+		virtual const String& GetName() const override { return name_; }
+		virtual const Vec3& GetForce() const override { return force_; }
+		virtual const Vec3& GetMoment() const override { return moment_; }
+		virtual const Vec3& GetPoint() const override { return point_; }
+
+	private:
+		friend class SyntheticModel;
+		String name_;
+		Vec3 force_, moment_, point_;
+	};
+
+	/// Lightweight Model without physics engine, for benchmarking controllers, measures, sensors and storage.
+	/** The model consists of a pelvis with any number of legs, each with a chain of bodies that have one rotational
+	degree of freedom per joint. Joint angles follow deterministic sine waves, and the foot of each leg is loaded
+	alternately. Muscles have constant moment arms and produce forces that depend on activation and length, but do
+	not influence the motion. */
+	class SyntheticModel : public Model
+	{
+	public:
+		SyntheticModel( const PropNode& props, Params& par );
+		virtual ~SyntheticModel();
+
+		/// Number of legs; default = 2.
+		size_t legs;
+
+		/// Number of degrees of freedom per leg, each with a joint and a body; default = 3.
+		size_t leg_dofs;
+
+		/// Number of muscles per leg; default = 8.
+		size_t leg_muscles;
+
+		/// Number of bodies attached to the pelvis that have no degrees of freedom; default = 1.
+		size_t extra_bodies;
+
+		/// Frequency [Hz] of the scripted motion; default = 1.
+		Real frequency;
+
+		/// Amplitude [rad] of the scripted joint angles; default = 0.4.
+		Real amplitude;
+
+		/// Forward velocity [m/s] of the pelvis; default = 1.2.
+		Real velocity;
+
+		virtual const String& GetName() const override { return name_; }
+
+		virtual TimeInSeconds GetTime() const override { return time_; }
+		virtual int GetIntegrationStep() const override { return step_; }
+		virtual int GetPreviousIntegrationStep() const override { return prev_step_; }
+		virtual TimeInSeconds GetPreviousTime() const override { return prev_time_; }
+		virtual TimeInSeconds GetSimulationStepSize() override { return fixed_control_step_size; }
+
+		virtual const State& GetState() const override { return state_; }
+		virtual void SetState( const State& state, TimeInSeconds timestamp ) override;
+		virtual void SetStateValues( const std::vector< Real >& state, TimeInSeconds timestamp ) override;
+
+		virtual void AdvanceSimulationTo( double time ) override;
+		virtual double GetSimulationEndTime() const override { return end_time_; }
+		virtual void SetSimulationEndTime( double time ) override { end_time_ = time; }
+		virtual std::vector<std::pair<String, std::pair<xo::time, size_t>>> GetBenchmarks() const override;
+
+		virtual Vec3 GetComPos() const override;
+		virtual Vec3 GetComVel() const override;
+		virtual Vec3 GetComAcc() const override;
+		virtual Vec3 GetLinMom() const override { return GetMass() * GetComVel(); }
+		virtual Vec3 GetAngMom() const override;
+
+		virtual Real GetMass() const override { return mass_; }
+		virtual Vec3 GetGravity() const override { return Vec3( 0, -9.81, 0 ); }
+
+	private:
+		void UpdateKinematics( double dt, bool reset );
+		void UpdateStateFromModel();
+
+		String name_;
+		double time_, prev_time_, end_time_;
+		int step_, prev_step_;
+		Real mass_;
+		State state_;
+		std::vector< std::pair< SyntheticBody*, const SyntheticDof* > > body_dofs_; // in order of kinematic chain
+		std::vector< SyntheticBody* > feet_;
+		std::vector< SyntheticContactForce* > contact_forces_;
+
+		struct Timing { xo::time total; size_t count = 0; };
+		Timing t_sim_, t_model_, t_controls_, t_sensors_, t_analyses_, t_store_;
+	};
+}
@@ -0,0 +1,235 @@
+/*
+** sconebench.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include <tclap/CmdLine.h>
+#include "SyntheticModel.h"
+#include "scone/core/Benchmark.h"
+#include "scone/core/Exception.h"
+#include "scone/core/Factories.h"
+#include "scone/core/Log.h"
+#include "scone/core/PerfCounters.h"
+#include "scone/core/version.h"
+#include "scone/model/Side.h"
+#include "scone/optimization/Params.h"
+#include "scone/sconelib_config.h"
+#include "xo/filesystem/filesystem.h"
+#include "xo/serialization/prop_node_serializer_zml.h"
+#include "xo/string/pattern_matcher.h"
+#include "xo/system/log_sink.h"
+#include "xo/system/system_tools.h"
+#include "xo/system/error_code.h"
+#include "xo/time/timer.h"
+#include <sstream>
+
+using namespace scone;
+
+// benchmark components, each runs on the same synthetic model
+struct BenchmarkDef {
+	const char* name;
+	const char* zml;
+	bool store_data;
+};
+
+static const BenchmarkDef g_Benchmarks[] = {
+	{ "NeuralController", R"(
+		NeuralController {
+			SensorNeuronLayer {
+				SensorNeuron { type = F source = * delay = 0.02 }
+				SensorNeuron { type = L source = * offset = 1 delay = 0.02 }
+				SensorNeuron { type = DPV source = pelvis_tilt delay = 0.01 }
+			}
+			MotorNeuronLayer {
+				MotorNeuron { include = * offset = ~0.01<0,1> }
+				MotorNeuron { input_layer = 0 connect = synergetic_dof type = F gain = ~0.1<-10,10> }
+				MotorNeuron { input_layer = 0 connect = synergetic_dof type = L gain = ~0.1<-10,10> }
+				MotorNeuron { input_layer = 0 connect = ipsilateral type = DPV gain = ~0.1<-10,10> }
+			}
+		})", false },
+	{ "ReflexController", R"(
+		ReflexController {
+			MuscleReflex { target = muscle0 delay = 0.02 KL = ~1.1<-10,10> L0 = ~0.7<0,2> }
+			MuscleReflex { target = muscle1 source = muscle2 delay = 0.02 KF = ~0.3<-10,10> }
+			MuscleReflex { target = muscle3 delay = 0.01 KV = ~0.2<-10,10> C0 = ~0.05<0,1> }
+			MuscleReflex { target = muscle4 delay = 0.01 KF = ~1.2<-10,10> KL = ~0.5<-10,10> }
+			DofReflex { target = muscle5 source = pelvis_tilt delay = 0.005 KP = ~1<-10,10> KV = ~0.1<-10,10> }
+			DofReflex { target = muscle6 source = pelvis_tilt delay = 0.005 KP = ~-1<-10,10> KV = ~-0.1<-10,10> }
+		})", false },
+	{ "GaitStateController", R"(
+		GaitStateController {
+			stance_load_threshold = ~0.1<0.001,1>
+			ConditionalControllers {
+				ConditionalController {
+					states = "EarlyStance LateStance"
+					ReflexController {
+						MuscleReflex { target = muscle0 delay = 0.02 KF = ~1.0<-10,10> }
+						MuscleReflex { target = muscle1 delay = 0.02 KL = ~0.5<-10,10> L0 = ~0.7<0,2> }
+					}
+				}
+				ConditionalController {
+					states = "Liftoff Swing Landing"
+					ReflexController {
+						MuscleReflex { target = muscle2 delay = 0.01 KL = ~1.0<-10,10> L0 = ~0.8<0,2> }
+						DofReflex { target = muscle3 source = pelvis_tilt delay = 0.005 KP = ~1<-10,10> }
+					}
+				}
+			}
+		})", false },
+	{ "Measures", R"(
+		CompositeMeasure {
+			GaitMeasure { termination_height = 0.5 min_velocity = 0.5 }
+			EffortMeasure { measure_type = Wang2012 use_cost_of_transport = 1 }
+			DofMeasure { dof = dof0_r position { min = -60 max = 60 squared_penalty = 1 } }
+			DofMeasure { dof = dof1_l position { min = -60 max = 60 squared_penalty = 1 } }
+		})", false },
+	{ "Storage", "", true },
+};
+
+// parse ZML from a string
+PropNode parse_zml( const String& zml )
+{
+	PropNode pn;
+	xo::error_code ec;
+	std::istringstream str( zml );
+	xo::prop_node_serializer_zml reader( pn, &ec );
+	str >> reader;
+	SCONE_ERROR_IF( !ec.good(), "Error parsing benchmark: " + ec.message() );
+	return pn;
+}
+
+// neural delays for all muscles and dofs of a model
+PropNode get_neural_delays( const Model& model )
+{
+	PropNode pn;
+	for ( auto& m : model.GetMuscles() )
+		pn.set( GetNameNoSide( m->GetName() ), 0.02 );
+	for ( auto& d : model.GetDofs() )
+		pn.set( GetNameNoSide( d->GetName() ), 0.01 );
+	return pn;
+}
+
+// main
+int main( int argc, char* argv[] )
+{
+	xo::log::console_sink console_sink( xo::log::level::info );
+	scone::Initialize();
+	GetModelFactory().register_type< SyntheticModel >( "SyntheticModel" );
+	int exit_code = 0;
+
+	try
+	{
+		TCLAP::CmdLine cmd( "SCONE Benchmark Utility", ' ', xo::to_str( scone::GetSconeVersion() ), true );
+		TCLAP::ValueArg< int > samplesArg( "x", "samples", "Number of samples per benchmark", false, 8, ">0", cmd );
+		TCLAP::ValueArg< double > durationArg( "d", "duration", "Simulation duration per sample [s]", false, 2.0, ">0", cmd );
+		TCLAP::ValueArg< int > musclesArg( "", "muscles", "Number of muscles per leg", false, 8, ">0", cmd );
+		TCLAP::ValueArg< int > dofsArg( "", "dofs", "Number of degrees of freedom per leg", false, 3, ">0", cmd );
+		TCLAP::ValueArg< int > bodiesArg( "", "bodies", "Number of additional bodies without degrees of freedom", false, 1, ">=0", cmd );
+		TCLAP::ValueArg< String > perfArg( "", "perf", "Folder for baseline statistics", false, "perf", "folder", cmd );
+		TCLAP::ValueArg< String > outArg( "r", "result", "Output file for benchmark results (*.zml, *.json)", false, "", "file", cmd );
+		TCLAP::ValueArg< String > compareArg( "", "compare", "Compare to previous results; exit code is 1 if a component has regressed", false, "", "*.zml|*.json", cmd );
+		TCLAP::SwitchArg perfCountersArg( "", "perf-counters", "Include hardware performance counters in benchmark results (Linux only)", cmd, false );
+		TCLAP::ValueArg< double > thresholdArg( "", "threshold", "Number of standard deviations after which a component has regressed", false, 3.0, ">0", cmd );
+		TCLAP::UnlabeledValueArg< String > filterArg( "filter", "Pattern of benchmarks to run", false, "*", "pattern", cmd );
+		cmd.parse( argc, argv );
+
+		try
+		{
+			PropNode model_pn;
+			model_pn.set( "leg_muscles", musclesArg.getValue() );
+			model_pn.set( "leg_dofs", dofsArg.getValue() );
+			model_pn.set( "extra_bodies", bodiesArg.getValue() );
+
+			auto samples = size_t( samplesArg.getValue() );
+			auto duration = durationArg.getValue();
+			xo::pattern_matcher filter( filterArg.getValue() );
+			BenchmarkSamples bm_samples;
+			PropNode perf_counters;
+			for ( auto& bm : g_Benchmarks )
+			{
+				if ( !filter( bm.name ) )
+					continue;
+
+				log::info( "Running ", bm.name );
+				auto props = model_pn;
+				for ( auto& [key, child] : parse_zml( bm.zml ) )
+				{
+					auto& child_pn = props.add_child( key, child );
+					if ( key == "NeuralController" )
+					{
+						// delays are taken from a model without controllers
+						ObjectiveInfo delay_info;
+						auto model = CreateModel( FactoryProps{ "SyntheticModel", &model_pn }, delay_info, path() );
+						child_pn.add_child( "neural_delays", get_neural_delays( *model ) );
+					}
+				}
+
+				// first model defines the parameters
+				ObjectiveInfo info;
+				FactoryProps fp{ "SyntheticModel", &props };
+				CreateModel( fp, info, path() );
+
+				PerfCounterPhases bm_counters;
+				for ( index_t idx = 0; idx < samples; ++idx )
+				{
+					SearchPoint par( info );
+					xo::timer t;
+					auto model = CreateModel( fp, par, path() );
+					bm_samples[ String( bm.name ) + ".Create" ].push_back( t() );
+					model->SetStoreData( bm.store_data );
+					model->SetSimulationEndTime( duration );
+					model->SetPerfCounters( perfCountersArg.getValue() );
+					model->AdvanceSimulationTo( duration );
+					for ( const auto& [name, timing] : model->GetBenchmarks() )
+						bm_samples[ String( bm.name ) + "." + name ].push_back( timing.first / timing.second );
+					if ( auto* pc = model->GetPerfCounters() )
+						bm_counters.Merge( *pc );
+				}
+				if ( !bm_counters.IsEmpty() )
+				{
+					bm_counters.LogReport( samples * duration );
+					perf_counters.add_child( bm.name, bm_counters.GetReport( samples * duration ) );
+				}
+			}
+			SCONE_ERROR_IF( bm_samples.empty(), "No benchmarks matching " + filterArg.getValue() );
+
+			auto baseline_file = path( perfArg.getValue() ) / xo::get_computer_name() / "sconebench.stats";
+			xo::create_directories( baseline_file.parent_path() );
+			auto results = GetBenchmarkSystemInfo();
+			results.set( "benchmark", "sconebench" );
+			results.set( "samples", samples );
+			results.set( "simulation_time", duration );
+			results.add_child( "components", ProcessBenchmarks( bm_samples, baseline_file, xo::time_from_seconds( duration ) ) );
+			if ( perf_counters.size() > 0 )
+				results.add_child( "perf_counters", perf_counters );
+
+			if ( outArg.isSet() )
+				SaveBenchmarkResults( results, path( outArg.getValue() ) );
+			if ( compareArg.isSet() )
+			{
+				log::info( "Comparing to ", compareArg.getValue() );
+				auto baseline = LoadBenchmarkResults( path( compareArg.getValue() ) );
+				auto regressions = FindBenchmarkRegressions( baseline, results, thresholdArg.getValue() );
+				if ( !regressions.empty() )
+				{
+					log::error( regressions.size(), " component(s) have regressed" );
+					exit_code = 1;
+				}
+			}
+		}
+		catch ( std::exception& e )
+		{
+			log::critical( e.what() );
+			return -1;
+		}
+	}
+	catch ( TCLAP::ExitException& e )
+	{
+		return e.getExitStatus();
+	}
+
+	return exit_code;
+}
@@ -12,6 +12,7 @@
 #include "scone/core/Log.h"
 #include "scone/core/version.h"
 #include "scone/optimization/opt_tools.h"
+#include "scone/optimization/NetworkEvaluator.h"
 #include "scone/sconelib_config.h"
 #include "spot/optimizer_pool.h"
 #include "xo/container/prop_node_tools.h"
@@ -20,6 +21,9 @@
 #include "xo/system/log_sink.h"
 #include "xo/system/system_tools.h"
 #include "scone/core/Benchmark.h"
+#include <fstream>
+#include <iostream>
+#include <thread>
 
 using namespace scone;
 
@@ -39,6 +43,7 @@ int main(int argc, char* argv[])
 {
 	xo::log::console_sink console_sink( xo::log::level::info );
 	scone::Initialize();
+	int exit_code = 0;
 
 	try
 	{
@@ -46,14 +51,22 @@ int main(int argc, char* argv[])
 		TCLAP::ValueArg< String > optArg( "o", "optimize", "Optimize a scenario file", true, "", "*.scone" );
 		TCLAP::ValueArg< String > parArg( "e", "evaluate", "Evaluate a result from an optimization", false, "", "*.par" );
 		TCLAP::ValueArg< String > benchArg( "b", "benchmark", "Benchmark a scenario or parameter file", false, "", "*.scone" );
+		TCLAP::ValueArg< String > workerArg( "", "worker", "Evaluate for a remote optimization, using an address from optimizer.network_address and the token from optimizer.network_token", false, "", "host:port" );
+		TCLAP::ValueArg< String > batchArg( "", "batch", "Evaluate multiple results in parallel: a directory (last .par of each folder), wildcard pattern or file list", false, "", "folder|pattern|list" );
+		TCLAP::ValueArg< String > resumeArg( "", "resume", "Resume an optimization from the checkpoint in its output folder", false, "", "folder" );
 		TCLAP::ValueArg< int > bxArg( "x", "benchmarkx", "Number of benchmarks to perform", false, 8, ">0", cmd );
-		TCLAP::ValueArg< String > outArg( "r", "result", "Output file for evaluation result", false, "", "Output file (*.sto)", cmd );
+		TCLAP::ValueArg< String > outArg( "r", "result", "Output file for evaluation result or benchmark results (*.zml, *.json)", false, "", "Output file (*.sto)", cmd );
+		TCLAP::ValueArg< int > threadsArg( "j", "threads", "Number of threads for batch evaluation, or maximum number of threads for scaling benchmark (0=hardware)", false, 0, ">=0", cmd );
+		TCLAP::ValueArg< String > benchCompareArg( "", "benchmark-compare", "Compare benchmark to previous results; exit code is 1 if a component has regressed", false, "", "*.zml|*.json", cmd );
+		TCLAP::ValueArg< double > benchThresholdArg( "", "benchmark-threshold", "Number of standard deviations after which a benchmark component has regressed", false, 3.0, ">0", cmd );
+		TCLAP::SwitchArg scalingArg( "", "scaling", "Benchmark evaluation throughput at 1, 2, 4, ... threads", cmd, false );
+		TCLAP::SwitchArg perfCountersArg( "", "perf-counters", "Include hardware performance counters in benchmark results (Linux only)", cmd, false );
 		TCLAP::ValueArg< int > logArg( "l", "log", "Set the log level", false, 1, "1-7", cmd );
 		TCLAP::SwitchArg statusOutput( "s", "status", "Output full status updates", cmd, false );
 		TCLAP::SwitchArg quietOutput( "q", "quiet", "Do not output simulation progress", cmd, false );
 		TCLAP::UnlabeledMultiArg< string > propArg( "property", "Override specific scenario property, using <key>=<value>", false, "<key>=<value>", cmd, true );
 
-		auto xor_args = std::vector<TCLAP::Arg*>{ &optArg, &parArg , &benchArg };
+		auto xor_args = std::vector<TCLAP::Arg*>{ &optArg, &parArg , &benchArg, &resumeArg, &workerArg, &batchArg };
 		cmd.xorAdd( xor_args );
 		cmd.parse( argc, argv );
 
@@ -64,12 +77,15 @@ int main(int argc, char* argv[])
 				console_sink.set_log_level( xo::log::level( logArg.getValue() ) );
 
 			// do optimization or evaluation
-			if ( optArg.isSet() )
+			if ( optArg.isSet() || resumeArg.isSet() )
 			{
-				path scenario_file = FindScenario( optArg.getValue() );
+				path resume_folder = resumeArg.isSet() ? path( resumeArg.getValue() ) : path();
+				path scenario_file = resumeArg.isSet() ? resume_folder / "config.scone" : FindScenario( optArg.getValue() );
 				auto scenario_pn = load_scenario( scenario_file, propArg );
 				OptimizerUP o = CreateOptimizer( scenario_pn, scenario_file.parent_path() );
 				LogUnusedProperties( scenario_pn );
+				if ( resumeArg.isSet() )
+					o->SetResumeFolder( resume_folder );
 				if ( statusOutput.getValue() )
 					o->SetOutputMode( Optimizer::status_console_output );
 				else o->SetOutputMode( quietOutput.getValue() ? Optimizer::no_output : Optimizer::console_output );
@@ -88,12 +104,46 @@ int main(int argc, char* argv[])
 				if ( propArg.isSet() && outArg.isSet() )
 					save_file( scenario_pn, out_path.replace_extension( "scone" ) );
 			}
+			else if ( batchArg.isSet() )
+			{
+				auto par_files = FindParFiles( batchArg.getValue() );
+				auto num_threads = threadsArg.getValue() > 0 ? size_t( threadsArg.getValue() ) : std::max( 1u, std::thread::hardware_concurrency() );
+				auto results = EvaluateParFiles( par_files, [&]( const path& f ) { return load_scenario( f, propArg ); }, num_threads );
+
+				// write summary table
+				if ( outArg.isSet() )
+				{
+					std::ofstream str( outArg.getValue() );
+					WriteEvaluationSummary( results, str );
+					log::info( "Summary written to ", outArg.getValue() );
+				}
+				else WriteEvaluationSummary( results, std::cout );
+			}
+			else if ( workerArg.isSet() )
+			{
+				RunEvaluationWorker( workerArg.getValue() );
+			}
 			else if ( benchArg.isSet() )
 			{
 				path scenario_file = FindScenario( benchArg.getValue() );
 				auto scenario_pn = load_scenario( scenario_file, propArg );
 				log::info( "Benchmarking ", benchArg.getValue() );
-				BenchmarkScenario( scenario_pn, path( benchArg.getValue() ), bxArg.getValue() );
+				auto results = scalingArg.getValue()
+					? BenchmarkScenarioScaling( scenario_pn, path( benchArg.getValue() ), bxArg.getValue(), size_t( threadsArg.getValue() ) )
+					: BenchmarkScenario( scenario_pn, path( benchArg.getValue() ), bxArg.getValue(), perfCountersArg.getValue() );
+				if ( outArg.isSet() )
+					SaveBenchmarkResults( results, path( outArg.getValue() ) );
+				if ( benchCompareArg.isSet() )
+				{
+					log::info( "Comparing to ", benchCompareArg.getValue() );
+					auto baseline = LoadBenchmarkResults( path( benchCompareArg.getValue() ) );
+					auto regressions = FindBenchmarkRegressions( baseline, results, benchThresholdArg.getValue() );
+					if ( !regressions.empty() )
+					{
+						log::error( regressions.size(), " component(s) have regressed" );
+						exit_code = 1;
+					}
+				}
 			}
 		}
 		catch ( std::exception& e )
@@ -117,5 +167,5 @@ int main(int argc, char* argv[])
 		return e.getExitStatus();
 	}
 
-	return 0;
+	return exit_code;
 }
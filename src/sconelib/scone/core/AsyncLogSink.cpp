@@ -0,0 +1,226 @@
+/*
+** AsyncLogSink.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "AsyncLogSink.h"
+
+#include "Exception.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scone
+{
+	// message submitted by an AsyncLogSink, with the id of the sink
+	struct LogRecord {
+		uint64_t target;
+		String text;
+	};
+
+	// ring buffer with a single producer (the owning thread) and a single consumer (the writer thread)
+	struct LogQueue {
+		LogQueue( size_t capacity ) : records( capacity ), head( 0 ), tail( 0 ), closed( false ) {}
+
+		bool Push( LogRecord&& r ) {
+			auto h = head.load( std::memory_order_relaxed );
+			if ( h - tail.load( std::memory_order_acquire ) >= records.size() )
+				return false;
+			records[ h % records.size() ] = std::move( r );
+			head.store( h + 1, std::memory_order_release );
+			return true;
+		}
+
+		template< typename F > void Drain( F f ) {
+			auto t = tail.load( std::memory_order_relaxed );
+			auto h = head.load( std::memory_order_acquire );
+			for ( ; t != h; ++t )
+				f( records[ t % records.size() ] );
+			tail.store( t, std::memory_order_release );
+		}
+
+		bool IsEmpty() const { return head.load( std::memory_order_acquire ) == tail.load( std::memory_order_relaxed ); }
+
+		std::vector< LogRecord > records;
+		std::atomic< size_t > head;
+		std::atomic< size_t > tail;
+		std::atomic_bool closed;
+	};
+
+	// file of an AsyncLogSink, only written by the writer thread after creation
+	struct LogOutput {
+		uint64_t id;
+		std::ofstream str;
+	};
+
+	// queues of all threads and the writer thread, shared by all AsyncLogSinks
+	class AsyncLogWriter
+	{
+	public:
+		static AsyncLogWriter& GetInstance() {
+			static AsyncLogWriter g_Instance;
+			return g_Instance;
+		}
+
+		~AsyncLogWriter() {
+			if ( thread_.joinable() )
+			{
+				{
+					std::scoped_lock lock( mutex_ );
+					stop_ = true;
+				}
+				cv_.notify_all();
+				thread_.join();
+			}
+		}
+
+		uint64_t AddOutput( const path& file, bool append ) {
+			auto mode = append ? std::ios::app : std::ios::out;
+			auto output = std::make_shared< LogOutput >( LogOutput{ 0, std::ofstream( file.str(), mode ) } );
+			SCONE_ERROR_IF( !output->str.good(), "Could not open " + file.str() );
+
+			std::scoped_lock lock( mutex_ );
+			output->id = ++last_id_;
+			outputs_.push_back( std::move( output ) );
+			if ( !thread_.joinable() )
+				thread_ = std::thread( [this]() { Run(); } );
+			return last_id_;
+		}
+
+		void RemoveOutput( uint64_t id ) {
+			Flush();
+			{
+				std::scoped_lock lock( mutex_ );
+				outputs_.erase( std::remove_if( outputs_.begin(), outputs_.end(), [&]( auto& o ) { return o->id == id; } ), outputs_.end() );
+			}
+			// the file is closed when the writer releases its copy of the outputs
+			Flush();
+		}
+
+		void Submit( LogRecord&& r ) {
+			if ( !GetThreadQueue().Push( std::move( r ) ) )
+				dropped_.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+		void Flush() {
+			std::unique_lock lock( mutex_ );
+			if ( !thread_.joinable() )
+				return;
+			auto request = ++flush_requested_;
+			cv_.notify_all();
+			cv_.wait( lock, [&]() { return flush_done_ >= request; } );
+		}
+
+		size_t GetDroppedCount() const { return dropped_; }
+
+	private:
+		AsyncLogWriter() : last_id_( 0 ), flush_requested_( 0 ), flush_done_( 0 ), stop_( false ), dropped_( 0 ) {}
+
+		// the queue is closed when its thread exits, and removed by the writer once it is empty
+		struct ThreadQueue {
+			std::shared_ptr< LogQueue > queue;
+			~ThreadQueue() { if ( queue ) queue->closed = true; }
+		};
+
+		LogQueue& GetThreadQueue() {
+			static thread_local ThreadQueue t_Queue;
+			if ( !t_Queue.queue )
+			{
+				t_Queue.queue = std::make_shared< LogQueue >( 1024 );
+				std::scoped_lock lock( mutex_ );
+				queues_.push_back( t_Queue.queue );
+			}
+			return *t_Queue.queue;
+		}
+
+		void Run() {
+			std::unique_lock lock( mutex_ );
+			while ( true )
+			{
+				// files are written without holding mutex_, so that submitting threads are never blocked by file output
+				auto stop = stop_;
+				auto request = flush_requested_;
+				auto queues = queues_;
+				auto outputs = outputs_;
+				lock.unlock();
+				WriteQueued( queues, outputs );
+				queues.clear();
+				outputs.clear();
+				lock.lock();
+
+				queues_.erase( std::remove_if( queues_.begin(), queues_.end(), []( auto& q ) { return q->closed && q->IsEmpty(); } ), queues_.end() );
+				flush_done_ = request;
+				cv_.notify_all();
+				if ( stop )
+					break;
+				cv_.wait_for( lock, std::chrono::milliseconds( 20 ), [&]() { return stop_ || flush_requested_ != flush_done_; } );
+			}
+		}
+
+		// called by the writer thread only
+		static void WriteQueued( const std::vector< std::shared_ptr< LogQueue > >& queues, const std::vector< std::shared_ptr< LogOutput > >& outputs ) {
+			bool written = false;
+			for ( auto& q : queues )
+				q->Drain( [&]( LogRecord& r ) {
+					for ( auto& o : outputs )
+						if ( o->id == r.target )
+							o->str << r.text << '\n';
+					written = true;
+				} );
+			if ( written )
+				for ( auto& o : outputs )
+					o->str.flush();
+		}
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::thread thread_;
+		std::vector< std::shared_ptr< LogQueue > > queues_;
+		std::vector< std::shared_ptr< LogOutput > > outputs_;
+		uint64_t last_id_;
+		uint64_t flush_requested_;
+		uint64_t flush_done_;
+		bool stop_;
+		std::atomic< size_t > dropped_;
+	};
+
+	AsyncLogSink::AsyncLogSink( const path& file, xo::log::level l, xo::log::sink_mode m, bool append ) :
+		xo::log::sink( l, m ),
+		id_( AsyncLogWriter::GetInstance().AddOutput( file, append ) ),
+		dropped_at_start_( AsyncLogWriter::GetInstance().GetDroppedCount() )
+	{}
+
+	AsyncLogSink::~AsyncLogSink()
+	{
+		AsyncLogWriter::GetInstance().RemoveOutput( id_ );
+
+		// the sink is removed first, so that the warning goes to the remaining sinks
+		if ( auto dropped = AsyncLogWriter::GetInstance().GetDroppedCount() - dropped_at_start_; dropped > 0 )
+			log::warning( dropped, " log messages were dropped because a log queue was full" );
+	}
+
+	void AsyncLogSink::submit_msg( xo::log::level l, const xo::string& msg )
+	{
+		AsyncLogWriter::GetInstance().Submit( LogRecord{ id_, msg } );
+	}
+
+	void AsyncLogSink::flush()
+	{
+		AsyncLogWriter::GetInstance().Flush();
+	}
+
+	size_t AsyncLogSink::GetDroppedCount()
+	{
+		return AsyncLogWriter::GetInstance().GetDroppedCount();
+	}
+}
@@ -0,0 +1,40 @@
+/*
+** AsyncLogSink.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+#include "xo/system/log_sink.h"
+#include "xo/filesystem/path.h"
+
+#include <cstdint>
+
+namespace scone
+{
+	/// Log sink that writes to a file from a separate writer thread.
+	/** Messages are added to a lock-free queue of the submitting thread and written by a single
+	writer thread, which is shared by all AsyncLogSinks. If a queue is full, messages are dropped
+	instead of blocking the submitting thread. Use flush() to wait until all messages are written. */
+	class SCONE_API AsyncLogSink : public xo::log::sink
+	{
+	public:
+		AsyncLogSink( const xo::path& file, xo::log::level l = xo::log::level::info, xo::log::sink_mode m = xo::log::sink_mode::all_threads, bool append = false );
+		virtual ~AsyncLogSink();
+
+		virtual void submit_msg( xo::log::level l, const xo::string& msg ) override;
+		virtual void flush() override;
+
+		/// Total number of messages dropped because a queue was full, for all AsyncLogSinks.
+		static size_t GetDroppedCount();
+
+	private:
+		uint64_t id_;
+		size_t dropped_at_start_;
+	};
+}
@@ -0,0 +1,97 @@
+/*
+** AsyncOutputWriter.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "AsyncOutputWriter.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace scone
+{
+	AsyncOutputWriter::AsyncOutputWriter( size_t max_queue_size ) :
+		max_queue_size_( std::max< size_t >( max_queue_size, 1 ) ),
+		written_( 0 ),
+		coalesced_( 0 ),
+		busy_( false ),
+		stop_( false )
+	{}
+
+	AsyncOutputWriter::~AsyncOutputWriter()
+	{
+		{
+			std::scoped_lock lock( mutex_ );
+			stop_ = true;
+		}
+		cv_.notify_all();
+		if ( thread_.joinable() )
+			thread_.join();
+	}
+
+	void AsyncOutputWriter::Enqueue( const String& key, Job job )
+	{
+		std::unique_lock lock( mutex_ );
+		auto find_key = [&]() { return std::find_if( queue_.begin(), queue_.end(), [&]( const Entry& e ) { return e.key == key; } ); };
+		cv_.wait( lock, [&]() { return queue_.size() < max_queue_size_ || find_key() != queue_.end(); } );
+		if ( auto it = find_key(); it != queue_.end() )
+		{
+			// the queued job has not started yet, so it is superseded
+			it->job = std::move( job );
+			++coalesced_;
+			return;
+		}
+
+		queue_.push_back( Entry{ key, std::move( job ) } );
+		if ( !thread_.joinable() )
+			thread_ = std::thread( [this]() { Run(); } );
+		lock.unlock();
+		cv_.notify_all();
+	}
+
+	void AsyncOutputWriter::Flush()
+	{
+		std::unique_lock lock( mutex_ );
+		cv_.wait( lock, [&]() { return queue_.empty() && !busy_; } );
+	}
+
+	size_t AsyncOutputWriter::GetWrittenCount() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return written_;
+	}
+
+	size_t AsyncOutputWriter::GetCoalescedCount() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return coalesced_;
+	}
+
+	void AsyncOutputWriter::Run()
+	{
+		std::unique_lock lock( mutex_ );
+		while ( true )
+		{
+			cv_.wait( lock, [&]() { return stop_ || !queue_.empty(); } );
+			if ( queue_.empty() )
+				break; // stop requested and all jobs are done
+
+			auto job = std::move( queue_.front().job );
+			queue_.pop_front();
+			busy_ = true;
+			lock.unlock();
+			cv_.notify_all();
+
+			try { job(); }
+			catch ( std::exception& e ) { log::error( "Error writing output: ", e.what() ); }
+
+			lock.lock();
+			busy_ = false;
+			++written_;
+			cv_.notify_all();
+		}
+	}
+}
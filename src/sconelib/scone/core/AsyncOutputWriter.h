@@ -0,0 +1,59 @@
+/*
+** AsyncOutputWriter.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace scone
+{
+	/// Runs file output jobs on a dedicated thread, so that writing does not block the caller.
+	/** Each job has a key; a queued job that has not started yet is replaced by a newer job with the
+	same key, so that only the latest of a series of superseded results is written. The queue is bounded:
+	when it is full, Enqueue() waits until a job has finished. The thread is started on the first job. */
+	class SCONE_API AsyncOutputWriter
+	{
+	public:
+		using Job = std::function< void() >;
+
+		AsyncOutputWriter( size_t max_queue_size = 16 );
+		~AsyncOutputWriter(); // runs all queued jobs
+
+		void Enqueue( const String& key, Job job );
+
+		/// Wait until all queued jobs have finished.
+		void Flush();
+
+		size_t GetWrittenCount() const;
+		size_t GetCoalescedCount() const;
+
+	private:
+		void Run();
+
+		struct Entry {
+			String key;
+			Job job;
+		};
+		std::deque< Entry > queue_;
+		size_t max_queue_size_;
+		size_t written_;
+		size_t coalesced_;
+		bool busy_;
+		bool stop_;
+		mutable std::mutex mutex_;
+		std::condition_variable cv_;
+		std::thread thread_;
+	};
+}
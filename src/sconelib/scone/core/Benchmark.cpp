@@ -3,8 +3,11 @@
 #include "scone/core/types.h"
 #include "scone/core/Factories.h"
 #include "scone/optimization/Optimizer.h"
+#include "scone/optimization/CmaOptimizerSpot.h"
+#include "scone/optimization/ScheduledEvaluator.h"
 #include "scone/optimization/SimulationObjective.h"
 #include "scone/core/profiler_config.h"
+#include "scone/core/PerfCounters.h"
 
 #include "xo/time/timer.h"
 #include "xo/container/prop_node_tools.h"
@@ -13,10 +16,40 @@
 #include "xo/container/container_algorithms.h"
 #include "xo/time/time.h"
 #include "Log.h"
+#include "Exception.h"
+#include "Settings.h"
+#include "version.h"
+#include "xo/string/string_tools.h"
+#include "xo/serialization/serialize.h"
+#include "spot/async_evaluator.h"
+#include "spot/pooled_evaluator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#	include <psapi.h>
+#elif !defined( __linux__ )
+#	include <sys/resource.h>
+#	ifdef __APPLE__
+#		include <sys/sysctl.h>
+#		include <mach-o/dyld.h>
+#	endif
+#endif
 
 namespace scone
 {
-	void BenchmarkScenario( const PropNode& scenario_pn, const path& file, size_t evals )
+	PropNode BenchmarkScenario( const PropNode& scenario_pn, const path& file, size_t evals, bool perf_counters )
 	{
 		auto opt = CreateOptimizer( scenario_pn, file.parent_path() );
 		auto mo = dynamic_cast<ModelObjective*>( &opt->GetObjective() );
@@ -28,14 +61,16 @@ namespace scone
 			evals *= 4;
 
 		// run simulations
-		xo::flat_map<string, std::vector<xo::time>> bm_components;
-		xo::flat_map<string, std::vector<xo::time>> bm_totals;
+		BenchmarkSamples bm_components;
+		PerfCounterPhases bm_counters;
+		double counters_sim_time = 0.0;
 		xo::time duration;
 		for ( index_t idx = 0; idx < evals; ++idx )
 		{
 			xo::timer t;
 			auto model = mo->CreateModelFromParams( par );
 			model->SetStoreData( false );
+			model->SetPerfCounters( perf_counters );
 			auto create_model_time = t();
 			model->AdvanceSimulationTo( model->GetSimulationEndTime() );
 			auto total_time = t();
@@ -47,9 +82,31 @@ namespace scone
 			if ( !timings.empty() )
 				bm_components[ "EvalSimModel" ].push_back( timings.front().second.first );
 			duration = xo::time_from_seconds( model->GetTime() );
+			if ( auto* pc = model->GetPerfCounters() )
+			{
+				bm_counters.Merge( *pc );
+				counters_sim_time += model->GetTime();
+			}
 			xo::sleep( 100 );
 		}
 
+		auto results = GetBenchmarkSystemInfo();
+		results.set( "scenario", file.str() );
+		results.set( "evaluations", evals );
+		results.set( "simulation_time", duration.seconds() );
+		results.add_child( "components", ProcessBenchmarks( bm_components, baseline_file, duration ) );
+		if ( !bm_counters.IsEmpty() )
+		{
+			bm_counters.LogReport( counters_sim_time );
+			results.add_child( "perf_counters", bm_counters.GetReport( counters_sim_time ) );
+		}
+		return results;
+	}
+
+	PropNode ProcessBenchmarks( const BenchmarkSamples& samples, const path& baseline_file, xo::time sim_duration )
+	{
+		bool has_baseline = xo::file_exists( baseline_file );
+
 		// read baseline
 		xo::flat_map<string, xo::time> baseline_medians;
 		if ( has_baseline )
@@ -68,13 +125,14 @@ namespace scone
 
 		// process
 		std::vector<Benchmark> benchmarks;
-		for ( const auto& bms : bm_components )
+		for ( const auto& bms : samples )
 		{
 			Benchmark bm;
 			bm.name_ = bms.first;
 			bm.time_ = xo::median( bms.second );
 			bm.baseline_ = baseline_medians[ bms.first ];
 			bm.std_ = xo::mean_std( bms.second ).second;
+			bm.samples_ = bms.second.size();
 			benchmarks.push_back( bm );
 		}
 
@@ -88,7 +146,7 @@ namespace scone
 
 			if ( eval )
 				log::message( l, xo::stringf( "%-32s\t%5.0fms\t%+5.0fms\t%+6.2f%%\t%+6.2fS\t%6.2f\t(%.2fx real-time)", bm.name_.c_str(),
-					bm.time_.milliseconds(), bm.diff().milliseconds(), bm.diff_perc(), bm.diff_std(), bm.std_ * 1e-6, duration / bm.time_ ) );
+					bm.time_.milliseconds(), bm.diff().milliseconds(), bm.diff_perc(), bm.diff_std(), bm.std_ * 1e-6, sim_duration / bm.time_ ) );
 			else
 				log::message( l, xo::stringf( "%-32s\t%5.0fns\t%+5.0fns\t%+6.2f%%\t%+6.2fS\t%6.2f", bm.name_.c_str(),
 					bm.time_.nanosecondsd(), bm.diff().nanosecondsd(), bm.diff_perc(), bm.diff_std(), bm.std_ ) );
@@ -102,5 +160,464 @@ namespace scone
 					ostr << xo::stringf( "%-32s\t%8.0f\t%8.2f\n", bm.name_.c_str(), bm.time_.nanosecondsd(), bm.std_ );
 			}
 		}
+
+		// structured results
+		PropNode components;
+		for ( const auto& bm : benchmarks )
+		{
+			auto& c = components.add_child( bm.name_ );
+			c.set( "median_ns", bm.time_.nanosecondsd() );
+			c.set( "std_ns", bm.std_ );
+			c.set( "samples", bm.samples_ );
+			if ( has_baseline )
+				c.set( "baseline_ns", bm.baseline_.nanosecondsd() );
+		}
+		return components;
+	}
+
+	static string GetCpuModel()
+	{
+#if defined( _WIN32 )
+		char name[ 256 ] = "";
+		DWORD size = sizeof( name );
+		if ( RegGetValueA( HKEY_LOCAL_MACHINE, "HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0", "ProcessorNameString", RRF_RT_REG_SZ, nullptr, name, &size ) == ERROR_SUCCESS )
+			return xo::trim_str( name );
+#elif defined( __linux__ )
+		std::ifstream str( "/proc/cpuinfo" );
+		for ( string line; std::getline( str, line ); )
+			if ( xo::str_begins_with( line, "model name" ) )
+				if ( auto pos = line.find( ':' ); pos != string::npos )
+					return xo::trim_str( line.substr( pos + 1 ) );
+#elif defined( __APPLE__ )
+		char name[ 256 ] = "";
+		size_t size = sizeof( name );
+		if ( sysctlbyname( "machdep.cpu.brand_string", name, &size, nullptr, 0 ) == 0 )
+			return name;
+#endif
+		return "unknown";
+	}
+
+	static std::filesystem::path GetExecutablePath()
+	{
+#if defined( _WIN32 )
+		char name[ MAX_PATH ] = "";
+		if ( GetModuleFileNameA( nullptr, name, MAX_PATH ) > 0 )
+			return name;
+#elif defined( __linux__ )
+		std::error_code ec;
+		if ( auto p = std::filesystem::read_symlink( "/proc/self/exe", ec ); !ec )
+			return p;
+#elif defined( __APPLE__ )
+		char name[ 4096 ] = "";
+		uint32_t size = sizeof( name );
+		if ( _NSGetExecutablePath( name, &size ) == 0 )
+			return name;
+#endif
+		return {};
+	}
+
+	// modification time of the running executable, i.e. when it was linked
+	static string GetExecutableDate()
+	{
+		std::error_code ec;
+		auto ftime = std::filesystem::last_write_time( GetExecutablePath(), ec );
+		if ( ec )
+			return "unknown";
+		using namespace std::chrono;
+		auto t = system_clock::to_time_t( time_point_cast<system_clock::duration>( ftime - decltype( ftime )::clock::now() + system_clock::now() ) );
+		char buf[ 32 ] = "";
+		std::strftime( buf, sizeof( buf ), "%Y-%m-%d %H:%M:%S", std::localtime( &t ) );
+		return buf;
+	}
+
+	PropNode GetBenchmarkSystemInfo()
+	{
+		PropNode pn;
+		pn.set( "computer", xo::get_computer_name() );
+		pn.set( "cpu", GetCpuModel() );
+		pn.set( "hardware_threads", std::thread::hardware_concurrency() );
+		pn.set( "scone_version", xo::to_str( GetSconeVersion() ) );
+		auto& build = pn.add_child( "build" );
+#if defined( _MSC_VER )
+		build.set( "compiler", xo::stringf( "MSVC %d", _MSC_FULL_VER ) );
+#elif defined( __clang__ )
+		build.set( "compiler", "Clang " __clang_version__ );
+#elif defined( __GNUC__ )
+		build.set( "compiler", "GCC " __VERSION__ );
+#endif
+#ifdef NDEBUG
+		build.set( "type", "release" );
+#else
+		build.set( "type", "debug" );
+#endif
+		build.set( "date", GetExecutableDate() );
+		return pn;
+	}
+
+	// JSON output of a PropNode, leaf values that are numbers are written unquoted
+	static void WriteJson( std::ostream& str, const PropNode& pn, int indent )
+	{
+		auto quoted = []( const string& s ) {
+			string r = "\"";
+			for ( auto c : s )
+			{
+				if ( c == '"' || c == '\\' ) r += '\\', r += c;
+				else if ( c == '\n' ) r += "\\n";
+				else if ( c == '\t' ) r += "\\t";
+				else if ( c == '\r' ) r += "\\r";
+				else if ( static_cast<unsigned char>( c ) < 0x20 ) r += xo::stringf( "\\u%04x", int( static_cast<unsigned char>( c ) ) );
+				else r += c;
+			}
+			return r + "\"";
+		};
+
+		if ( pn.size() > 0 )
+		{
+			str << "{\n";
+			index_t idx = 0;
+			for ( const auto& [key, child] : pn )
+			{
+				str << string( indent + 1, '\t' ) << quoted( key ) << ": ";
+				WriteJson( str, child, indent + 1 );
+				str << ( ++idx < pn.size() ? ",\n" : "\n" );
+			}
+			str << string( indent, '\t' ) << "}";
+		}
+		else
+		{
+			const auto& value = pn.raw_value();
+			char* end = nullptr;
+			std::strtod( value.c_str(), &end );
+			bool is_number = !value.empty() && end == value.c_str() + value.size() && value.find_first_of( "xXnN" ) == string::npos;
+			str << ( is_number ? value : quoted( value ) );
+		}
+	}
+
+	// minimal JSON reader for objects, arrays (keys are element indices), strings and literals
+	class JsonReader
+	{
+	public:
+		JsonReader( const string& text ) : text_( text ), pos_( 0 ) {}
+
+		PropNode Read() {
+			PropNode pn;
+			ReadValue( pn );
+			SkipSpace();
+			SCONE_ERROR_IF( pos_ != text_.size(), "Unexpected characters after JSON value" );
+			return pn;
+		}
+
+	private:
+		void SkipSpace() { while ( pos_ < text_.size() && std::isspace( static_cast<unsigned char>( text_[ pos_ ] ) ) ) ++pos_; }
+		char Peek() { SkipSpace(); SCONE_ERROR_IF( pos_ >= text_.size(), "Unexpected end of JSON" ); return text_[ pos_ ]; }
+		void Expect( char c ) { SCONE_ERROR_IF( Peek() != c, xo::stringf( "Expected '%c' at position %d in JSON", c, int( pos_ ) ) ); ++pos_; }
+
+		string ReadString() {
+			Expect( '"' );
+			string s;
+			while ( pos_ < text_.size() && text_[ pos_ ] != '"' )
+			{
+				char c = text_[ pos_++ ];
+				if ( c == '\\' && pos_ < text_.size() )
+				{
+					c = text_[ pos_++ ];
+					if ( c == 'n' ) c = '\n';
+					else if ( c == 't' ) c = '\t';
+					else if ( c == 'r' ) c = '\r';
+					else if ( c == 'b' ) c = '\b';
+					else if ( c == 'f' ) c = '\f';
+					else if ( c == 'u' )
+					{
+						// UTF-16 code unit, possibly the first half of a surrogate pair
+						auto cp = ReadHex4();
+						if ( cp >= 0xd800 && cp < 0xdc00 && text_.compare( pos_, 2, "\\u" ) == 0 )
+						{
+							pos_ += 2;
+							auto low = ReadHex4();
+							SCONE_ERROR_IF( low < 0xdc00 || low >= 0xe000, xo::stringf( "Invalid surrogate pair at position %d in JSON", int( pos_ ) ) );
+							cp = 0x10000 + ( ( cp - 0xd800 ) << 10 ) + ( low - 0xdc00 );
+						}
+						AppendUtf8( s, cp );
+						continue;
+					}
+				}
+				s += c;
+			}
+			Expect( '"' );
+			return s;
+		}
+
+		unsigned ReadHex4() {
+			SCONE_ERROR_IF( pos_ + 4 > text_.size(), "Unexpected end of JSON" );
+			unsigned v = 0;
+			for ( size_t i = 0; i < 4; ++i )
+			{
+				auto c = static_cast<unsigned char>( text_[ pos_++ ] );
+				SCONE_ERROR_IF( !std::isxdigit( c ), xo::stringf( "Invalid unicode escape at position %d in JSON", int( pos_ ) ) );
+				v = v * 16 + ( std::isdigit( c ) ? c - '0' : std::tolower( c ) - 'a' + 10 );
+			}
+			return v;
+		}
+
+		static void AppendUtf8( string& s, unsigned cp ) {
+			if ( cp < 0x80 )
+				s += char( cp );
+			else if ( cp < 0x800 )
+				s += char( 0xc0 | ( cp >> 6 ) ), s += char( 0x80 | ( cp & 0x3f ) );
+			else if ( cp < 0x10000 )
+				s += char( 0xe0 | ( cp >> 12 ) ), s += char( 0x80 | ( ( cp >> 6 ) & 0x3f ) ), s += char( 0x80 | ( cp & 0x3f ) );
+			else
+				s += char( 0xf0 | ( cp >> 18 ) ), s += char( 0x80 | ( ( cp >> 12 ) & 0x3f ) ), s += char( 0x80 | ( ( cp >> 6 ) & 0x3f ) ), s += char( 0x80 | ( cp & 0x3f ) );
+		}
+
+		void ReadValue( PropNode& pn ) {
+			auto c = Peek();
+			if ( c == '{' || c == '[' )
+			{
+				++pos_;
+				char close = c == '{' ? '}' : ']';
+				for ( index_t idx = 0; Peek() != close; ++idx )
+				{
+					if ( idx > 0 )
+						Expect( ',' );
+					auto key = c == '{' ? ReadString() : xo::to_str( idx );
+					if ( c == '{' )
+						Expect( ':' );
+					ReadValue( pn.add_child( key ) );
+				}
+				++pos_;
+			}
+			else if ( c == '"' )
+				pn.set_value( ReadString() );
+			else
+			{
+				auto end = text_.find_first_of( ",}] \t\r\n", pos_ );
+				pn.set_value( text_.substr( pos_, end - pos_ ) );
+				pos_ = std::min( end, text_.size() );
+			}
+		}
+
+		string text_;
+		size_t pos_;
+	};
+
+	void SaveBenchmarkResults( const PropNode& results, const path& file )
+	{
+		if ( file.extension_no_dot() == "json" )
+		{
+			std::ofstream str( file.str() );
+			SCONE_ERROR_IF( !str.good(), "Could not open " + file.str() );
+			WriteJson( str, results, 0 );
+			str << std::endl;
+		}
+		else xo::save_file( results, file );
+	}
+
+	PropNode LoadBenchmarkResults( const path& file )
+	{
+		if ( file.extension_no_dot() == "json" )
+			return JsonReader( load_string( file ) ).Read();
+		else return xo::load_file( file, "zml" );
+	}
+
+	std::vector<String> FindBenchmarkRegressions( const PropNode& baseline, const PropNode& current, double threshold )
+	{
+		std::vector<String> regressions;
+		const auto* base_components = baseline.try_get_child( "components" );
+		const auto* cur_components = current.try_get_child( "components" );
+		SCONE_ERROR_IF( !base_components || !cur_components, "Benchmark results do not contain components" );
+		if ( baseline.get<string>( "cpu", "" ) != current.get<string>( "cpu", "" ) )
+			log::warning( "Comparing benchmarks from different processors: ", baseline.get<string>( "cpu", "" ), " and ", current.get<string>( "cpu", "" ) );
+
+		for ( const auto& [name, cur] : *cur_components )
+		{
+			const auto* base = base_components->try_get_child( name );
+			if ( !base )
+				continue;
+
+			// compare medians using the pooled standard deviation of both results
+			auto base_median = base->get<double>( "median_ns" );
+			auto cur_median = cur.get<double>( "median_ns" );
+			auto base_std = base->get<double>( "std_ns" );
+			auto cur_std = cur.get<double>( "std_ns" );
+			auto stdev = std::max( std::sqrt( 0.5 * ( base_std * base_std + cur_std * cur_std ) ), 1e-3 * base_median );
+			auto diff_std = ( cur_median - base_median ) / stdev;
+			auto diff_perc = 100 * ( cur_median - base_median ) / base_median;
+
+			bool regression = diff_std > threshold;
+			log::level l = regression ? log::level::error : ( diff_std < -threshold ? log::level::warning : log::level::info );
+			log::message( l, xo::stringf( "%-32s\t%10.0fns\t%10.0fns\t%+6.2f%%\t%+6.2fS%s", name.c_str(),
+				cur_median, base_median, diff_perc, diff_std, regression ? "\tREGRESSION" : "" ) );
+			if ( regression )
+				regressions.push_back( name );
+		}
+		return regressions;
+	}
+
+	// reset the peak resident set size, returns false if this is not supported (only Linux supports it)
+	static bool ResetPeakMemoryUsage()
+	{
+#ifdef __linux__
+		std::ofstream str( "/proc/self/clear_refs" );
+		str << "5";
+		str.flush();
+		return str.good();
+#else
+		return false;
+#endif
+	}
+
+	// peak resident set size in bytes
+	static size_t GetPeakMemoryUsage()
+	{
+#if defined( _WIN32 )
+		PROCESS_MEMORY_COUNTERS pmc;
+		if ( GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof( pmc ) ) )
+			return pmc.PeakWorkingSetSize;
+		return 0;
+#elif defined( __linux__ )
+		std::ifstream str( "/proc/self/status" );
+		for ( string line; std::getline( str, line ); )
+			if ( xo::str_begins_with( line, "VmHWM:" ) )
+				return size_t( std::stoull( line.substr( 6 ) ) ) * 1024;
+		return 0;
+#else
+		rusage usage;
+		getrusage( RUSAGE_SELF, &usage );
+		return size_t( usage.ru_maxrss ); // bytes on macOS
+#endif
+	}
+
+	// sets the number of threads of evaluators that have a thread pool, returns false for other evaluators
+	static bool SetEvaluatorThreads( spot::evaluator& eval, size_t num_threads )
+	{
+		auto thread_prio = static_cast<xo::thread_priority>( GetSconeSetting<int>( "optimizer.thread_priority" ) );
+		auto* target = &eval;
+		if ( auto* se = dynamic_cast<ScheduledEvaluator*>( target ) )
+			target = &se->GetTarget();
+		if ( auto* ae = dynamic_cast<spot::async_evaluator*>( target ) )
+			ae->set_max_threads( int( num_threads ), thread_prio );
+		else if ( auto* pe = dynamic_cast<spot::pooled_evaluator*>( target ) )
+			pe->set_max_threads( int( num_threads ), thread_prio );
+		else return false;
+		return true;
+	}
+
+	PropNode BenchmarkScenarioScaling( const PropNode& scenario_pn, const path& file, size_t evals, size_t max_threads )
+	{
+		// evaluations use the evaluator and objective of the optimizer, without the fitness cache
+		auto opt = CreateOptimizer( scenario_pn, file.parent_path() );
+		auto mo = dynamic_cast<ModelObjective*>( &opt->GetObjective() );
+		SCONE_ERROR_IF( !mo, "Scaling benchmark requires a ModelObjective" );
+		mo->SetFitnessCache( nullptr );
+		mo->GetTelemetry().SetEnabled( true );
+		auto& evaluator = CmaOptimizerSpot::GetEvaluator();
+		auto par = SearchPoint( mo->info() );
+
+		if ( max_threads == 0 )
+			max_threads = std::max( 1u, std::thread::hardware_concurrency() );
+		bool fixed_threads = SetEvaluatorThreads( evaluator, 1 );
+		if ( !fixed_threads )
+			log::warning( "Evaluator ", GetSconeSetting<int>( "optimizer.evaluator" ), " has no fixed number of threads, only the batch size is changed" );
+
+		auto baseline_file = file.parent_path() / "perf" / xo::get_computer_name() / file.stem() + ".scaling.stats";
+		bool has_baseline = xo::file_exists( baseline_file );
+		if ( !has_baseline )
+			evals *= 4;
+
+		// read baseline (throughput in evaluations per second)
+		xo::flat_map<string, double> baseline_medians;
+		if ( has_baseline )
+		{
+			xo::char_stream bstr( load_string( baseline_file ) );
+			while ( bstr.good() )
+			{
+				string bname;
+				double bmedian, bstd;
+				bstr >> bname >> bmedian >> bstd;
+				if ( bstr.good() )
+					baseline_medians[ bname ] = bmedian;
+			}
+		}
+
+		log::info( xo::stringf( "%-8s\t%8s\t%8s\t%8s\t%8s\t%8s\t%6s\t%8s\t%8s", "Threads", "Evals/s", "Base", "Diff%", "DiffS",
+			"Effic", "Create", "Sim", "PeakMB" ) );
+		PropNode components;
+		double single_thread_throughput = 0.0;
+		for ( size_t num_threads = 1; num_threads <= max_threads; num_threads = num_threads < max_threads ? std::min( 2 * num_threads, max_threads ) : num_threads + 1 )
+		{
+			SetEvaluatorThreads( evaluator, num_threads );
+			spot::search_point_vec points( num_threads, par );
+
+			// run batches of one evaluation per thread, after a warm-up batch
+			// without a reset, the peak memory includes previous thread counts and is not reported
+			bool has_peak_memory = ResetPeakMemoryUsage();
+			evaluator.evaluate( *mo, points, xo::stop_token(), spot::priority_t( 0 ) );
+			mo->GetTelemetry().Collect();
+			std::vector<double> throughput, eval_times;
+			for ( index_t idx = 0; idx < evals; ++idx )
+			{
+				xo::timer t;
+				evaluator.evaluate( *mo, points, xo::stop_token(), spot::priority_t( 0 ) );
+				auto batch_time = t().seconds();
+				throughput.push_back( num_threads / batch_time );
+				eval_times.push_back( 1e9 * batch_time / num_threads );
+			}
+			std::vector<double> create_times, sim_times;
+			for ( auto& r : mo->GetTelemetry().Collect() )
+			{
+				create_times.push_back( r.create_time );
+				sim_times.push_back( r.simulation_time );
+			}
+			auto peak_memory = GetPeakMemoryUsage();
+
+			// process
+			auto name = xo::stringf( "Throughput%d", int( num_threads ) );
+			auto median = xo::median( throughput );
+			auto stdev = xo::mean_std( throughput ).second;
+			if ( num_threads == 1 )
+				single_thread_throughput = median;
+			auto efficiency = median / ( num_threads * single_thread_throughput );
+			auto create_time = xo::median( create_times );
+			auto sim_time = xo::median( sim_times );
+			auto create_fraction = create_time / ( create_time + sim_time );
+			auto baseline = baseline_medians[ name ];
+			auto diff = baseline > 0 ? median - baseline : 0.0;
+			auto diff_perc = baseline > 0 ? 100 * diff / baseline : 0.0;
+			auto diff_std = stdev > 0 ? diff / stdev : 0.0;
+
+			// report, lower throughput than baseline is an error
+			log::level l = diff_std < -1 ? log::level::error : ( diff_std > 1 ? log::level::warning : log::level::info );
+			auto peak_memory_str = has_peak_memory ? xo::stringf( "%8.0f", peak_memory / 1048576.0 ) : string( "n/a" );
+			log::message( l, xo::stringf( "%-8d\t%8.2f\t%8.2f\t%+7.2f%%\t%+7.2fS\t%7.1f%%\t%5.1f%%\t%6.0fms\t%8s", int( num_threads ),
+				median, baseline, diff_perc, diff_std, 100 * efficiency, 100 * create_fraction, 1000 * sim_time, peak_memory_str.c_str() ) );
+
+			// structured results, with the time per evaluation so that an increase is a regression
+			auto& c = components.add_child( name );
+			c.set( "median_ns", xo::median( eval_times ) );
+			c.set( "std_ns", xo::mean_std( eval_times ).second );
+			c.set( "samples", eval_times.size() );
+			c.set( "threads", num_threads );
+			c.set( "throughput", median );
+			c.set( "efficiency", efficiency );
+			c.set( "create_fraction", create_fraction );
+			c.set( "simulation_ms", 1000 * sim_time );
+			if ( has_peak_memory )
+				c.set( "peak_mb", peak_memory / 1048576.0 );
+			if ( baseline > 0 )
+				c.set( "baseline_throughput", baseline );
+
+			if ( !has_baseline )
+			{
+				auto ostr = std::ofstream( baseline_file.str(), std::ios_base::app );
+				ostr << xo::stringf( "%-32s\t%8.3f\t%8.3f\n", name.c_str(), median, stdev );
+			}
+		}
+
+		auto results = GetBenchmarkSystemInfo();
+		results.set( "scenario", file.str() );
+		results.set( "evaluations", evals );
+		results.add_child( "components", std::move( components ) );
+		return results;
 	}
 }
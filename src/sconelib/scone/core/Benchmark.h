@@ -5,17 +5,47 @@
 #include "PropNode.h"
 #include "xo/filesystem/path.h"
 #include "types.h"
+#include "xo/container/flat_map.h"
+#include <vector>
 
 namespace scone
 {
 	/// Creates and evaluates SimulationObjective. Logs unused properties.
-	SCONE_API void BenchmarkScenario( const PropNode& scenario_pn, const xo::path& file, size_t evals );
+	/// Returns system info and the median, std and sample count of each component timing.
+	/// If perf_counters is set, hardware performance counters per simulated second are included for each simulation phase.
+	SCONE_API PropNode BenchmarkScenario( const PropNode& scenario_pn, const xo::path& file, size_t evals, bool perf_counters = false );
+
+	/// Measures evaluation throughput of a scenario at 1, 2, 4, ... up to max_threads threads (0 = hardware concurrency).
+	/// Each thread count runs evals batches of one evaluation per thread, using the evaluator and objective of the optimizer.
+	/// Returns system info and, for each thread count, the median, std and sample count of the time per evaluation,
+	/// so that results can be compared with FindBenchmarkRegressions. Peak memory is only included on Linux.
+	SCONE_API PropNode BenchmarkScenarioScaling( const PropNode& scenario_pn, const xo::path& file, size_t evals, size_t max_threads );
+
+	/// Timing samples per benchmark component.
+	using BenchmarkSamples = xo::flat_map<String, std::vector<xo::time>>;
+
+	/// Logs the median of each component and compares it to baseline_file, which is created if it does not exist.
+	/// Components starting with "Eval" are reported in ms, other components in ns.
+	/// Returns the median, std and sample count of each component.
+	SCONE_API PropNode ProcessBenchmarks( const BenchmarkSamples& samples, const xo::path& baseline_file, xo::time sim_duration = xo::time() );
+
+	/// Computer name, CPU model and build info, included in benchmark results.
+	SCONE_API PropNode GetBenchmarkSystemInfo();
+
+	/// Save or load benchmark results, as JSON if the file extension is .json, otherwise as ZML.
+	SCONE_API void SaveBenchmarkResults( const PropNode& results, const xo::path& file );
+	SCONE_API PropNode LoadBenchmarkResults( const xo::path& file );
+
+	/// Logs the difference between two benchmark results, and returns the components
+	/// for which the median time has increased by more than threshold standard deviations.
+	SCONE_API std::vector<String> FindBenchmarkRegressions( const PropNode& baseline, const PropNode& current, double threshold );
 
 	struct SCONE_API Benchmark {
 		String name_;
 		xo::time time_;
 		xo::time baseline_;
 		double std_;
+		size_t samples_ = 0;
 
 		xo::time diff() const { return time_ - baseline_; }
 		double diff_perc() const { return 100 * ( diff() / baseline_ ); }
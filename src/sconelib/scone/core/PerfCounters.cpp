@@ -0,0 +1,195 @@
+/*
+** PerfCounters.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "PerfCounters.h"
+
+#include "Log.h"
+#include "xo/string/string_tools.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#ifdef __linux__
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
+
+namespace scone
+{
+	static std::atomic_bool g_PerfCountersWarned = false;
+
+	static void WarnUnavailable( const String& reason )
+	{
+		if ( !g_PerfCountersWarned.exchange( true ) )
+			log::warning( "Hardware performance counters are not available: ", reason );
+	}
+
+#ifdef __linux__
+	// counter group of a single thread, opened on first use
+	struct ThreadPerfCounters
+	{
+		ThreadPerfCounters() {
+			static const std::pair< uint32_t, uint64_t > configs[ PerfCounters::CounterCount ] = {
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+				{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+			};
+
+			// the first counter is the group leader, other counters are skipped if they cannot be opened
+			for ( index_t i = 0; i < PerfCounters::CounterCount; ++i )
+			{
+				perf_event_attr attr;
+				std::memset( &attr, 0, sizeof( attr ) );
+				attr.size = sizeof( attr );
+				attr.type = configs[ i ].first;
+				attr.config = configs[ i ].second;
+				attr.disabled = leader < 0;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_GROUP;
+				int fd = int( syscall( __NR_perf_event_open, &attr, 0, -1, leader, 0 ) );
+				if ( fd < 0 )
+				{
+					if ( leader < 0 )
+					{
+						WarnUnavailable( xo::stringf( "%s (see /proc/sys/kernel/perf_event_paranoid)", std::strerror( errno ) ) );
+						return;
+					}
+					continue;
+				}
+				if ( leader < 0 )
+					leader = fd;
+				fds.push_back( fd );
+				slots[ i ] = int( fds.size() ) - 1;
+			}
+			ioctl( leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+			ioctl( leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+		}
+
+		~ThreadPerfCounters() {
+			for ( auto it = fds.rbegin(); it != fds.rend(); ++it )
+				close( *it );
+		}
+
+		PerfCounters::Values Read() const {
+			PerfCounters::Values v{};
+			if ( leader < 0 )
+				return v;
+
+			// group read format: number of counters, followed by the value of each counter
+			uint64_t buf[ 1 + PerfCounters::CounterCount ];
+			auto bytes = read( leader, buf, sizeof( buf ) );
+			if ( bytes < ssize_t( sizeof( uint64_t ) * ( 1 + fds.size() ) ) )
+				return v;
+			for ( index_t i = 0; i < PerfCounters::CounterCount; ++i )
+				if ( slots[ i ] >= 0 )
+					v[ i ] = buf[ 1 + slots[ i ] ];
+			return v;
+		}
+
+		int leader = -1;
+		std::vector< int > fds;
+		std::array< int, PerfCounters::CounterCount > slots{ -1, -1, -1, -1, -1 };
+	};
+
+	static ThreadPerfCounters& GetThreadPerfCounters()
+	{
+		static thread_local ThreadPerfCounters t_PerfCounters;
+		return t_PerfCounters;
+	}
+
+	bool PerfCounters::IsAvailable() { return GetThreadPerfCounters().leader >= 0; }
+	bool PerfCounters::IsAvailable( Counter c ) { return GetThreadPerfCounters().slots[ c ] >= 0; }
+	PerfCounters::Values PerfCounters::Read() { return GetThreadPerfCounters().Read(); }
+#else
+	bool PerfCounters::IsAvailable() { WarnUnavailable( "only supported on Linux" ); return false; }
+	bool PerfCounters::IsAvailable( Counter c ) { return false; }
+	PerfCounters::Values PerfCounters::Read() { return Values{}; }
+#endif
+
+	const char* PerfCounters::GetName( Counter c )
+	{
+		switch ( c )
+		{
+		case Instructions: return "instructions";
+		case Cycles: return "cycles";
+		case L1DataMisses: return "l1d_misses";
+		case LastLevelCacheMisses: return "llc_misses";
+		case BranchMisses: return "branch_misses";
+		default: return "unknown";
+		}
+	}
+
+	PerfCounterPhases::Phase& PerfCounterPhases::GetPhase( const char* name )
+	{
+		auto it = std::find_if( phases_.begin(), phases_.end(), [&]( const Phase& p ) { return p.name == name || std::strcmp( p.name, name ) == 0; } );
+		return it != phases_.end() ? *it : phases_.emplace_back( Phase{ name } );
+	}
+
+	void PerfCounterPhases::Add( const char* name, const PerfCounters::Values& delta )
+	{
+		auto& p = GetPhase( name );
+		for ( index_t i = 0; i < delta.size(); ++i )
+			p.total[ i ] += delta[ i ];
+		p.count += 1;
+	}
+
+	void PerfCounterPhases::Merge( const PerfCounterPhases& other )
+	{
+		for ( auto& op : other.phases_ )
+		{
+			auto& p = GetPhase( op.name );
+			for ( index_t i = 0; i < op.total.size(); ++i )
+				p.total[ i ] += op.total[ i ];
+			p.count += op.count;
+		}
+	}
+
+	PropNode PerfCounterPhases::GetReport( double simulation_time ) const
+	{
+		PropNode pn;
+		if ( !PerfCounters::IsAvailable() || simulation_time <= 0.0 )
+			return pn;
+
+		for ( auto& p : phases_ )
+		{
+			auto& ppn = pn.add_child( p.name );
+			for ( index_t i = 0; i < PerfCounters::CounterCount; ++i )
+			{
+				auto c = PerfCounters::Counter( i );
+				if ( PerfCounters::IsAvailable( c ) )
+					ppn.set( PerfCounters::GetName( c ), double( p.total[ i ] ) / simulation_time );
+			}
+			if ( PerfCounters::IsAvailable( PerfCounters::Cycles ) && p.total[ PerfCounters::Cycles ] > 0 )
+				ppn.set( "ipc", double( p.total[ PerfCounters::Instructions ] ) / p.total[ PerfCounters::Cycles ] );
+		}
+		return pn;
+	}
+
+	void PerfCounterPhases::LogReport( double simulation_time ) const
+	{
+		if ( !PerfCounters::IsAvailable() || simulation_time <= 0.0 )
+			return;
+
+		log::info( xo::stringf( "%-24s\t%10s\t%10s\t%6s\t%10s\t%10s\t%10s", "Counters per sim second", "instr", "cycles", "ipc", "l1d_miss", "llc_miss", "br_miss" ) );
+		for ( auto& p : phases_ )
+		{
+			auto per_sec = [&]( PerfCounters::Counter c ) { return double( p.total[ c ] ) / simulation_time; };
+			auto cycles = p.total[ PerfCounters::Cycles ];
+			log::info( xo::stringf( "%-24s\t%10.4g\t%10.4g\t%6.2f\t%10.4g\t%10.4g\t%10.4g", p.name,
+				per_sec( PerfCounters::Instructions ), per_sec( PerfCounters::Cycles ),
+				cycles > 0 ? double( p.total[ PerfCounters::Instructions ] ) / cycles : 0.0,
+				per_sec( PerfCounters::L1DataMisses ), per_sec( PerfCounters::LastLevelCacheMisses ), per_sec( PerfCounters::BranchMisses ) ) );
+		}
+	}
+}
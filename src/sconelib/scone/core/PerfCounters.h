@@ -0,0 +1,97 @@
+/*
+** PerfCounters.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+#include "PropNode.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace scone
+{
+	/// Hardware performance counters of the current thread, using perf_event_open on Linux.
+	/** Counters are opened once per thread on first use. If they are not available (other platforms,
+	virtual machines, or a restrictive /proc/sys/kernel/perf_event_paranoid), all values are zero
+	and a warning is logged once. */
+	class SCONE_API PerfCounters
+	{
+	public:
+		enum Counter { Instructions, Cycles, L1DataMisses, LastLevelCacheMisses, BranchMisses, CounterCount };
+		using Values = std::array< uint64_t, CounterCount >;
+
+		/// True if at least the instruction counter is available for the current thread.
+		static bool IsAvailable();
+
+		/// True if a specific counter is available for the current thread.
+		static bool IsAvailable( Counter c );
+
+		/// Current counter values of the current thread, or zeros if not available.
+		static Values Read();
+
+		static const char* GetName( Counter c );
+	};
+
+	/// Counter totals of named simulation phases, e.g. "Controls" or "Step".
+	class SCONE_API PerfCounterPhases
+	{
+	public:
+		struct Phase {
+			const char* name;
+			PerfCounters::Values total{};
+			size_t count = 0;
+		};
+
+		/// Add counter deltas to a phase; name must be a string literal.
+		void Add( const char* name, const PerfCounters::Values& delta );
+
+		/// Add the totals of all phases of other.
+		void Merge( const PerfCounterPhases& other );
+
+		/// Counter values per simulated second for each phase, plus instructions per cycle.
+		PropNode GetReport( double simulation_time ) const;
+
+		/// Log a summary line per phase.
+		void LogReport( double simulation_time ) const;
+
+		const std::vector< Phase >& GetPhases() const { return phases_; }
+		bool IsEmpty() const { return phases_.empty(); }
+
+	private:
+		Phase& GetPhase( const char* name );
+		std::vector< Phase > phases_;
+	};
+
+	/// Adds the counter deltas of a scope to a phase, does nothing if phases is null.
+	class ScopedPerfCounters
+	{
+	public:
+		ScopedPerfCounters( PerfCounterPhases* phases, const char* name ) : phases_( phases ), name_( name ) {
+			if ( phases_ ) start_ = PerfCounters::Read();
+		}
+		~ScopedPerfCounters() {
+			if ( phases_ ) {
+				auto v = PerfCounters::Read();
+				for ( index_t i = 0; i < v.size(); ++i )
+					v[ i ] -= start_[ i ];
+				phases_->Add( name_, v );
+			}
+		}
+		ScopedPerfCounters( const ScopedPerfCounters& ) = delete;
+		ScopedPerfCounters& operator=( const ScopedPerfCounters& ) = delete;
+
+	private:
+		PerfCounterPhases* phases_;
+		const char* name_;
+		PerfCounters::Values start_;
+	};
+}
@@ -0,0 +1,294 @@
+/*
+** ProfileAggregator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ProfileAggregator.h"
+
+#include "ProfileTimeline.h"
+#include "Exception.h"
+#include "xo/time/timer.h"
+#include "xo/string/string_tools.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace scone
+{
+	std::atomic_int ProfileAggregator::flags_ = 0;
+
+	// shared by all threads, so that timeline events have the same time base
+	static xo::timer g_ProfileTimer;
+
+	// scopes recorded by a single thread, in a tree that is reused after each flush
+	struct ThreadProfile
+	{
+		struct Node {
+			const char* name;
+			index_t parent;
+			std::vector< index_t > children;
+			long long total_ns = 0;
+			size_t count = 0;
+		};
+
+		ThreadProfile() : nodes{ Node{ "", no_index } }, current( 0 ) {}
+
+		void Begin( const char* name ) {
+			auto& children = nodes[ current ].children;
+			auto it = std::find_if( children.begin(), children.end(), [&]( index_t c ) { return nodes[ c ].name == name; } );
+			if ( it != children.end() )
+				current = *it;
+			else {
+				nodes.push_back( Node{ name, current } );
+				nodes[ current ].children.push_back( nodes.size() - 1 );
+				current = nodes.size() - 1;
+			}
+			start_times.push_back( g_ProfileTimer().nanoseconds() );
+		}
+
+		void End() {
+			auto& n = nodes[ current ];
+			auto end_time = g_ProfileTimer().nanoseconds();
+			n.total_ns += end_time - start_times.back();
+			n.count += 1;
+			if ( ProfileAggregator::IsTimelineActive() )
+				ProfileTimeline::Record( n.name, start_times.back(), end_time );
+			start_times.pop_back();
+			current = n.parent;
+		}
+
+		std::vector< Node > nodes;
+		index_t current;
+		std::vector< long long > start_times;
+	};
+
+	static thread_local ThreadProfile t_ThreadProfile;
+
+	static double GetPercentile( std::vector< double > v, double p )
+	{
+		if ( v.empty() )
+			return 0.0;
+		auto idx = std::min( v.size() - 1, size_t( p * v.size() ) );
+		std::nth_element( v.begin(), v.begin() + idx, v.end() );
+		return v[ idx ];
+	}
+
+	ProfileAggregator& ProfileAggregator::GetInstance()
+	{
+		static ProfileAggregator g_Instance;
+		return g_Instance;
+	}
+
+	ProfileAggregator::ProfileAggregator() :
+		max_samples_( 1000 )
+	{}
+
+	void ProfileAggregator::SetActive( const void* owner, bool active )
+	{
+		std::scoped_lock lock( mutex_ );
+		if ( active )
+		{
+			SCONE_ERROR_IF( aggregates_.count( owner ) > 0, "Profiling is already active for this objective" );
+			aggregates_[ owner ] = Aggregate();
+		}
+		else aggregates_.erase( owner );
+
+		if ( !aggregates_.empty() )
+			flags_ |= aggregate_flag;
+		else flags_ &= ~aggregate_flag;
+	}
+
+	void ProfileAggregator::SetTimelineActive( bool active )
+	{
+		if ( active )
+			flags_ |= timeline_flag;
+		else flags_ &= ~timeline_flag;
+	}
+
+	void ProfileAggregator::BeginScope( const char* name )
+	{
+		t_ThreadProfile.Begin( name );
+	}
+
+	void ProfileAggregator::EndScope()
+	{
+		t_ThreadProfile.End();
+	}
+
+	void ProfileAggregator::FlushThread( const void* owner )
+	{
+		auto& tp = t_ThreadProfile;
+		if ( tp.nodes.size() <= 1 )
+			return;
+
+		// scopes of owners that are not active are discarded
+		std::scoped_lock lock( mutex_ );
+		auto it = aggregates_.find( owner );
+		if ( it == aggregates_.end() )
+		{
+			for ( auto& n : tp.nodes )
+				n.total_ns = 0, n.count = 0;
+			return;
+		}
+
+		// paths are only composed here, once per evaluation
+		auto& agg = it->second;
+		std::vector< String > paths( tp.nodes.size() );
+		long long busy_ns = 0;
+		for ( index_t i = 1; i < tp.nodes.size(); ++i )
+		{
+			auto& n = tp.nodes[ i ];
+			paths[ i ] = n.parent == 0 ? String( n.name ) : paths[ n.parent ] + '/' + n.name;
+			if ( n.count == 0 )
+				continue;
+
+			auto& s = agg.scopes[ paths[ i ] ];
+			s.total_ns += n.total_ns;
+			s.count += n.count;
+			s.evaluations += 1;
+			auto ms = n.total_ns * 1e-6;
+			if ( s.samples.size() < max_samples_ )
+				s.samples.push_back( ms );
+			else s.samples[ s.next_sample ] = ms;
+			s.next_sample = ( s.next_sample + 1 ) % max_samples_;
+			if ( n.parent == 0 )
+				busy_ns += n.total_ns;
+
+			n.total_ns = 0;
+			n.count = 0;
+		}
+
+		auto& ts = agg.threads[ std::this_thread::get_id() ];
+		ts.busy_ns += busy_ns;
+		ts.evaluations += 1;
+		agg.evaluations += 1;
+	}
+
+	void ProfileAggregator::Reset( const void* owner )
+	{
+		std::scoped_lock lock( mutex_ );
+		if ( auto it = aggregates_.find( owner ); it != aggregates_.end() )
+			it->second = Aggregate();
+	}
+
+	const ProfileAggregator::Aggregate* ProfileAggregator::FindAggregate( const void* owner ) const
+	{
+		auto it = aggregates_.find( owner );
+		return it != aggregates_.end() ? &it->second : nullptr;
+	}
+
+	long long ProfileAggregator::GetExclusiveTime( const Aggregate& a, const String& path, const ScopeStats& s )
+	{
+		// all descendants share the same prefix and are therefore adjacent in the map
+		auto t = s.total_ns;
+		auto prefix = path + '/';
+		for ( auto it = a.scopes.lower_bound( prefix ); it != a.scopes.end() && xo::str_begins_with( it->first, prefix ); ++it )
+			if ( it->first.find( '/', prefix.size() ) == String::npos )
+				t -= it->second.total_ns;
+		return t;
+	}
+
+	PropNode ProfileAggregator::GetReport( const void* owner ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		static const Aggregate empty;
+		auto* agg = FindAggregate( owner );
+		const auto& a = agg ? *agg : empty;
+
+		long long root_ns = 0;
+		for ( auto& [path, s] : a.scopes )
+			if ( path.find( '/' ) == String::npos )
+				root_ns += s.total_ns;
+
+		PropNode pn;
+		pn.set( "evaluations", a.evaluations );
+		pn.set( "total_time", root_ns * 1e-9 );
+
+		pn.set( "thread_imbalance", ComputeThreadImbalance( a ) );
+		auto& threads_pn = pn.add_child( "threads" );
+		index_t thread_idx = 0;
+		for ( auto& [id, ts] : a.threads )
+		{
+			auto& t = threads_pn.add_child( xo::stringf( "thread%d", int( thread_idx++ ) ) );
+			t.set( "evaluations", ts.evaluations );
+			t.set( "busy_time", ts.busy_ns * 1e-9 );
+		}
+
+		// scope tree, ordered by name
+		auto& scopes_pn = pn.add_child( "scopes" );
+		for ( auto& [path, s] : a.scopes )
+		{
+			PropNode* parent = &scopes_pn;
+			auto names = xo::split_str( path, "/" );
+			for ( index_t i = 0; i + 1 < names.size(); ++i )
+				parent = &( *parent )[ names[ i ] ];
+
+			auto& sp = ( *parent )[ names.back() ];
+			sp.set( "total", s.total_ns * 1e-9 );
+			sp.set( "exclusive", GetExclusiveTime( a, path, s ) * 1e-9 );
+			sp.set( "percent", root_ns > 0 ? 100.0 * s.total_ns / root_ns : 0.0 );
+			sp.set( "count", s.count );
+			sp.set( "mean_us", s.count > 0 ? 1e-3 * s.total_ns / s.count : 0.0 );
+			sp.set( "eval_p50_ms", GetPercentile( s.samples, 0.5 ) );
+			sp.set( "eval_p90_ms", GetPercentile( s.samples, 0.9 ) );
+			sp.set( "eval_p99_ms", GetPercentile( s.samples, 0.99 ) );
+		}
+
+		return pn;
+	}
+
+	String ProfileAggregator::GetHotspots( const void* owner, size_t count ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto* agg = FindAggregate( owner );
+		if ( !agg )
+			return String();
+
+		long long root_ns = 0;
+		std::vector< std::pair< long long, const String* > > exclusive;
+		for ( auto& [path, s] : agg->scopes )
+		{
+			if ( path.find( '/' ) == String::npos )
+				root_ns += s.total_ns;
+			exclusive.emplace_back( GetExclusiveTime( *agg, path, s ), &path );
+		}
+		std::sort( exclusive.begin(), exclusive.end(), []( auto& a, auto& b ) { return a.first > b.first; } );
+
+		String str;
+		for ( index_t i = 0; i < exclusive.size() && i < count && root_ns > 0; ++i )
+		{
+			auto& path = *exclusive[ i ].second;
+			auto name = path.substr( path.rfind( '/' ) + 1 );
+			str += ( str.empty() ? "" : "; " ) + xo::stringf( "%s %.1f%%", name.c_str(), 100.0 * exclusive[ i ].first / root_ns );
+		}
+		return str;
+	}
+
+	double ProfileAggregator::GetThreadImbalance( const void* owner ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto* agg = FindAggregate( owner );
+		return agg ? ComputeThreadImbalance( *agg ) : 0.0;
+	}
+
+	double ProfileAggregator::ComputeThreadImbalance( const Aggregate& a )
+	{
+		long long max_ns = 0, sum_ns = 0;
+		for ( auto& [id, ts] : a.threads )
+		{
+			max_ns = std::max( max_ns, ts.busy_ns );
+			sum_ns += ts.busy_ns;
+		}
+		return sum_ns > 0 ? double( max_ns ) * a.threads.size() / sum_ns - 1.0 : 0.0;
+	}
+
+	size_t ProfileAggregator::GetEvaluationCount( const void* owner ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto* agg = FindAggregate( owner );
+		return agg ? agg->evaluations : 0;
+	}
+}
@@ -0,0 +1,110 @@
+/*
+** ProfileAggregator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+#include "PropNode.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scone
+{
+	/// Profile of SCONE_PROFILE scopes, merged across all evaluations and threads of each owner.
+	/** Scopes are recorded per thread without locking, and are merged into the aggregate of the owner
+	(i.e. the objective) when FlushThread() is called, which is done after each evaluation. This way,
+	optimizers running in the same process each get their own profile. Recording only takes place while
+	any owner is active; when inactive, each profiled scope costs a single flag check. */
+	class SCONE_API ProfileAggregator
+	{
+	public:
+		static ProfileAggregator& GetInstance();
+
+		/// Enable or disable recording for an owner, called by each optimizer that uses the profile.
+		/** Enabling starts with an empty aggregate; enabling an owner that is already active is an error.
+		Scopes are recorded by all threads until all owners have been disabled. */
+		void SetActive( const void* owner, bool active );
+
+		/// True if scopes are recorded, either for an aggregate or for the ProfileTimeline.
+		static bool IsActive() { return flags_.load( std::memory_order_relaxed ) != 0; }
+		static bool IsTimelineActive() { return ( flags_.load( std::memory_order_relaxed ) & timeline_flag ) != 0; }
+
+		/// Enable or disable passing scopes to the ProfileTimeline; used by ProfileTimeline.
+		static void SetTimelineActive( bool active );
+
+		/// Merge the scopes recorded by the current thread into the aggregate of owner, or discard them if owner is not active.
+		void FlushThread( const void* owner );
+
+		/// Clear the aggregate of owner; does not affect scopes recorded by threads but not yet flushed.
+		void Reset( const void* owner );
+
+		/// Per-scope totals, counts and per-evaluation percentiles, plus the busy time of each thread.
+		PropNode GetReport( const void* owner ) const;
+
+		/// Scopes with the highest exclusive time, e.g. "Muscle::UpdateState 23.1%; Model::Step 12.0%".
+		String GetHotspots( const void* owner, size_t count ) const;
+
+		/// Relative difference between the busiest thread and the average thread, or 0 if unknown.
+		double GetThreadImbalance( const void* owner ) const;
+
+		size_t GetEvaluationCount( const void* owner ) const;
+
+		// used by ScopedProfileSample
+		static void BeginScope( const char* name );
+		static void EndScope();
+
+	private:
+		ProfileAggregator();
+
+		// scopes are recorded if any of these flags are set; checked inline for each profiled scope
+		enum { aggregate_flag = 1, timeline_flag = 2 };
+		static std::atomic_int flags_;
+
+		struct ScopeStats {
+			long long total_ns = 0;
+			size_t count = 0;
+			size_t evaluations = 0;
+			std::vector< double > samples; // per-evaluation totals in ms, ring buffer of at most max_samples_
+			size_t next_sample = 0;
+		};
+		struct ThreadStats {
+			long long busy_ns = 0;
+			size_t evaluations = 0;
+		};
+		struct Aggregate {
+			std::map< String, ScopeStats > scopes; // keyed by path of scope names, separated by '/'
+			std::map< std::thread::id, ThreadStats > threads;
+			size_t evaluations = 0;
+		};
+		const Aggregate* FindAggregate( const void* owner ) const;
+		static long long GetExclusiveTime( const Aggregate& a, const String& path, const ScopeStats& s );
+		static double ComputeThreadImbalance( const Aggregate& a );
+
+		std::map< const void*, Aggregate > aggregates_;
+		size_t max_samples_;
+		mutable std::mutex mutex_;
+	};
+
+	/// Records a scope in the ProfileAggregator and ProfileTimeline if active; name must be a string literal.
+	class ScopedProfileSample
+	{
+	public:
+		ScopedProfileSample( const char* name ) : active_( ProfileAggregator::IsActive() ) { if ( active_ ) ProfileAggregator::BeginScope( name ); }
+		~ScopedProfileSample() { if ( active_ ) ProfileAggregator::EndScope(); }
+		ScopedProfileSample( const ScopedProfileSample& ) = delete;
+		ScopedProfileSample& operator=( const ScopedProfileSample& ) = delete;
+
+	private:
+		bool active_;
+	};
+}
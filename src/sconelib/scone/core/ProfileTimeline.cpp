@@ -0,0 +1,187 @@
+/*
+** ProfileTimeline.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ProfileTimeline.h"
+
+#include "ProfileAggregator.h"
+#include "Exception.h"
+#include "xo/string/string_tools.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace scone
+{
+	// buffer of the current thread, valid for a single recording session
+	struct ThreadTimeline {
+		size_t session = 0;
+		std::shared_ptr< void > buffer;
+	};
+	static thread_local ThreadTimeline t_ThreadTimeline;
+
+	static String JsonQuoted( const char* s )
+	{
+		String r = "\"";
+		for ( ; *s; ++s )
+		{
+			if ( *s == '"' || *s == '\\' ) r += '\\', r += *s;
+			else if ( static_cast<unsigned char>( *s ) < 0x20 ) r += xo::stringf( "\\u%04x", int( *s ) );
+			else r += *s;
+		}
+		return r + "\"";
+	}
+
+	ProfileTimeline& ProfileTimeline::GetInstance()
+	{
+		static ProfileTimeline g_Instance;
+		return g_Instance;
+	}
+
+	ProfileTimeline::ProfileTimeline() :
+		recording_( false ),
+		session_( 0 ),
+		max_events_( 0 ),
+		active_users_( 0 )
+	{}
+
+	void ProfileTimeline::Start( size_t max_events )
+	{
+		SCONE_ERROR_IF( max_events == 0, "Number of timeline events must be > 0" );
+		std::scoped_lock lock( mutex_ );
+		if ( active_users_++ == 0 )
+		{
+			// the first optimizer starts with an empty timeline
+			buffers_.clear();
+			max_events_ = max_events;
+			++session_;
+			recording_ = true;
+			ProfileAggregator::SetTimelineActive( true );
+		}
+		else max_events_ = std::max( max_events_, max_events ); // only affects threads that start recording later
+	}
+
+	void ProfileTimeline::Stop()
+	{
+		std::scoped_lock lock( mutex_ );
+		if ( active_users_ > 0 && --active_users_ == 0 )
+		{
+			ProfileAggregator::SetTimelineActive( false );
+			recording_ = false;
+		}
+	}
+
+	void ProfileTimeline::Record( const char* name, long long begin_ns, long long end_ns )
+	{
+		auto& tl = GetInstance();
+		if ( !tl.recording_.load( std::memory_order_relaxed ) )
+			return;
+
+		auto* b = tl.GetThreadBuffer();
+		auto idx = b->size.load( std::memory_order_relaxed );
+		if ( idx < b->events.size() )
+		{
+			b->events[ idx ] = Event{ name, begin_ns, end_ns };
+			b->size.store( idx + 1, std::memory_order_release );
+		}
+		else b->dropped.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	ProfileTimeline::Buffer* ProfileTimeline::GetThreadBuffer()
+	{
+		// the mutex is only locked once per thread per session
+		auto& tt = t_ThreadTimeline;
+		auto session = session_.load( std::memory_order_acquire );
+		if ( tt.session != session || !tt.buffer )
+		{
+			std::scoped_lock lock( mutex_ );
+			auto b = std::make_shared< Buffer >( max_events_, buffers_.size() );
+			buffers_.push_back( b );
+			tt.buffer = b;
+			tt.session = session_;
+		}
+		return static_cast<Buffer*>( tt.buffer.get() );
+	}
+
+	std::vector< std::shared_ptr< ProfileTimeline::Buffer > > ProfileTimeline::GetBuffers() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return buffers_;
+	}
+
+	void ProfileTimeline::WriteChromeTrace( const path& filename ) const
+	{
+		std::ofstream str( filename.str() );
+		SCONE_ERROR_IF( !str.good(), "Could not open " + filename.str() );
+
+		// timestamps are in microseconds
+		str << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for ( auto& b : GetBuffers() )
+		{
+			auto tid = int( b->thread_index );
+			str << ( first ? "" : ",\n" ) << xo::stringf( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", tid, tid );
+			first = false;
+			auto size = b->size.load( std::memory_order_acquire );
+			for ( index_t i = 0; i < size; ++i )
+			{
+				auto& e = b->events[ i ];
+				str << ",\n{\"name\":" << JsonQuoted( e.name ) << xo::stringf( ",\"cat\":\"scone\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					tid, e.begin_ns * 1e-3, ( e.end_ns - e.begin_ns ) * 1e-3 );
+			}
+		}
+		str << "\n]}\n";
+	}
+
+	void ProfileTimeline::WriteFoldedStacks( const path& filename ) const
+	{
+		// events are stored when a scope ends, so they are sorted by begin time to reconstruct the call stacks
+		std::map< String, long long > stacks;
+		for ( auto& b : GetBuffers() )
+		{
+			std::vector< Event > events( b->events.begin(), b->events.begin() + b->size.load( std::memory_order_acquire ) );
+			std::sort( events.begin(), events.end(), []( const Event& a, const Event& b ) {
+				return a.begin_ns < b.begin_ns || ( a.begin_ns == b.begin_ns && a.end_ns > b.end_ns );
+			} );
+
+			std::vector< std::pair< const Event*, String > > stack;
+			for ( auto& e : events )
+			{
+				while ( !stack.empty() && stack.back().first->end_ns <= e.begin_ns )
+					stack.pop_back();
+				auto duration = e.end_ns - e.begin_ns;
+				auto name = stack.empty() ? String( e.name ) : stack.back().second + ';' + e.name;
+				stacks[ name ] += duration;
+				if ( !stack.empty() )
+					stacks[ stack.back().second ] -= duration;
+				stack.emplace_back( &e, std::move( name ) );
+			}
+		}
+
+		std::ofstream str( filename.str() );
+		SCONE_ERROR_IF( !str.good(), "Could not open " + filename.str() );
+		for ( auto& [name, ns] : stacks )
+			if ( ns >= 1000 )
+				str << name << ' ' << ns / 1000 << '\n';
+	}
+
+	size_t ProfileTimeline::GetEventCount() const
+	{
+		size_t count = 0;
+		for ( auto& b : GetBuffers() )
+			count += b->size.load( std::memory_order_relaxed );
+		return count;
+	}
+
+	size_t ProfileTimeline::GetDroppedEventCount() const
+	{
+		size_t count = 0;
+		for ( auto& b : GetBuffers() )
+			count += b->dropped.load( std::memory_order_relaxed );
+		return count;
+	}
+}
@@ -0,0 +1,74 @@
+/*
+** ProfileTimeline.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace scone
+{
+	/// Records begin and end times of SCONE_PROFILE scopes of all threads.
+	/** Each thread writes to its own fixed-size buffer without locking; events that do not fit are dropped.
+	Recorded events can be written as Chrome trace-event JSON (for chrome://tracing or Perfetto),
+	or as folded stacks (for flamegraph tools), also while recording. */
+	class SCONE_API ProfileTimeline
+	{
+	public:
+		static ProfileTimeline& GetInstance();
+
+		/// Start recording, called by each optimizer that uses the timeline.
+		/** The first call clears all events, with room for max_events events per thread. The timeline is shared
+		by all optimizers in the process, and recording continues until each call to Start() is matched by Stop(). */
+		void Start( size_t max_events = 1000000 );
+		void Stop();
+		bool IsRecording() const { return recording_; }
+
+		/// Chrome trace-event JSON, with one complete event per scope and one track per thread.
+		void WriteChromeTrace( const path& filename ) const;
+
+		/// One line per call stack with the exclusive time in microseconds, e.g. "evaluate;AdvanceSimulationTo;stepTo 12345".
+		void WriteFoldedStacks( const path& filename ) const;
+
+		size_t GetEventCount() const;
+		size_t GetDroppedEventCount() const;
+
+		// used by ProfileAggregator, times are in ns
+		static void Record( const char* name, long long begin_ns, long long end_ns );
+
+	private:
+		ProfileTimeline();
+
+		struct Event {
+			const char* name;
+			long long begin_ns;
+			long long end_ns;
+		};
+		struct Buffer {
+			Buffer( size_t capacity, index_t thread_index ) : events( capacity ), size( 0 ), dropped( 0 ), thread_index( thread_index ) {}
+			std::vector< Event > events;
+			std::atomic< size_t > size; // written by the owning thread only
+			std::atomic< size_t > dropped;
+			index_t thread_index;
+		};
+		Buffer* GetThreadBuffer();
+		std::vector< std::shared_ptr< Buffer > > GetBuffers() const;
+
+		std::atomic_bool recording_;
+		std::atomic< size_t > session_;
+		size_t max_events_;
+		size_t active_users_;
+		std::vector< std::shared_ptr< Buffer > > buffers_;
+		mutable std::mutex mutex_;
+	};
+}
@@ -0,0 +1,256 @@
+/*
+** Socket.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "Socket.h"
+#include "Exception.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <winsock2.h>
+#	include <ws2tcpip.h>
+#	pragma comment( lib, "ws2_32.lib" )
+#else
+#	include <sys/socket.h>
+#	include <sys/time.h>
+#	include <sys/un.h>
+#	include <netdb.h>
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <unistd.h>
+#	include <cstring>
+#endif
+
+namespace scone
+{
+#ifdef _WIN32
+	using native_socket_t = SOCKET;
+	inline void close_native( native_socket_t s ) { closesocket( s ); }
+	constexpr int shutdown_both = SD_BOTH;
+	struct winsock_initializer {
+		winsock_initializer() { WSADATA data; WSAStartup( MAKEWORD( 2, 2 ), &data ); }
+		~winsock_initializer() { WSACleanup(); }
+	};
+	static void init_sockets() { static winsock_initializer init; }
+#else
+	using native_socket_t = int;
+	inline void close_native( native_socket_t s ) { ::close( s ); }
+	constexpr int shutdown_both = SHUT_RDWR;
+	static void init_sockets() {}
+#endif
+
+	static const String unix_prefix = "unix:";
+
+	static bool is_unix_address( const String& address ) { return address.compare( 0, unix_prefix.size(), unix_prefix ) == 0; }
+
+	// resolve host:port, use empty host or * for any address
+	static addrinfo* resolve_tcp_address( const String& address, bool passive )
+	{
+		auto colon = address.rfind( ':' );
+		SCONE_ERROR_IF( colon == String::npos, "Invalid address, expected host:port or unix:path: " + address );
+		auto host = address.substr( 0, colon );
+		auto port = address.substr( colon + 1 );
+
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = passive ? AI_PASSIVE : 0;
+		addrinfo* result = nullptr;
+		auto err = getaddrinfo( host.empty() || host == "*" ? nullptr : host.c_str(), port.c_str(), &hints, &result );
+		SCONE_ERROR_IF( err != 0 || !result, "Could not resolve address " + address );
+		return result;
+	}
+
+#ifndef _WIN32
+	static sockaddr_un make_unix_address( const String& address )
+	{
+		auto file = address.substr( unix_prefix.size() );
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		SCONE_ERROR_IF( file.empty() || file.size() >= sizeof( addr.sun_path ), "Invalid unix socket path: " + address );
+		std::strncpy( addr.sun_path, file.c_str(), sizeof( addr.sun_path ) - 1 );
+		return addr;
+	}
+#endif
+
+	Socket& Socket::operator=( Socket&& other ) noexcept
+	{
+		if ( this != &other )
+		{
+			if ( IsValid() )
+				close_native( static_cast<native_socket_t>( handle_ ) );
+			handle_ = other.handle_;
+			other.handle_ = invalid_handle;
+		}
+		return *this;
+	}
+
+	Socket::~Socket()
+	{
+		if ( IsValid() )
+			close_native( static_cast<native_socket_t>( handle_ ) );
+	}
+
+	Socket Socket::Connect( const String& address )
+	{
+		init_sockets();
+		if ( is_unix_address( address ) )
+		{
+#ifdef _WIN32
+			SCONE_THROW( "Unix domain sockets are not supported on this platform" );
+#else
+			auto addr = make_unix_address( address );
+			Socket s( socket( AF_UNIX, SOCK_STREAM, 0 ) );
+			SCONE_ERROR_IF( !s.IsValid(), "Could not create socket" );
+			if ( connect( static_cast<native_socket_t>( s.handle_ ), reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) != 0 )
+				SCONE_THROW( "Could not connect to " + address );
+			return s;
+#endif
+		}
+
+		auto* info = resolve_tcp_address( address, false );
+		for ( auto* ai = info; ai; ai = ai->ai_next )
+		{
+			Socket s( static_cast<handle_t>( socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol ) ) );
+			if ( s.IsValid() && connect( static_cast<native_socket_t>( s.handle_ ), ai->ai_addr, (int)ai->ai_addrlen ) == 0 )
+			{
+				int flag = 1; // messages are small and latency matters
+				setsockopt( static_cast<native_socket_t>( s.handle_ ), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>( &flag ), sizeof( flag ) );
+				freeaddrinfo( info );
+				return s;
+			}
+		}
+		freeaddrinfo( info );
+		SCONE_THROW( "Could not connect to " + address );
+	}
+
+	Socket Socket::Listen( const String& address, int backlog )
+	{
+		init_sockets();
+		if ( is_unix_address( address ) )
+		{
+#ifdef _WIN32
+			SCONE_THROW( "Unix domain sockets are not supported on this platform" );
+#else
+			auto addr = make_unix_address( address );
+			::unlink( addr.sun_path ); // remove stale socket file
+			Socket s( socket( AF_UNIX, SOCK_STREAM, 0 ) );
+			SCONE_ERROR_IF( !s.IsValid(), "Could not create socket" );
+			if ( bind( static_cast<native_socket_t>( s.handle_ ), reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) != 0
+				|| listen( static_cast<native_socket_t>( s.handle_ ), backlog ) != 0 )
+				SCONE_THROW( "Could not listen on " + address );
+			return s;
+#endif
+		}
+
+		auto* info = resolve_tcp_address( address, true );
+		for ( auto* ai = info; ai; ai = ai->ai_next )
+		{
+			Socket s( static_cast<handle_t>( socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol ) ) );
+			if ( !s.IsValid() )
+				continue;
+			int flag = 1;
+			setsockopt( static_cast<native_socket_t>( s.handle_ ), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>( &flag ), sizeof( flag ) );
+			if ( bind( static_cast<native_socket_t>( s.handle_ ), ai->ai_addr, (int)ai->ai_addrlen ) == 0
+				&& listen( static_cast<native_socket_t>( s.handle_ ), backlog ) == 0 )
+			{
+				freeaddrinfo( info );
+				return s;
+			}
+		}
+		freeaddrinfo( info );
+		SCONE_THROW( "Could not listen on " + address );
+	}
+
+	Socket Socket::Accept() const
+	{
+		auto h = accept( static_cast<native_socket_t>( handle_ ), nullptr, nullptr );
+		Socket s( static_cast<handle_t>( h ) );
+		if ( s.IsValid() )
+		{
+			int flag = 1;
+			setsockopt( static_cast<native_socket_t>( s.handle_ ), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>( &flag ), sizeof( flag ) );
+		}
+		return s;
+	}
+
+	bool Socket::Send( const void* data, size_t size ) const
+	{
+		auto* ptr = static_cast<const char*>( data );
+		while ( size > 0 )
+		{
+#ifdef _WIN32
+			auto n = send( static_cast<native_socket_t>( handle_ ), ptr, (int)std::min<size_t>( size, 1 << 30 ), 0 );
+#else
+			auto n = send( static_cast<native_socket_t>( handle_ ), ptr, size, MSG_NOSIGNAL );
+#endif
+			if ( n <= 0 )
+				return false;
+			ptr += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	bool Socket::Receive( void* data, size_t size ) const
+	{
+		auto* ptr = static_cast<char*>( data );
+		while ( size > 0 )
+		{
+#ifdef _WIN32
+			auto n = recv( static_cast<native_socket_t>( handle_ ), ptr, (int)std::min<size_t>( size, 1 << 30 ), 0 );
+#else
+			auto n = recv( static_cast<native_socket_t>( handle_ ), ptr, size, 0 );
+#endif
+			if ( n <= 0 )
+				return false;
+			ptr += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	void Socket::SetKeepAlive( bool enable ) const
+	{
+		int flag = enable ? 1 : 0;
+		setsockopt( static_cast<native_socket_t>( handle_ ), SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>( &flag ), sizeof( flag ) );
+	}
+
+	void Socket::SetReceiveTimeout( double timeout ) const
+	{
+#ifdef _WIN32
+		DWORD ms = DWORD( timeout * 1000 );
+		setsockopt( static_cast<native_socket_t>( handle_ ), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>( &ms ), sizeof( ms ) );
+#else
+		timeval tv{};
+		tv.tv_sec = decltype( tv.tv_sec )( timeout );
+		tv.tv_usec = decltype( tv.tv_usec )( ( timeout - double( tv.tv_sec ) ) * 1e6 );
+		setsockopt( static_cast<native_socket_t>( handle_ ), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+#endif
+	}
+
+	int Socket::GetLocalPort() const
+	{
+		sockaddr_storage addr{};
+		socklen_t len = sizeof( addr );
+		if ( getsockname( static_cast<native_socket_t>( handle_ ), reinterpret_cast<sockaddr*>( &addr ), &len ) != 0 )
+			return 0;
+		if ( addr.ss_family == AF_INET )
+			return ntohs( reinterpret_cast<sockaddr_in*>( &addr )->sin_port );
+		if ( addr.ss_family == AF_INET6 )
+			return ntohs( reinterpret_cast<sockaddr_in6*>( &addr )->sin6_port );
+		return 0;
+	}
+
+	void Socket::Shutdown() const
+	{
+		if ( IsValid() )
+			shutdown( static_cast<native_socket_t>( handle_ ), shutdown_both );
+	}
+}
@@ -0,0 +1,61 @@
+/*
+** Socket.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+#include <cstdint>
+
+namespace scone
+{
+	/// Minimal blocking stream socket, supporting TCP ("host:port") and Unix domain sockets ("unix:/path").
+	class SCONE_API Socket
+	{
+	public:
+		Socket() : handle_( invalid_handle ) {}
+		Socket( Socket&& other ) noexcept : handle_( other.handle_ ) { other.handle_ = invalid_handle; }
+		Socket& operator=( Socket&& other ) noexcept;
+		Socket( const Socket& ) = delete;
+		Socket& operator=( const Socket& ) = delete;
+		~Socket();
+
+		/// Connect to a listening socket; throws on failure.
+		static Socket Connect( const String& address );
+
+		/// Create a listening socket; throws on failure.
+		static Socket Listen( const String& address, int backlog = 64 );
+
+		/// Wait for a new connection, returns an invalid socket if interrupted by Shutdown().
+		Socket Accept() const;
+
+		/// Send or receive exactly size bytes; returns false if the connection was closed or failed.
+		bool Send( const void* data, size_t size ) const;
+		bool Receive( void* data, size_t size ) const;
+
+		/// Unblock pending operations from other threads; the socket is released on destruction.
+		void Shutdown() const;
+
+		/// Detect dead connections with TCP keepalive probes.
+		void SetKeepAlive( bool enable ) const;
+
+		/// Make Receive() fail if no data arrives within timeout seconds, 0 = wait forever.
+		void SetReceiveTimeout( double timeout ) const;
+
+		/// Port number of a TCP socket, useful after listening on port 0.
+		int GetLocalPort() const;
+
+		bool IsValid() const { return handle_ != invalid_handle; }
+
+	private:
+		using handle_t = intptr_t;
+		static constexpr handle_t invalid_handle = -1;
+		explicit Socket( handle_t h ) : handle_( h ) {}
+		handle_t handle_;
+	};
+}
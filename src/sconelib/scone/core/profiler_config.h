@@ -12,10 +12,13 @@
 #	define SCONE_PROFILE_REPORT log::info( Profiler::GetGlobalInstance().GetReport() )
 #elif defined SCONE_ENABLE_XO_PROFILING
 #	include "PropNode.h"
+#	include "ProfileAggregator.h"
 #	include "xo/system/profiler.h"
-#	define SCONE_PROFILE_FUNCTION( profiler ) xo::scope_profiler scoped_profile_var( __FUNCTION__, profiler )
-#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) xo::scope_profiler scoped_profile_var( scope_name_arg, profiler )
+#	define SCONE_PROFILE_FUNCTION( profiler ) xo::scope_profiler scoped_profile_var( __FUNCTION__, profiler ); scone::ScopedProfileSample scoped_profile_sample_var( __FUNCTION__ )
+#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) xo::scope_profiler scoped_profile_var( scope_name_arg, profiler ); scone::ScopedProfileSample scoped_profile_sample_var( scope_name_arg )
 #else 
-#	define SCONE_PROFILE_FUNCTION( profiler ) void()
-#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) void()
+// scopes are always available to the ProfileAggregator, which only records them when active
+#	include "ProfileAggregator.h"
+#	define SCONE_PROFILE_FUNCTION( profiler ) scone::ScopedProfileSample scoped_profile_sample_var( __FUNCTION__ )
+#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) scone::ScopedProfileSample scoped_profile_sample_var( scope_name_arg )
 #endif
@@ -18,6 +18,14 @@
 #include "Log.h"
 #include "Exception.h"
 
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else
+#	include <cstdio>
+#endif
+
 namespace scone
 {
 	String g_Version;
@@ -83,4 +91,15 @@ namespace scone
 			path( ".." ) / p.filename() // filename in parent folder
 			} );
 	}
+
+	void RenameFile( const path& from, const path& to )
+	{
+#ifdef _WIN32
+		// rename() fails on Windows if the target exists
+		bool ok = MoveFileExA( from.str().c_str(), to.str().c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+#else
+		bool ok = std::rename( from.str().c_str(), to.str().c_str() ) == 0;
+#endif
+		SCONE_ERROR_IF( !ok, "Could not rename " + from.str() + " to " + to.str() );
+	}
 }
@@ -21,4 +21,7 @@ namespace scone
 	SCONE_API path GetDataFolder();
 	SCONE_API path GetFolder( SconeFolder folder );
 	SCONE_API path FindFile( const path& filename );
+
+	/// Rename a file, atomically replacing the target if it exists; throws on failure.
+	SCONE_API void RenameFile( const path& from, const path& to );
 }
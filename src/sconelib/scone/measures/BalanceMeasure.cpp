@@ -22,7 +22,7 @@ namespace scone
 
 	bool BalanceMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
-		double pos = model.GetComHeight();
+		double pos = model.GetStepCache().GetComHeight();
 		if ( pos < termination_height * m_InitialHeight )
 			return true;
 
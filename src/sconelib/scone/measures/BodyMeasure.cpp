@@ -59,14 +59,14 @@ namespace scone
 		if ( !position.IsNull() )
 		{
 			auto pos = body.GetPosOfPointOnBody( offset );
-			if ( relative_to_model_com ) pos -= model.GetComPos();
+			if ( relative_to_model_com ) pos -= model.GetStepCache().GetComPos();
 			position.AddSample( timestamp, magnitude ? length( pos ) : dot_product( direction, pos ) );
 		}
 
 		if ( !velocity.IsNull() )
 		{
 			auto vel = body.GetLinVelOfPointOnBody( offset );
-			if ( relative_to_model_com ) vel -= model.GetComVel();
+			if ( relative_to_model_com ) vel -= model.GetStepCache().GetComVel();
 			velocity.AddSample( timestamp, magnitude ? length( vel ) : dot_product( direction, vel ) );
 		}
 
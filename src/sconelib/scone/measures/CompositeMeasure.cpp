@@ -75,6 +75,13 @@ namespace scone
 		return total;
 	}
 
+	void CompositeMeasure::ResetResult()
+	{
+		Measure::ResetResult();
+		for ( MeasureUP& m : m_Measures )
+			m->ResetResult();
+	}
+
 	String CompositeMeasure::GetClassSignature() const
 	{
 		std::vector< String > strset;
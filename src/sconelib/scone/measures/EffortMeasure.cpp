@@ -43,7 +43,7 @@ namespace scone
 		m_AerobicFactor = 1.5; // 1.5 is for aerobic conditions, 1.0 for anaerobic. may need to add as option later
 		m_InitComPos = model.GetComPos();
 		SetSlowTwitchRatios( props, model );
-
+		SetMuscleConstants( model );
 	}
 
 	EffortMeasure::MuscleProperties::MuscleProperties( const PropNode& props ) :
@@ -69,7 +69,7 @@ namespace scone
 
 	double EffortMeasure::ComputeResult( const Model& model )
 	{
-		double distance = std::max( min_distance, model.GetComPos().x - m_InitComPos.x );
+		double distance = std::max( min_distance, model.GetStepCache().GetComPos().x - m_InitComPos.x );
 		double cot = m_Energy.GetTotal() / ( model.GetMass() * distance );
 
 		//GetReport().set( "total", m_Energy.GetTotal() );
@@ -112,28 +112,48 @@ namespace scone
 
 	double EffortMeasure::GetWang2012( const Model& model ) const
 	{
+		const auto& muscles = model.GetMuscles();
+		const size_t n = muscles.size();
+		auto& s = m_MuscleState;
+
+		// gather muscle state
+		for ( index_t i = 0; i < n; ++i )
+		{
+			const Muscle& mus = *muscles[ i ];
+			s.excitation[ i ] = mus.GetExcitation();
+			s.activation[ i ] = mus.GetActivation();
+			s.fiber_length[ i ] = mus.GetFiberLength();
+			s.fiber_velocity[ i ] = mus.GetFiberVelocity();
+			s.force[ i ] = mus.GetForce();
+			s.active_fiber_force[ i ] = mus.GetActiveFiberForce();
+		}
+
+		// sin / cos in separate loops, so they can be vectorized by the compiler
+		for ( index_t i = 0; i < n; ++i )
+		{
+			s.sin_excitation[ i ] = sin( REAL_HALF_PI * s.excitation[ i ] );
+			s.cos_excitation[ i ] = cos( REAL_HALF_PI * s.excitation[ i ] );
+		}
+		for ( index_t i = 0; i < n; ++i )
+		{
+			s.sin_activation[ i ] = sin( REAL_HALF_PI * s.activation[ i ] );
+			s.cos_activation[ i ] = cos( REAL_HALF_PI * s.activation[ i ] );
+		}
+
 		double e = m_Wang2012BasalEnergy;
-		for ( index_t i = 0; i < model.GetMuscles().size(); ++i )
+		for ( index_t i = 0; i < n; ++i )
 		{
-			const MuscleUP& mus = model.GetMuscles()[ i ];
-			double mass = mus->GetMass( specific_tension, muscle_density );
 			Real l = m_SlowTwitchFiberRatios[ i ];
-			Real fa = 40 * l * sin( REAL_HALF_PI * mus->GetExcitation() ) + 133 * ( 1 - l ) * ( 1 - cos( REAL_HALF_PI * mus->GetExcitation() ) );
-			Real fm = 74 * l * sin( REAL_HALF_PI * mus->GetActivation() ) + 111 * ( 1 - l ) * ( 1 - cos( REAL_HALF_PI * mus->GetActivation() ) );
-			Real l_ce_norm = mus->GetFiberLength() / mus->GetOptimalFiberLength();
-			Real v_ce = mus->GetFiberVelocity();
-			Real g = 0.0;
-			if ( l_ce_norm < 0.5 )
-				g = 0.5;
-			else if ( l_ce_norm < 1.0 )
-				g = l_ce_norm;
-			else if ( l_ce_norm < 1.5 )
-				g = -2 * l_ce_norm + 3;
-
-			Real effort_a = mass * fa;
-			Real effort_m = mass * g * fm;
-			Real effort_s = xo::max( 0.0, 0.25 * mus->GetForce() * -v_ce );
-			Real effort_w = xo::max( 0.0, mus->GetActiveFiberForce() * -v_ce );
+			Real fa = 40 * l * s.sin_excitation[ i ] + 133 * ( 1 - l ) * ( 1 - s.cos_excitation[ i ] );
+			Real fm = 74 * l * s.sin_activation[ i ] + 111 * ( 1 - l ) * ( 1 - s.cos_activation[ i ] );
+			Real l_ce_norm = s.fiber_length[ i ] / m_OptimalFiberLength[ i ];
+			Real v_ce = s.fiber_velocity[ i ];
+			Real g = l_ce_norm < 0.5 ? 0.5 : ( l_ce_norm < 1.0 ? l_ce_norm : ( l_ce_norm < 1.5 ? -2 * l_ce_norm + 3 : 0.0 ) );
+
+			Real effort_a = m_MuscleMass[ i ] * fa;
+			Real effort_m = m_MuscleMass[ i ] * g * fm;
+			Real effort_s = xo::max( 0.0, 0.25 * s.force[ i ] * -v_ce );
+			Real effort_w = xo::max( 0.0, s.active_fiber_force[ i ] * -v_ce );
 			Real effort = effort_a + effort_m + effort_s + effort_w;
 
 			e += effort;
@@ -146,43 +166,62 @@ namespace scone
 	// with updates from Uchida 2016.
 	double EffortMeasure::GetUchida2016( const Model& model ) const
 	{
+		const auto& muscles = model.GetMuscles();
+		const size_t n = muscles.size();
+		auto& s = m_MuscleState;
+
+		// gather muscle state
+		for ( index_t i = 0; i < n; ++i )
+		{
+			const Muscle& mus = *muscles[ i ];
+			s.excitation[ i ] = mus.GetExcitation();
+			s.activation[ i ] = mus.GetActivation();
+			s.norm_fiber_length[ i ] = mus.GetNormalizedFiberLength();
+			s.fiber_velocity[ i ] = mus.GetFiberVelocity();
+			s.active_fiber_force[ i ] = mus.GetActiveFiberForce();
+			s.active_fl_multiplier[ i ] = mus.GetActiveForceLengthMultipler();
+		}
+
+		// sin / cos in a separate loop, so they can be vectorized by the compiler
+		for ( index_t i = 0; i < n; ++i )
+		{
+			s.sin_excitation[ i ] = sin( REAL_HALF_PI * s.excitation[ i ] );
+			s.cos_excitation[ i ] = cos( REAL_HALF_PI * s.excitation[ i ] );
+		}
+
 		double e = m_Uchida2016BasalEnergy;
-		for ( index_t i = 0; i < model.GetMuscles().size(); ++i )
+		for ( index_t i = 0; i < n; ++i )
 		{
-			const MuscleUP& mus = model.GetMuscles()[ i ];
-			double mass = mus->GetMass( specific_tension, muscle_density );
+			double mass = m_MuscleMass[ i ];
 
 			// calculate A parameter
-			Real excitation = mus->GetExcitation();
-			Real activation = mus->GetActivation();
-			double A;
-			if ( excitation > activation )
-				A = excitation;
-			else
-				A = ( excitation + activation ) / 2;
+			Real excitation = s.excitation[ i ];
+			Real activation = s.activation[ i ];
+			double A = excitation > activation ? excitation : ( excitation + activation ) / 2;
 
 			// calculate slowTwitchRatio factor
 			Real slowTwitchRatio = m_SlowTwitchFiberRatios[ i ];
-			double uSlow = slowTwitchRatio * sin( REAL_HALF_PI * excitation );
-			double uFast = ( 1 - slowTwitchRatio ) * ( 1 - cos( REAL_HALF_PI * excitation ) );
+			double uSlow = slowTwitchRatio * s.sin_excitation[ i ];
+			double uFast = ( 1 - slowTwitchRatio ) * ( 1 - s.cos_excitation[ i ] );
 			slowTwitchRatio = ( excitation == 0 ) ? 1.0 : uSlow / ( uSlow + uFast );
 
 			// calculate AMdot
 			double AMdot;
 			double unscaledAMdot = 128 * ( 1 - slowTwitchRatio ) + 25;
-			double F_iso = mus->GetActiveForceLengthMultipler();
-			if ( mus->GetNormalizedFiberLength() <= 1.0 )
+			double F_iso = s.active_fl_multiplier[ i ];
+			bool is_lengthened = s.norm_fiber_length[ i ] > 1.0;
+			if ( !is_lengthened )
 				AMdot = m_AerobicFactor * std::pow( A, 0.6 ) * unscaledAMdot;
 			else
 				AMdot = m_AerobicFactor * std::pow( A, 0.6 ) * ( ( 0.4 * unscaledAMdot ) + ( 0.6 * unscaledAMdot * F_iso ) );
 
 			// calculate shortening heat rate
 			double Sdot;
-			double Vmax_fasttwitch = mus->GetMaxContractionVelocity();
-			double Vmax_slowtwitch = mus->GetMaxContractionVelocity() / 2.5;
+			double Vmax_fasttwitch = m_MaxContractionVelocity[ i ];
+			double Vmax_slowtwitch = m_MaxContractionVelocity[ i ] / 2.5;
 			double alpha_shortening_fasttwitch = 153 / Vmax_fasttwitch;
 			double alpha_shortening_slowtwitch = 100 / Vmax_slowtwitch;
-			double fiber_velocity_normalized = mus->GetFiberVelocity() / mus->GetOptimalFiberLength();
+			double fiber_velocity_normalized = s.fiber_velocity[ i ] / m_OptimalFiberLength[ i ];
 			double unscaledSdot, tmp_slowTwitch, tmp_fastTwitch;
 
 			if ( fiber_velocity_normalized <= 0 )
@@ -201,14 +240,14 @@ namespace scone
 				Sdot = m_AerobicFactor * A * unscaledSdot;
 			}
 
-			if ( mus->GetNormalizedFiberLength() > 1.0 ) Sdot *= F_iso;
+			if ( is_lengthened ) Sdot *= F_iso;
 
-			double active_fiber_force = mus->GetActiveFiberForce();
+			double active_fiber_force = s.active_fiber_force[ i ];
 			if ( active_fiber_force < 0 ) active_fiber_force = 0;
 
 			// calculate mechanical work rate
 			double Wdot =
-				-active_fiber_force * mus->GetFiberVelocity() / mass;
+				-active_fiber_force * s.fiber_velocity[ i ] / mass;
 
 			// prevent instantaneous negative power by accounting for it through Sdot
 			double Edot_Wkg_beforeClamp = AMdot + Sdot + Wdot;
@@ -226,6 +265,28 @@ namespace scone
 		return e;
 	}
 
+	void EffortMeasure::SetMuscleConstants( const Model& model )
+	{
+		const auto& muscles = model.GetMuscles();
+		m_MuscleMass.resize( muscles.size() );
+		m_OptimalFiberLength.resize( muscles.size() );
+		m_MaxContractionVelocity.resize( muscles.size() );
+		for ( index_t i = 0; i < muscles.size(); ++i )
+		{
+			m_MuscleMass[ i ] = muscles[ i ]->GetMass( specific_tension, muscle_density );
+			m_OptimalFiberLength[ i ] = muscles[ i ]->GetOptimalFiberLength();
+			m_MaxContractionVelocity[ i ] = muscles[ i ]->GetMaxContractionVelocity();
+		}
+		m_MuscleState.Resize( muscles.size() );
+	}
+
+	void EffortMeasure::MuscleStateArrays::Resize( size_t n )
+	{
+		for ( auto* v : { &excitation, &activation, &fiber_length, &norm_fiber_length, &fiber_velocity, &force,
+			&active_fiber_force, &active_fl_multiplier, &sin_excitation, &cos_excitation, &sin_activation, &cos_activation } )
+			v->resize( n );
+	}
+
 	void EffortMeasure::SetSlowTwitchRatios( const PropNode& props, const Model& model )
 	{
 		// initialize all muscles to default
@@ -78,6 +78,30 @@ namespace scone
 		Vec3 m_InitComPos;
 		PropNode m_Report;
 		std::vector< Real > m_SlowTwitchFiberRatios;
+
+		// muscle properties that remain constant during simulation
+		std::vector< Real > m_MuscleMass;
+		std::vector< Real > m_OptimalFiberLength;
+		std::vector< Real > m_MaxContractionVelocity;
+
+		// per-step muscle state, stored as separate arrays so that energy models can be evaluated in tight loops
+		struct MuscleStateArrays {
+			void Resize( size_t n );
+			std::vector< Real > excitation;
+			std::vector< Real > activation;
+			std::vector< Real > fiber_length;
+			std::vector< Real > norm_fiber_length;
+			std::vector< Real > fiber_velocity;
+			std::vector< Real > force;
+			std::vector< Real > active_fiber_force;
+			std::vector< Real > active_fl_multiplier;
+			std::vector< Real > sin_excitation;
+			std::vector< Real > cos_excitation;
+			std::vector< Real > sin_activation;
+			std::vector< Real > cos_activation;
+		};
+		mutable MuscleStateArrays m_MuscleState;
+
 		struct MuscleProperties {
 			MuscleProperties( const PropNode& props );
 			String muscle;
@@ -89,6 +113,7 @@ namespace scone
 		double GetUchida2016( const Model& model ) const;
 		double GetTotalForce( const Model& model ) const;
 		void SetSlowTwitchRatios( const PropNode& props, const Model& model );
+		void SetMuscleConstants( const Model& model );
 		double GetSquaredMuscleStress( const Model& model ) const;
 		double GetSquaredMuscleActivation( const Model& model ) const;
 	};
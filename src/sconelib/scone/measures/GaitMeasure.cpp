@@ -55,7 +55,7 @@ namespace scone
 		SCONE_ASSERT( model.GetIntegrationStep() != model.GetPreviousIntegrationStep() );
 
 		// check termination
-		auto com_height = model.GetComHeight();
+		auto com_height = model.GetStepCache().GetComHeight();
 		if ( com_height < termination_height * m_InitialComPos.y )
 			return true;
 
@@ -70,15 +70,18 @@ namespace scone
 
 	double GaitMeasure::ComputeResult( const Model& model )
 	{
-		// add final step and penalty to min_velocity measure
+		// add final step and penalty to min_velocity measure, without changing the recorded steps
+		// so that the result can also be computed halfway through a simulation
 		// #todo: only when not at the end of the simulation?
-		AddStep( model, model.GetTime() );
+		auto gait_dist = GetGaitDist( model );
+		auto steps = steps_;
+		steps.emplace_back( Step{ model.GetTime(), gait_dist - m_PrevGaitDist } );
 
 		// precompute some values
-		double distance = GetGaitDist( model ) - m_InitGaitDist;
+		double distance = gait_dist - m_InitGaitDist;
 		double speed = distance / model.GetTime();
 		double duration = model.GetSimulationEndTime();
-		size_t step_count = steps_.size();
+		size_t step_count = steps.size();
 
 		// compute measure based on step data
 		double step_measure = 0.0;
@@ -89,19 +92,19 @@ namespace scone
 		size_t counted_steps = 0;
 		for ( int step = 0; step < step_count; ++step )
 		{
-			double dt = step > 0 ? steps_[ step ].time - steps_[ step - 1 ].time : steps_[ step ].time;
-			double step_vel = steps_[ step ].length / dt;
+			double dt = step > 0 ? steps[ step ].time - steps[ step - 1 ].time : steps[ step ].time;
+			double step_vel = steps[ step ].length / dt;
 			double step_penalty = Range< double >( min_velocity, max_velocity ).GetRangeViolation( step_vel );
 			double norm_vel = xo::clamped( 1.0 - ( fabs( step_penalty ) / min_velocity ), -1.0, 1.0 );
 
 			log::TraceF( "%.3f: step=%d vel=%.3f (%.3f/%.3f) penalty=%.3f norm_vel=%.3f %s",
-				steps_[ step ].time, step, step_vel, steps_[ step ].length, dt, step_penalty, norm_vel, step < start_step ? "" : "*" );
+				steps[ step ].time, step, step_vel, steps[ step ].length, dt, step_penalty, norm_vel, step < start_step ? "" : "*" );
 
 			if ( step >= start_step )
 			{
 				step_measure += dt * norm_vel;
 				step_time += dt;
-				step_length += steps_[ step ].length;
+				step_length += steps[ step ].length;
 				step_duration += dt;
 				counted_steps++;
 			}
@@ -138,7 +141,7 @@ namespace scone
 		// compute average of feet and Com (smallest 2 values)
 		xo::sorted_vector< double > distances;
 		distances.reserve( 3 );
-		distances.insert( model.GetComPos().x );
+		distances.insert( model.GetStepCache().GetComPos().x );
 		distances.insert( m_BaseBodies[ 0 ]->GetComPos().x );
 		distances.insert( m_BaseBodies[ 1 ]->GetComPos().x );
 		return ( distances[ 0 ] + distances[ 1 ] ) / 2;
@@ -154,15 +157,15 @@ namespace scone
 		if ( m_PrevContactState.empty() )
 		{
 			// initialize
-			for ( const LegUP& leg : model.GetLegs() )
-				m_PrevContactState.push_back( leg->GetLoad() >= load_threshold );
+			for ( size_t idx = 0; idx < model.GetLegCount(); ++idx )
+				m_PrevContactState.push_back( model.GetStepCache().GetLegLoad( idx ) >= load_threshold );
 			return false;
 		}
 
 		bool has_new_contact = false;
 		for ( size_t idx = 0; idx < model.GetLegCount(); ++idx )
 		{
-			bool contact = model.GetLeg( idx ).GetLoad() >= load_threshold;
+			bool contact = model.GetStepCache().GetLegLoad( idx ) >= load_threshold;
 			has_new_contact |= contact && !m_PrevContactState[ idx ];
 			m_PrevContactState[ idx ] = contact;
 		}
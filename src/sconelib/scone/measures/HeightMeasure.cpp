@@ -44,8 +44,8 @@ namespace scone
 	{
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
-		double pos = m_pTargetBody ? m_pTargetBody->GetComPos()[ 1 ] : model.GetComPos()[ 1 ];
-		double vel = m_pTargetBody ? m_pTargetBody->GetComVel()[ 1 ] : model.GetComVel()[ 1 ];
+		double pos = m_pTargetBody ? m_pTargetBody->GetComPos()[ 1 ] : model.GetStepCache().GetComPos()[ 1 ];
+		double vel = m_pTargetBody ? m_pTargetBody->GetComVel()[ 1 ] : model.GetStepCache().GetComVel()[ 1 ];
 
 		// add sample
 		m_Height.AddSample( timestamp, pos );
@@ -63,9 +63,9 @@ namespace scone
 
 	bool JumpMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
-		Vec3 com_pos = model.GetComPos();
-		Vec3 com_vel = model.GetComVel();
-		double grf = model.GetTotalContactForce();
+		Vec3 com_pos = model.GetStepCache().GetComPos();
+		Vec3 com_vel = model.GetStepCache().GetComVel();
+		double grf = model.GetStepCache().GetTotalContactForce();
 
 		if ( com_pos.y < termination_height * init_com.y )
 		{
@@ -161,8 +161,9 @@ namespace scone
 
 	double JumpMeasure::GetHighJumpResult( const Model& model )
 	{
-		current_pos = GetTargetPos( model );
-		peak_height = xo::max( peak_height, current_pos.y );
+		// local values, so that computing the result doesn't change the measure
+		auto current_pos = GetTargetPos( model );
+		auto peak_height = xo::max( this->peak_height, current_pos.y );
 
 		double early_jump_penalty = 100 * std::max( 0.0, prepare_com.y - init_com.y );
 		double jump_height = 100 * peak_height;
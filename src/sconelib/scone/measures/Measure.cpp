@@ -22,6 +22,12 @@ namespace scone
 		INIT_PROP( props, minimize, true );
 	}
 
+	void Measure::ResetResult()
+	{
+		result = xo::optional< double >();
+		report = PropNode();
+	}
+
 	double Measure::GetResult( const Model& model )
 	{
 		if ( !result )
@@ -41,6 +41,9 @@ namespace scone
 		double GetResult( const Model& model );
 		double GetWeightedResult( const Model& model );
 
+		/// Clear the cached result and report, so that the result can be computed again later in the simulation.
+		virtual void ResetResult();
+
 		PropNode& GetReport() { return report; }
 		const PropNode& GetReport() const { return report; }
 	
@@ -30,12 +30,12 @@ namespace scone
 		Real leg_load = 0.0f;
 		if ( use_force_per_leg )
 		{
-			for ( auto& leg : model.GetLegs() )
-				leg_load = xo::max( leg_load, xo::length( leg->GetContactForce() ) / model.GetBW() );
+			for ( index_t idx = 0; idx < model.GetLegCount(); ++idx )
+				leg_load = xo::max( leg_load, model.GetStepCache().GetLegLoad( idx ) );
 		}
 		else {
-			for ( auto& leg : model.GetLegs() )
-				leg_load += xo::length( leg->GetContactForce() ) / model.GetBW();
+			for ( index_t idx = 0; idx < model.GetLegCount(); ++idx )
+				leg_load += model.GetStepCache().GetLegLoad( idx );
 		}
 
 		AddSample( timestamp, leg_load );
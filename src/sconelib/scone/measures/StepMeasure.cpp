@@ -54,6 +54,11 @@ namespace scone
 										 load_threshold,
 										 min_stance_duration_threshold );
 
+		// penalties are computed from copies, so that computing the result doesn't change the measure
+		auto stride_length = this->stride_length;
+		auto stride_duration = this->stride_duration;
+		auto stride_velocity = this->stride_velocity;
+
 		// calculate stride length / duration / velocity
 		for ( index_t idx = initiation_cycles; idx < cycles.size(); ++idx )
 		{
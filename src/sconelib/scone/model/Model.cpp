@@ -38,6 +38,7 @@ namespace scone
 	Model::Model( const PropNode& props, Params& par ) :
 		HasSignature( props ),
 		m_Profiler( props.get<bool>( "enable_profiler", false ) ),
+		m_StepCache( *this ),
 		m_Measure( nullptr ),
 		m_Controller( nullptr ),
 		m_ShouldTerminate( false ),
@@ -74,6 +75,8 @@ namespace scone
 		INIT_PROP( props, initial_load_dof, "pelvis_ty" );
 		INIT_PROP( props, sensor_delay_scaling_factor, 1.0 );
 		INIT_PROP( props, initial_equilibration_activation, 0.05 );
+		INIT_PROP( props, enable_perf_counters, false );
+		SetPerfCounters( enable_perf_counters );
 
 		// set store data info from settings
 		m_StoreDataInterval = 1.0 / GetSconeSetting<double>( "data.frequency" );
@@ -119,6 +122,7 @@ namespace scone
 	void Model::UpdateSensorDelayAdapters()
 	{
 		SCONE_PROFILE_FUNCTION( GetProfiler() );
+		ScopedPerfCounters perf_counters( m_PerfCounters.get(), "SensorDelays" );
 
 		//SCONE_THROW_IF( GetIntegrationStep() != GetPreviousIntegrationStep() + 1, "SensorDelayAdapters should only be updated at each new integration step" );
 		SCONE_ASSERT( m_SensorDelayStorage.IsEmpty() || GetPreviousTime() == m_SensorDelayStorage.Back().GetTime() );
@@ -131,6 +135,14 @@ namespace scone
 		//log::TraceF( "Updated Sensor Delays for Int=%03d time=%.6f prev_time=%.6f", GetIntegrationStep(), GetTime(), GetPreviousTime() );
 	}
 
+	void Model::SetPerfCounters( bool enable )
+	{
+		if ( enable && !m_PerfCounters )
+			m_PerfCounters = std::make_unique< PerfCounterPhases >();
+		else if ( !enable )
+			m_PerfCounters.reset();
+	}
+
 	void Model::CreateControllers( const PropNode& pn, Params& par )
 	{
 		// add controller (new style, prefer define outside model)
@@ -211,8 +223,8 @@ namespace scone
 		// store COP data
 		if ( flags( StoreDataTypes::CenterOfMass ) )
 		{
-			auto com = GetComPos();
-			auto com_u = GetComVel();
+			const auto& com = GetStepCache().GetComPos();
+			const auto& com_u = GetStepCache().GetComVel();
 			frame[ "com_x" ] = com.x;
 			frame[ "com_y" ] = com.y;
 			frame[ "com_z" ] = com.z;
@@ -220,9 +232,8 @@ namespace scone
 			frame[ "com_y_u" ] = com_u.y;
 			frame[ "com_z_u" ] = com_u.z;
 
-			const auto mom = GetLinAngMom();
-			frame.SetVec3( "lin_mom", mom.first );
-			frame.SetVec3( "ang_mom", mom.second );
+			frame.SetVec3( "lin_mom", GetStepCache().GetLinMom() );
+			frame.SetVec3( "ang_mom", GetStepCache().GetAngMom() );
 		}
 
 		// store GRF data (measured in BW)
@@ -232,7 +243,7 @@ namespace scone
 			{
 				Vec3 force, moment, cop;
 				leg->GetContactForceMomentCop( force, moment, cop );
-				Vec3 grf = force / GetBW();
+				Vec3 grf = force / GetStepCache().GetBW();
 
 				frame[ leg->GetName() + ".grf_norm_x" ] = grf.x;
 				frame[ leg->GetName() + ".grf_norm_y" ] = grf.y;
@@ -259,6 +270,7 @@ namespace scone
 	void Model::StoreCurrentFrame()
 	{
 		SCONE_PROFILE_FUNCTION( GetProfiler() );
+		ScopedPerfCounters perf_counters( m_PerfCounters.get(), "StoreData" );
 		if ( m_Data.IsEmpty() || GetTime() > m_Data.Back().GetTime() )
 			m_Data.AddFrame( GetTime() );
 		StoreData( m_Data.Back(), m_StoreDataFlags );
@@ -279,6 +291,7 @@ namespace scone
 	void Model::UpdateControlValues()
 	{
 		SCONE_PROFILE_FUNCTION( GetProfiler() );
+		ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Controls" );
 
 		// reset actuator values
 		for ( Actuator* a : GetActuators() )
@@ -295,6 +308,7 @@ namespace scone
 	void Model::UpdateAnalyses()
 	{
 		SCONE_PROFILE_FUNCTION( GetProfiler() );
+		ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Analyses" );
 
 		bool terminate = false;
 		if ( auto* c = GetController() )
@@ -17,12 +17,14 @@
 #include "ContactGeometry.h"
 #include "ForceValue.h"
 #include "Leg.h"
+#include "ModelStepCache.h"
 #include "Sensor.h"
 
 #include "scone/controllers/Controller.h"
 #include "scone/core/HasExternalResources.h"
 #include "scone/core/HasName.h"
 #include "scone/core/HasSignature.h"
+#include "scone/core/PerfCounters.h"
 #include "scone/core/Storage.h"
 #include "scone/measures/Measure.h"
 
@@ -133,6 +135,10 @@ namespace scone
 		virtual Real GetTotalEnergyConsumption() const { SCONE_THROW_NOT_IMPLEMENTED; }
 		virtual Real GetTotalContactForce() const;
 
+		// aggregate model statistics, computed once per integration step
+		const ModelStepCache& GetStepCache() const { return m_StepCache; }
+		void InvalidateStepCache() { m_StepCache.Invalidate(); }
+
 		// get static model info
 		virtual Real GetMass() const = 0;
 		virtual Vec3 GetGravity() const = 0;
@@ -201,6 +207,9 @@ namespace scone
 		/// Activation used to equilibrate muscles before control inputs are known; default = 0.05
 		Real initial_equilibration_activation;
 
+		/// Measure hardware performance counters (instructions, cycles, cache and branch misses) per simulation phase, if supported by the system; default = false.
+		bool enable_perf_counters;
+
 		void SetStoreData( bool store ) { m_StoreData = store; }
 		bool GetStoreData() const;
 		StoreDataFlags& GetStoreDataFlags() { return m_StoreDataFlags; }
@@ -208,6 +217,10 @@ namespace scone
 
 		xo::profiler& GetProfiler() const { return m_Profiler; }
 
+		/// Enable or disable hardware performance counters for the simulation phases.
+		void SetPerfCounters( bool enable );
+		const PerfCounterPhases* GetPerfCounters() const { return m_PerfCounters.get(); }
+
 	protected:
 		virtual String GetClassSignature() const override;
 		void UpdateSensorDelayAdapters();
@@ -220,6 +233,8 @@ namespace scone
 
 	protected:
 		mutable xo::profiler m_Profiler;
+		std::unique_ptr< PerfCounterPhases > m_PerfCounters;
+		ModelStepCache m_StepCache;
 
 		std::vector< MuscleUP > m_Muscles;
 		std::vector< BodyUP > m_Bodies;
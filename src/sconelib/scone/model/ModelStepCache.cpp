@@ -0,0 +1,121 @@
+/*
+** ModelStepCache.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ModelStepCache.h"
+#include "Model.h"
+#include "Leg.h"
+
+#include <tuple>
+
+namespace scone
+{
+	ModelStepCache::ModelStepCache( const Model& model ) :
+		model_( model ),
+		step_( -1 ),
+		time_( 0.0 ),
+		valid_flags_( 0 ),
+		com_height_( 0.0 ),
+		body_weight_( 0.0 ),
+		total_contact_force_( 0.0 )
+	{}
+
+	bool ModelStepCache::Validate( Item item ) const
+	{
+		if ( model_.GetIntegrationStep() != step_ || model_.GetTime() != time_ )
+		{
+			step_ = model_.GetIntegrationStep();
+			time_ = model_.GetTime();
+			valid_flags_ = 0;
+		}
+
+		if ( valid_flags_ & item )
+			return true;
+
+		valid_flags_ |= item;
+		return false;
+	}
+
+	const Vec3& ModelStepCache::GetComPos() const
+	{
+		if ( !Validate( ComPosItem ) )
+			com_pos_ = model_.GetComPos();
+		return com_pos_;
+	}
+
+	const Vec3& ModelStepCache::GetComVel() const
+	{
+		if ( !Validate( ComVelItem ) )
+			com_vel_ = model_.GetComVel();
+		return com_vel_;
+	}
+
+	Real ModelStepCache::GetComHeight() const
+	{
+		if ( !Validate( ComHeightItem ) )
+			com_height_ = model_.GetComHeight();
+		return com_height_;
+	}
+
+	const Vec3& ModelStepCache::GetLinMom() const
+	{
+		if ( !Validate( MomentumItem ) )
+			std::tie( lin_mom_, ang_mom_ ) = model_.GetLinAngMom();
+		return lin_mom_;
+	}
+
+	const Vec3& ModelStepCache::GetAngMom() const
+	{
+		if ( !Validate( MomentumItem ) )
+			std::tie( lin_mom_, ang_mom_ ) = model_.GetLinAngMom();
+		return ang_mom_;
+	}
+
+	Real ModelStepCache::GetBW() const
+	{
+		if ( !Validate( BodyWeightItem ) )
+			body_weight_ = model_.GetBW();
+		return body_weight_;
+	}
+
+	const Vec3& ModelStepCache::GetLegContactForce( index_t leg_idx ) const
+	{
+		if ( !Validate( LegForceItem ) )
+			UpdateLegForces();
+		return leg_forces_[ leg_idx ];
+	}
+
+	Real ModelStepCache::GetLegLoad( index_t leg_idx ) const
+	{
+		if ( !Validate( LegForceItem ) )
+			UpdateLegForces();
+		return leg_loads_[ leg_idx ];
+	}
+
+	Real ModelStepCache::GetTotalContactForce() const
+	{
+		if ( !Validate( LegForceItem ) )
+			UpdateLegForces();
+		return total_contact_force_;
+	}
+
+	void ModelStepCache::UpdateLegForces() const
+	{
+		const auto& legs = model_.GetLegs();
+		const auto bw = GetBW();
+		leg_forces_.resize( legs.size() );
+		leg_loads_.resize( legs.size() );
+		total_contact_force_ = 0.0;
+		for ( index_t i = 0; i < legs.size(); ++i )
+		{
+			leg_forces_[ i ] = legs[ i ]->GetContactForce();
+			auto force = xo::length( leg_forces_[ i ] );
+			leg_loads_[ i ] = force / bw;
+			total_contact_force_ += force;
+		}
+	}
+}
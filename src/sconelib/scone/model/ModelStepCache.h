@@ -0,0 +1,60 @@
+/*
+** ModelStepCache.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "scone/core/Vec3.h"
+
+#include <vector>
+
+namespace scone
+{
+	/// Aggregate model quantities that are computed at most once per integration step.
+	/** Values are invalidated automatically when the integration step or time of the model changes,
+	and explicitly by the model when its state is modified. */
+	class SCONE_API ModelStepCache
+	{
+	public:
+		ModelStepCache( const Model& model );
+
+		const Vec3& GetComPos() const;
+		const Vec3& GetComVel() const;
+		Real GetComHeight() const;
+		const Vec3& GetLinMom() const;
+		const Vec3& GetAngMom() const;
+		Real GetBW() const;
+
+		const Vec3& GetLegContactForce( index_t leg_idx ) const;
+		Real GetLegLoad( index_t leg_idx ) const;
+		Real GetTotalContactForce() const;
+
+		void Invalidate() { valid_flags_ = 0; }
+
+	private:
+		enum Item { ComPosItem = 1, ComVelItem = 2, ComHeightItem = 4, MomentumItem = 8, BodyWeightItem = 16, LegForceItem = 32 };
+		bool Validate( Item item ) const;
+		void UpdateLegForces() const;
+
+		const Model& model_;
+		mutable int step_;
+		mutable TimeInSeconds time_;
+		mutable unsigned int valid_flags_;
+
+		mutable Vec3 com_pos_;
+		mutable Vec3 com_vel_;
+		mutable Real com_height_;
+		mutable Vec3 lin_mom_;
+		mutable Vec3 ang_mom_;
+		mutable Real body_weight_;
+		mutable std::vector< Vec3 > leg_forces_;
+		mutable std::vector< Real > leg_loads_;
+		mutable Real total_contact_force_;
+	};
+}
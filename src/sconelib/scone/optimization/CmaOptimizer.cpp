@@ -7,6 +7,8 @@
 */
 
 #include "CmaOptimizer.h"
+#include "SearchDistribution.h"
+#include "scone/core/system_tools.h"
 #include "xo/string/string_tools.h"
 #include "xo/filesystem/filesystem.h"
 
@@ -27,6 +29,16 @@ namespace scone
 		INIT_PROP( props, window_size, 500 );
 		INIT_PROP( props, random_seed, DEFAULT_RANDOM_SEED );
 		INIT_PROP( props, flat_fitness_epsilon_, 1e-6 );
+		INIT_PROP( props, init_distribution, path( "" ) );
+		INIT_PROP( props, init_distribution_regularization, 0.05 );
+
+		// initialize from a previous search distribution, before the CMA-ES is initialized by the derived class
+		if ( !init_distribution.empty() )
+		{
+			init_distribution = FindFile( init_distribution );
+			auto dist = SearchDistribution::Load( init_distribution );
+			init_correlation_ = dist.ApplyTo( GetObjective().info(), init_distribution_regularization );
+		}
 	}
 
 	CmaOptimizer::~CmaOptimizer()
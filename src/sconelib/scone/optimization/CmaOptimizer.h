@@ -45,6 +45,18 @@ namespace scone
 
 		int max_attempts;
 
+		/// Search distribution file (search_distribution.txt) of a previous optimization, used to initialize
+		/// mean, std and parameter correlations; parameters are matched by name. Correlations are only used with
+		/// async_evaluation, because the regular CMA-ES cannot be initialized with a covariance matrix; default = "".
+		path init_distribution;
+
+		/// Fraction by which correlations from init_distribution are shrunk towards zero; default = 0.05.
+		double init_distribution_regularization;
+
+	protected:
+		// correlation matrix of the initial distribution, in coordinates normalized by the objective info
+		std::vector< double > init_correlation_;
+
 	private: // non-copyable and non-assignable
 		virtual String GetClassSignature() const override;
 	};
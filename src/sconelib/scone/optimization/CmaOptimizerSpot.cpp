@@ -9,25 +9,196 @@
 #include "CmaOptimizerSpot.h"
 
 #include "spot/stop_condition.h"
-#include "spot/file_reporter.h"
 #include "spot/console_reporter.h"
 
 #include "scone/core/Exception.h"
 #include "scone/core/Log.h"
+#include "scone/core/ProfileAggregator.h"
+#include "scone/core/ProfileTimeline.h"
 #include "scone/core/Settings.h"
 #include "spot/async_evaluator.h"
 #include "spot/pooled_evaluator.h"
 #include "spot/batch_evaluator.h"
+#include "FairShareEvaluator.h"
+#include "ModelObjective.h"
+#include "NetworkEvaluator.h"
+#include "ProcessPoolEvaluator.h"
+#include "ScheduledEvaluator.h"
+#include "SearchDistribution.h"
+#include "SteadyStateCma.h"
+#include "SurrogateEvaluator.h"
+#include "xo/filesystem/filesystem.h"
+#include "xo/string/string_tools.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 namespace scone
 {
-	CmaOptimizerSpot::CmaOptimizerSpot( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir ) :
+	// candidates are pre-screened by a surrogate model if surrogate_fraction < 1
+	static spot::evaluator& WithScreening( const PropNode& pn, spot::evaluator& eval )
+	{
+		if ( pn.get< double >( "surrogate_fraction", 1.0 ) < 1.0 )
+			return SurrogateEvaluator::GetInstance( eval );
+		else return eval;
+	}
+
+	// default number of candidates per generation of CMA-ES
+	static int GetDefaultLambda( int lambda, size_t dim )
+	{
+		return lambda > 0 ? lambda : 4 + int( 3 * std::log( double( dim ) ) );
+	}
+
+	// with pre-screening, lambda / surrogate_fraction candidates are sampled, of which lambda are evaluated
+	static int GetSampleCount( const PropNode& pn, int lambda, size_t dim )
+	{
+		auto fraction = pn.get< double >( "surrogate_fraction", 1.0 );
+		if ( fraction > 0.0 && fraction < 1.0 )
+			return int( std::ceil( GetDefaultLambda( lambda, dim ) / fraction ) );
+		else return lambda;
+	}
+
+	// summary of the aggregated profile, if profiling is enabled
+	static void SetProfileStatus( const Optimizer& o, PropNode& pn )
+	{
+		if ( o.profile_interval > 0 )
+		{
+			auto& pa = ProfileAggregator::GetInstance();
+			pn.set( "profile_hotspots", pa.GetHotspots( &o.GetObjective(), 5 ) );
+			pn.set( "profile_thread_imbalance", pa.GetThreadImbalance( &o.GetObjective() ) );
+		}
+	}
+
+	// percentiles of the evaluations since the previous report, added to the status and to telemetry.txt
+	static void ReportTelemetry( const Optimizer& o, index_t step, PropNode* pn, AsyncOutputWriter& writer )
+	{
+		auto* mo = dynamic_cast<const ModelObjective*>( &o.GetObjective() );
+		if ( !mo || !mo->GetTelemetry().IsEnabled() )
+			return;
+		auto records = mo->GetTelemetry().Collect();
+		if ( records.empty() )
+			return;
+
+		auto dropped = mo->GetTelemetry().GetDroppedCount();
+		if ( pn )
+		{
+			auto& summary = pn->add_child( "telemetry", EvaluationTelemetry::GetSummary( records, mo->GetDuration() ) );
+			summary.set( "dropped", dropped );
+		}
+
+		// lines are appended in order, so each generation has its own key
+		writer.Enqueue( xo::stringf( "telemetry%d", int( step ) ),
+			[filename = o.GetOutputFolder() / "telemetry.txt", line = EvaluationTelemetry::GetLogLine( step, records, mo->GetDuration(), dropped )]() {
+				bool write_header = !xo::file_exists( filename );
+				std::ofstream str( filename.str(), std::ios_base::app );
+				SCONE_ERROR_IF( !str.good(), "Could not open " + filename.str() );
+				if ( write_header )
+					str << EvaluationTelemetry::GetLogHeader() << '\n';
+				str << line << '\n';
+			} );
+	}
+
+	// state shared by the evaluation threads of an asynchronous optimization
+	struct CmaOptimizerSpot::AsyncState
+	{
+		AsyncState( size_t dim, int lambda, double sigma, long random_seed, bool minimize ) :
+			cma( dim, lambda, sigma, random_seed, minimize ),
+			running_threads( 0 )
+		{}
+
+		// evaluations of a generation, and the resulting search distribution
+		struct Generation { search_point_vec points; fitness_vec fitnesses; SearchDistribution distribution; };
+
+		SteadyStateCma cma;
+		search_point_vec points;
+		fitness_vec fitnesses;
+		std::deque< Generation > generations;
+		String stop_reason;
+		int running_threads;
+		std::mutex mutex;
+		std::condition_variable generation_cv;
+	};
+
+	// updates the statistics of the evaluated candidates of a CmaOptimizerSpot
+	class EvaluatedStatisticsReporter : public spot::reporter
+	{
+	public:
+		EvaluatedStatisticsReporter( CmaOptimizerSpot& target ) : target_( target ) {}
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override {
+			target_.UpdateEvaluatedStatistics( fitnesses );
+		}
+
+	private:
+		CmaOptimizerSpot& target_;
+	};
+
+	// stops when the average evaluated fitness no longer improves
+	struct EvaluatedProgressCondition : public spot::stop_condition
+	{
+		EvaluatedProgressCondition( double min_progress, size_t min_samples ) : min_progress_( min_progress ), min_samples_( min_samples ) {}
+		virtual String what() const override { return "Minimum progress reached"; }
+		virtual bool test( const optimizer& opt ) override {
+			auto& cma = dynamic_cast<const CmaOptimizerSpot&>( opt );
+			return opt.current_step() >= min_samples_ && cma.GetEvaluatedProgress() < min_progress_;
+		}
+
+	private:
+		double min_progress_;
+		size_t min_samples_;
+	};
+
+	// stops when all evaluated fitnesses of a generation are equal
+	struct EvaluatedFlatFitnessCondition : public spot::stop_condition
+	{
+		EvaluatedFlatFitnessCondition( double epsilon ) : epsilon_( epsilon ) {}
+		virtual String what() const override { return "Flat fitness"; }
+		virtual bool test( const optimizer& opt ) override {
+			auto& f = dynamic_cast<const CmaOptimizerSpot&>( opt ).GetEvaluatedFitnesses();
+			if ( f.size() < 2 )
+				return false;
+			auto [min_it, max_it] = std::minmax_element( f.begin(), f.end() );
+			return *max_it - *min_it <= epsilon_;
+		}
+
+	private:
+		double epsilon_;
+	};
+
+	// asynchronous evaluations are done by the evaluation threads, which pass their results to spot through a PrecomputedEvaluator
+	// other evaluations go through a GenerationEvaluator, so that the objective can adjust the results of a generation
+	static spot::evaluator& WithAsyncEvaluation( const PropNode& pn, GenerationEvaluator& generation_eval, PrecomputedEvaluator& precomputed_eval )
+	{
+		if ( pn.get< bool >( "async_evaluation", false ) )
+			return precomputed_eval;
+		else return generation_eval;
+	}
+
+	CmaOptimizerSpot::CmaOptimizerSpot( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir, spot::evaluator* eval ) :
 		CmaOptimizer( pn, scenario_pn, scenario_dir ),
-		cma_optimizer( *m_Objective, GetEvaluator(), spot::cma_options{ CmaOptimizer::lambda_, CmaOptimizer::random_seed, spot::cma_weights::log } )
+		cma_optimizer( *m_Objective, WithAsyncEvaluation( pn, generation_evaluator_, precomputed_evaluator_ ),
+			spot::cma_options{ GetSampleCount( pn, CmaOptimizer::lambda_, m_Objective->dim() ), CmaOptimizer::random_seed, spot::cma_weights::log } ),
+		evaluator_( WithScreening( pn, eval ? *eval : GetEvaluator() ) ),
+		generation_evaluator_( *m_Objective, evaluator_ ),
+		evaluated_progress_( std::numeric_limits< double >::quiet_NaN() )
 	{
+		INIT_PROP( pn, async_evaluation, false );
+		INIT_PROP( pn, surrogate_fraction, 1.0 );
+		INIT_PROP( pn, surrogate_random_fraction, 0.1 );
+		INIT_PROP( pn, surrogate_min_correlation, 0.3 );
+		INIT_PROP( pn, surrogate_archive_size, 0 );
+
 		size_t dim = GetObjective().dim();
 		SCONE_ASSERT( dim > 0 );
 
+		auto evaluations = GetDefaultLambda( lambda_, dim );
 		lambda_ = lambda();
 		mu_ = mu();
 		sigma_ = sigma();
@@ -38,10 +209,67 @@ namespace scone
 
 		enable_fitness_tracking( window_size );
 
+		if ( !init_distribution.empty() && !async_evaluation )
+			log::info( "Using mean and std of ", init_distribution.filename(), ", correlations require async_evaluation" );
+		SCONE_ERROR_IF( async_evaluation && surrogate_fraction < 1.0, "surrogate_fraction cannot be used with async_evaluation" );
+		if ( m_Objective->AdjustsGenerationResults() )
+		{
+			// the objective keeps track of the evaluations of a generation, which must take place in this process
+			auto* target = &evaluator_;
+			if ( auto* se = dynamic_cast<SurrogateEvaluator*>( target ) )
+				target = &se->GetTarget();
+			SCONE_ERROR_IF( async_evaluation || dynamic_cast<NetworkEvaluator*>( target ),
+				"short_horizon cannot be used with async_evaluation, network or process evaluation" );
+		}
+
+		if ( auto* se = dynamic_cast<SurrogateEvaluator*>( &evaluator_ ) )
+		{
+			// lambda is the number of evaluated candidates, the optimizer samples lambda / surrogate_fraction
+			SurrogateEvaluator::Options opt;
+			opt.fraction = surrogate_fraction;
+			opt.random_fraction = surrogate_random_fraction;
+			opt.min_correlation = surrogate_min_correlation;
+			opt.min_evaluations = evaluations;
+			opt.archive_size = surrogate_archive_size > 0 ? surrogate_archive_size : 4 * lambda_;
+			se->SetOptions( GetObjective(), opt );
+		}
+
+		// statistics of the evaluated candidates are updated before the other reporters
+		add_reporter( std::make_unique< EvaluatedStatisticsReporter >( *this ) );
+
+		// objectives can compare the candidates of a generation
+		add_reporter( std::make_unique< GenerationReporter >( GetObjective() ) );
+
 		// stop conditions
 		add_stop_condition( std::make_unique< spot::max_steps_condition >( max_generations ) );
-		add_stop_condition( std::make_unique< spot::min_progress_condition >( min_progress, min_progress_samples ) );
 		find_stop_condition< spot::flat_fitness_condition >().epsilon_ = flat_fitness_epsilon_;
+		if ( surrogate_fraction < 1.0 )
+		{
+			// placeholder fitnesses of screened candidates are excluded from the convergence tests
+			add_stop_condition( std::make_unique< EvaluatedProgressCondition >( min_progress, min_progress_samples ) );
+			add_stop_condition( std::make_unique< EvaluatedFlatFitnessCondition >( flat_fitness_epsilon_ ) );
+		}
+		else add_stop_condition( std::make_unique< spot::min_progress_condition >( min_progress, min_progress_samples ) );
+	}
+
+	CmaOptimizerSpot::~CmaOptimizerSpot()
+	{
+		// evaluators keep data per objective, which must be removed before the objective is destroyed
+		auto* eval = &evaluator_;
+		if ( auto* se = dynamic_cast<SurrogateEvaluator*>( eval ) )
+		{
+			se->RemoveObjective( GetObjective() );
+			eval = &se->GetTarget();
+		}
+		if ( auto* se = dynamic_cast<ScheduledEvaluator*>( eval ) )
+		{
+			// the shared evaluator receives the wrapper of the objective
+			if ( auto* fse = dynamic_cast<FairShareEvaluator*>( &se->GetTarget() ) )
+				fse->RemoveObjective( se->GetTargetObjective( GetObjective() ) );
+			se->RemoveObjective( GetObjective() );
+		}
+		else if ( auto* fse = dynamic_cast<FairShareEvaluator*>( eval ) )
+			fse->RemoveObjective( GetObjective() );
 	}
 
 	void CmaOptimizerSpot::SetOutputMode( OutputMode m )
@@ -54,6 +282,7 @@ namespace scone
 			break;
 		case Optimizer::console_output:
 			add_reporter( std::make_unique<spot::console_reporter>() );
+			add_reporter( std::make_unique<TelemetryReporter>( *this ) );
 			break;
 		case Optimizer::status_console_output:
 		case Optimizer::status_queue_output:
@@ -68,11 +297,312 @@ namespace scone
 		// create output folder
 		PrepareOutputFolder();
 
+		// send scenario to remote workers
+		auto* eval = &evaluator_;
+		if ( auto* se = dynamic_cast<SurrogateEvaluator*>( eval ) )
+			eval = &se->GetTarget();
+		if ( auto* ne = dynamic_cast<NetworkEvaluator*>( eval ) )
+			ne->SetScenario( GetObjective(), scenario_pn_copy_, GetOutputFolder() );
+
+		// profiles are recorded by all threads in this process, and flushed per objective after each evaluation
+		if ( profile_interval > 0 )
+			ProfileAggregator::GetInstance().SetActive( &GetObjective(), true );
+		if ( profile_timeline_events > 0 )
+			ProfileTimeline::GetInstance().Start( profile_timeline_events );
+
+		// evaluation telemetry is reported per generation, if enabled and there is output
+		if ( auto* mo = dynamic_cast<ModelObjective*>( m_Objective.get() ) )
+			mo->GetTelemetry().SetEnabled( evaluation_telemetry && output_mode_ != no_output );
+
 		// create file reporter
-		add_reporter( std::make_unique< spot::file_reporter >(
+		add_reporter( std::make_unique< AsyncFileReporter >(
 			GetOutputFolder(), min_improvement_for_file_output, max_generations_without_file_output ) );
+		if ( checkpoint_interval > 0 && IsDeterministic() )
+			add_reporter( std::make_unique< CheckpointReporter >( *this, checkpoint_interval ) );
+		else if ( checkpoint_interval > 0 )
+			log::warning( "Checkpoints are disabled because the optimization is not deterministic" );
+		if ( use_fitness_cache && fitness_cache_save_interval > 0 )
+			add_reporter( std::make_unique< FitnessCacheReporter >( *this, fitness_cache_save_interval ) );
+		if ( profile_interval > 0 )
+			add_reporter( std::make_unique< ProfileReporter >( *this, profile_interval ) );
+
+		add_reporter( std::make_unique< SearchDistributionReporter >(
+			GetOutputFolder() / "search_distribution.txt", max_generations_without_file_output ) );
+
+		if ( async_evaluation )
+		{
+			RunAsync();
+		}
+		else run();
+
+		SaveFitnessCache();
+		if ( profile_interval > 0 )
+		{
+			SaveProfile();
+			ProfileAggregator::GetInstance().SetActive( &GetObjective(), false );
+		}
+		if ( profile_timeline_events > 0 )
+		{
+			ProfileTimeline::GetInstance().Stop();
+			SaveProfileTimeline();
+		}
+	}
+
+	// stops an asynchronous optimization after its evaluation threads have stopped
+	struct AsyncStopCondition : public spot::stop_condition
+	{
+		AsyncStopCondition( String& reason, std::mutex& mutex ) : reason_( reason ), mutex_( mutex ) {}
+		virtual String what() const override { std::scoped_lock lock( mutex_ ); return reason_; }
+		virtual bool test( const optimizer& opt ) override { std::scoped_lock lock( mutex_ ); return !reason_.empty(); }
+
+	private:
+		String& reason_;
+		std::mutex& mutex_;
+	};
+
+	// search distribution in parameter units, cma coordinates are normalized by the initial mean and std
+	static SearchDistribution GetDistribution( const SteadyStateCma& cma, const spot::objective_info& info )
+	{
+		const auto n = info.dim();
+		const auto var = cma.sigma() * cma.sigma();
+		SearchDistribution dist;
+		dist.covariance.resize( n * n );
+		for ( index_t i = 0; i < n; ++i )
+		{
+			dist.names.push_back( info[ i ].name );
+			dist.mean.push_back( info[ i ].mean + info[ i ].std * cma.mean()[ i ] );
+			for ( index_t j = 0; j < n; ++j )
+				dist.covariance[ i * n + j ] = var * info[ i ].std * info[ j ].std * cma.covariance()[ i * n + j ];
+		}
+		return dist;
+	}
+
+	void CmaOptimizerSpot::RunAsync()
+	{
+		const auto& info = GetObjective().info();
+		async_ = std::make_unique< AsyncState >( info.dim(), lambda_, sigma_, random_seed, IsMinimizing() );
+		if ( !init_correlation_.empty() )
+			async_->cma.SetCovariance( init_correlation_ );
+		async_distribution_ = GetDistribution( async_->cma, info );
+
+		auto num_threads = GetSconeSetting<int>( "optimizer.max_threads" );
+		if ( num_threads <= 0 )
+			num_threads = std::max( 1, int( std::thread::hardware_concurrency() ) );
+		num_threads = std::min( num_threads, int( max_threads ) );
+		log::info( "Evaluating asynchronously using ", num_threads, " threads" );
+
+		// the evaluation threads produce generations, which are reported in internal_step() by run()
+		add_stop_condition( std::make_unique< AsyncStopCondition >( async_->stop_reason, async_->mutex ) );
+		async_->running_threads = num_threads;
+		std::vector< std::thread > threads;
+		for ( int i = 0; i < num_threads; ++i )
+			threads.emplace_back( &CmaOptimizerSpot::RunAsyncWorker, this );
 
 		run();
+
+		// interrupt the evaluations that are still running, their results are not used
+		async_stop_token_.request_stop();
+		async_->generation_cv.notify_all();
+		for ( auto& t : threads )
+			t.join();
+	}
+
+	void CmaOptimizerSpot::RunAsyncWorker()
+	{
+		auto& a = *async_;
+		const auto& info = GetObjective().info();
+		const size_t dim = info.dim();
+		while ( true )
+		{
+			SteadyStateCma::vec_t u;
+			{
+				std::scoped_lock lock( a.mutex );
+				if ( !a.stop_reason.empty() || async_stop_token_.stop_requested() )
+					break;
+				u = a.cma.Sample();
+			}
+
+			// candidates are sampled in coordinates normalized by the initial mean and std
+			spot::par_vec values( dim );
+			for ( index_t i = 0; i < dim; ++i )
+				values[ i ] = std::clamp( info[ i ].mean + info[ i ].std * u[ i ], info[ i ].min, info[ i ].max );
+			spot::search_point_vec points{ SearchPoint( info, values ) };
+
+			fitness_t fitness = info.worst_fitness();
+			try
+			{
+				auto results = evaluator_.evaluate( GetObjective(), points, async_stop_token_, spot::priority_t() );
+				if ( async_stop_token_.stop_requested() )
+					break;
+				if ( !results.empty() && results.front() )
+					fitness = results.front().value();
+			}
+			catch ( std::exception& e )
+			{
+				// stop the optimization, the other threads are interrupted
+				std::scoped_lock lock( a.mutex );
+				if ( a.stop_reason.empty() )
+					a.stop_reason = String( "Error during evaluation: " ) + e.what();
+				break;
+			}
+
+			SteadyStateCma::vec_t covariance;
+			{
+				std::scoped_lock lock( a.mutex );
+				a.points.push_back( std::move( points.front() ) );
+				a.fitnesses.push_back( fitness );
+				if ( a.cma.Tell( u, fitness ) )
+				{
+					a.generations.push_back( { std::move( a.points ), std::move( a.fitnesses ), GetDistribution( a.cma, info ) } );
+					a.points.clear();
+					a.fitnesses.clear();
+					a.generation_cv.notify_all();
+				}
+				covariance = a.cma.GetPendingDecomposition();
+			}
+
+			// the eigen decomposition is computed without blocking the other threads
+			if ( !covariance.empty() )
+			{
+				auto decomposition = SteadyStateCma::Decompose( dim, covariance );
+				std::scoped_lock lock( a.mutex );
+				a.cma.SetDecomposition( std::move( decomposition ) );
+			}
+		}
+
+		std::scoped_lock lock( a.mutex );
+		if ( a.stop_reason.empty() && async_stop_token_.stop_requested() )
+			a.stop_reason = "Optimization interrupted";
+		if ( --a.running_threads == 0 )
+			a.generation_cv.notify_all();
+	}
+
+	void CmaOptimizerSpot::internal_step()
+	{
+		if ( !async_ )
+			return cma_optimizer::internal_step();
+
+		// wait for the next generation of the evaluation threads
+		AsyncState::Generation gen;
+		{
+			std::unique_lock lock( async_->mutex );
+			async_->generation_cv.wait( lock, [&]() { return !async_->generations.empty() || async_->running_threads == 0; } );
+			if ( async_->generations.empty() )
+				return; // the evaluation threads have stopped, AsyncStopCondition ends the optimization
+			gen = std::move( async_->generations.front() );
+			async_->generations.pop_front();
+		}
+
+		// the fitnesses are passed on by precomputed_evaluator_, so that reporters, statistics and stop conditions are updated
+		async_distribution_ = std::move( gen.distribution );
+		precomputed_evaluator_.fitnesses = std::move( gen.fitnesses );
+		evaluate( gen.points );
+	}
+
+	void CmaOptimizerSpot::StopAsync()
+	{
+		async_stop_token_.request_stop();
+	}
+
+	spot::par_vec CmaOptimizerSpot::GetCurrentMean() const
+	{
+		return async_ ? async_distribution_.mean : current_mean();
+	}
+
+	spot::par_vec CmaOptimizerSpot::GetCurrentStd() const
+	{
+		if ( !async_ )
+			return current_std();
+		spot::par_vec stds( async_distribution_.dim() );
+		for ( index_t i = 0; i < stds.size(); ++i )
+			stds[ i ] = async_distribution_.GetStd( i );
+		return stds;
+	}
+
+	SearchDistribution CmaOptimizerSpot::GetSearchDistribution() const
+	{
+		if ( async_ )
+			return async_distribution_;
+
+		// the regular CMA-ES only provides mean and std, so the distribution has no correlations
+		const auto& info = GetObjective().info();
+		const auto n = info.dim();
+		auto mean = current_mean();
+		auto stds = current_std();
+		SearchDistribution dist;
+		dist.covariance.resize( n * n, 0.0 );
+		for ( index_t i = 0; i < n; ++i )
+		{
+			dist.names.push_back( info[ i ].name );
+			dist.mean.push_back( mean[ i ] );
+			dist.covariance[ i * n + i ] = stds[ i ] * stds[ i ];
+		}
+		return dist;
+	}
+
+	double CmaOptimizerSpot::GetEvaluatedAverage() const
+	{
+		if ( evaluated_fitnesses_.empty() )
+			return std::numeric_limits< double >::quiet_NaN();
+		return std::accumulate( evaluated_fitnesses_.begin(), evaluated_fitnesses_.end(), 0.0 ) / evaluated_fitnesses_.size();
+	}
+
+	void CmaOptimizerSpot::UpdateEvaluatedStatistics( const fitness_vec& fitnesses )
+	{
+		// screened candidates have a placeholder fitness, which is not included
+		std::vector< bool > evaluated;
+		if ( auto* se = dynamic_cast<SurrogateEvaluator*>( &evaluator_ ) )
+			evaluated = se->GetLastEvaluated( GetObjective() );
+		evaluated_fitnesses_.clear();
+		for ( index_t i = 0; i < fitnesses.size(); ++i )
+			if ( evaluated.size() != fitnesses.size() || evaluated[ i ] )
+				evaluated_fitnesses_.push_back( fitnesses[ i ] );
+
+		// progress is the slope of the average fitness over the last generations, relative to its current value
+		evaluated_averages_.push_back( GetEvaluatedAverage() );
+		while ( evaluated_averages_.size() > std::max( window_size, size_t( 2 ) ) )
+			evaluated_averages_.pop_front();
+		const auto n = evaluated_averages_.size();
+		if ( n < 2 )
+		{
+			evaluated_progress_ = std::numeric_limits< double >::quiet_NaN();
+			return;
+		}
+		const double x_mean = ( n - 1 ) / 2.0;
+		const double y_mean = std::accumulate( evaluated_averages_.begin(), evaluated_averages_.end(), 0.0 ) / n;
+		double sxy = 0.0, sxx = 0.0;
+		for ( index_t i = 0; i < n; ++i )
+		{
+			sxy += ( i - x_mean ) * ( evaluated_averages_[ i ] - y_mean );
+			sxx += ( i - x_mean ) * ( i - x_mean );
+		}
+		const double slope = sxy / sxx;
+		const double offset = y_mean + slope * ( n - 1 - x_mean );
+		const double improvement = IsMinimizing() ? -slope : slope;
+		evaluated_progress_ = offset != 0.0 ? improvement / std::abs( offset ) : improvement;
+	}
+
+	std::vector< result< fitness_t > > GenerationEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		auto results = target_.evaluate( o, point_vec, st, prio );
+		if ( &o == &objective_ && !st.stop_requested() )
+			objective_.EndGeneration( point_vec, results );
+		return results;
+	}
+
+	std::vector< result< fitness_t > > PrecomputedEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		SCONE_ASSERT( fitnesses.size() == point_vec.size() );
+		return std::vector< result< fitness_t > >( fitnesses.begin(), fitnesses.end() );
+	}
+
+	// returns target wrapped in a ScheduledEvaluator, which records the evaluation times,
+	// and dispatches the longest evaluations first if enabled
+	template< typename E > static spot::evaluator& WithScheduling( E& target )
+	{
+		static ScheduledEvaluator scheduled_eval( target );
+		scheduled_eval.SetLongestFirst( GetSconeSetting<bool>( "optimizer.schedule_longest_first" ) );
+		return scheduled_eval;
 	}
 
 	spot::evaluator& CmaOptimizerSpot::GetEvaluator()
@@ -83,28 +613,54 @@ namespace scone
 		if ( eval == 0 )
 		{
 			static spot::sequential_evaluator sequential_eval;
-			return sequential_eval;
+			return WithScheduling( sequential_eval );
 		}
 		else if ( eval == 1 )
 		{
 			static spot::batch_evaluator batch_eval;
-			return batch_eval;
+			return WithScheduling( batch_eval );
 		}
 		else if ( eval == 2 )
 		{
 			static spot::async_evaluator async_eval( max_threads );
 			async_eval.set_max_threads( max_threads, thread_prio );
-			return async_eval;
+			return WithScheduling( async_eval );
 		}
 		else if ( eval == 3 )
 		{
 			static spot::pooled_evaluator pooled_eval;
 			pooled_eval.set_max_threads( max_threads, thread_prio );
-			return pooled_eval;
+			return WithScheduling( pooled_eval );
+		}
+		else if ( eval == 4 )
+		{
+			static NetworkEvaluator network_eval( GetSconeSetting<String>( "optimizer.network_address" ),
+				GetSconeSetting<double>( "optimizer.network_timeout" ), GetSconeSetting<String>( "optimizer.network_token" ) );
+			return network_eval;
+		}
+		else if ( eval == 5 )
+		{
+			static ProcessPoolEvaluator process_eval( max_threads > 0 ? max_threads : std::max( 1u, std::thread::hardware_concurrency() ), GetSconeSetting<double>( "optimizer.network_timeout" ) );
+			return process_eval;
 		}
 		else SCONE_THROW( "Invalid evaluator setting" );
 	}
 
+	spot::evaluator& CmaOptimizerSpot::GetSharedEvaluator()
+	{
+		// threads of the regular evaluators are replaced by a single FairShareEvaluator
+		auto eval = GetSconeSetting<int>( "optimizer.evaluator" );
+		if ( eval == 2 || eval == 3 )
+		{
+			auto max_threads = GetSconeSetting<int>( "optimizer.max_threads" );
+			auto thread_prio = static_cast<xo::thread_priority>( GetSconeSetting<int>( "optimizer.thread_priority" ) );
+			static FairShareEvaluator shared_eval( max_threads > 0 ? max_threads : std::max( 1u, std::thread::hardware_concurrency() ), thread_prio );
+			shared_eval.SetThreadPriority( thread_prio );
+			return WithScheduling( shared_eval );
+		}
+		else return GetEvaluator();
+	}
+
 	void CmaOptimizerReporter::on_start( const optimizer& opt )
 	{
 		auto& cma = dynamic_cast<const CmaOptimizerSpot&>( opt );
@@ -131,6 +687,7 @@ namespace scone
 	void CmaOptimizerReporter::on_stop( const optimizer& opt, const spot::stop_condition& s )
 	{
 		auto& cma = dynamic_cast<const CmaOptimizerSpot&>( opt );
+		telemetry_writer_.Flush();
 		cma.OutputStatus( "finished", s.what() );
 		log::info( "Optimization ", cma.id(), " finished: ", s.what() );
 	}
@@ -163,10 +720,193 @@ namespace scone
 			pn.set( "best", cma.best_fitness() );
 			pn.set( "best_gen", cma.current_step() );
 		}
+		auto* eval = &cma.GetOptimizerEvaluator();
+		if ( auto* se = dynamic_cast<SurrogateEvaluator*>( eval ) )
+		{
+			// statistics only include evaluated candidates, screened candidates have a placeholder fitness
+			if ( !cma.GetEvaluatedFitnesses().empty() )
+				pn.set( "step_median", xo::median( cma.GetEvaluatedFitnesses() ) );
+			pn.set( "progress", cma.GetEvaluatedProgress() );
+			pn.set( "surrogate_screened", se->GetLastScreenedCount( cma.GetObjective() ) );
+			if ( auto corr = se->GetLastCorrelation( cma.GetObjective() ); !std::isnan( corr ) )
+				pn.set( "surrogate_correlation", corr );
+			eval = &se->GetTarget();
+		}
+		if ( auto* se = dynamic_cast<ScheduledEvaluator*>( eval ); se && !cma.async_evaluation )
+		{
+			// evaluation times, to compare the busy time of the threads to the duration of the generation
+			// asynchronous optimizations evaluate one candidate at a time, so there is no batch to report
+			auto timing = se->GetLastBatchTiming( cma.GetObjective() );
+			if ( !timing.durations.empty() )
+			{
+				String times;
+				for ( auto d : timing.durations )
+					times += ( times.empty() ? "" : " " ) + xo::stringf( "%.3f", d );
+				pn.set( "evaluation_times", times );
+				pn.set( "evaluation_time_max", *std::max_element( timing.durations.begin(), timing.durations.end() ) );
+				pn.set( "evaluation_time_median", xo::median( timing.durations ) );
+				pn.set( "evaluation_time_total", std::accumulate( timing.durations.begin(), timing.durations.end(), 0.0 ) );
+				pn.set( "step_time", timing.wall_time );
+			}
+		}
+		SetProfileStatus( cma, pn );
+		ReportTelemetry( cma, cma.current_step(), &pn, telemetry_writer_ );
 		cma.OutputStatus( std::move( pn ) );
 
 		//cma.OutputStatus( "generation", xo::stringf( "%d %g %g %g %g %g", cma.current_step(), cma.current_step_best(), cma.current_step_median(), cma.current_step_average(), cma.fitness_trend().offset(), cma.fitness_trend().slope() ) );
 		//if ( new_best )
 		//	cma.OutputStatus( "best", cma.best_fitness() );
 	}
+
+	CheckpointReporter::CheckpointReporter( const Optimizer& target, size_t interval ) :
+		target_( target ),
+		interval_( interval ),
+		generations_( 0 )
+	{}
+
+	void CheckpointReporter::on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best )
+	{
+		if ( ++generations_ % interval_ == 0 )
+			target_.SaveCheckpoint( generations_ );
+	}
+
+	void CheckpointReporter::on_stop( const optimizer& opt, const spot::stop_condition& s )
+	{
+		target_.SaveCheckpoint( generations_ );
+	}
+
+	AsyncFileReporter::AsyncFileReporter( const path& output_folder, double min_improvement, size_t max_generations_without_output ) :
+		output_folder_( output_folder ),
+		min_improvement_( min_improvement ),
+		max_generations_without_output_( max_generations_without_output ),
+		last_output_gen_( 0 ),
+		last_output_fitness_( std::numeric_limits< double >::quiet_NaN() )
+	{}
+
+	void AsyncFileReporter::on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best )
+	{
+		const auto& info = opt.info();
+		if ( new_best )
+		{
+			// the new best is the best candidate of this population
+			auto better = [&]( double a, double b ) { return info.minimize() ? a < b : a > b; };
+			auto best_idx = std::min_element( fitnesses.begin(), fitnesses.end(), better ) - fitnesses.begin();
+			best_values_ = pop[ best_idx ].values();
+		}
+		if ( best_values_.empty() )
+			return;
+
+		// write results after a significant improvement, or when no results were written for a while
+		auto step = opt.current_step();
+		auto best = opt.best_fitness();
+		bool improved = new_best && ( std::isnan( last_output_fitness_ )
+			|| std::abs( best - last_output_fitness_ ) > min_improvement_ * std::abs( last_output_fitness_ ) );
+		if ( !improved && step - last_output_gen_ < max_generations_without_output_ )
+			return;
+		last_output_gen_ = step;
+		last_output_fitness_ = best;
+
+		// the output is composed here, because the optimizer changes while the file is written
+		auto* cma = dynamic_cast<const CmaOptimizerSpot*>( &opt );
+		auto average = cma ? cma->GetEvaluatedAverage() : opt.current_step_average();
+		auto filename = output_folder_ / xo::stringf( "%04d_%.3f_%.3f.par", int( step ), average, best );
+		// same layout and precision as the spot file_reporter
+		std::ostringstream str;
+		str << std::setprecision( 8 );
+		auto mean = cma ? cma->GetCurrentMean() : spot::par_vec();
+		auto stds = cma ? cma->GetCurrentStd() : spot::par_vec();
+		for ( index_t i = 0; i < info.dim(); ++i )
+		{
+			str << std::left << std::setw( 32 ) << info[ i ].name << "\t" << best_values_[ i ] << "\t";
+			if ( cma )
+				str << mean[ i ] << "\t" << stds[ i ] << "\t";
+			str << "\n";
+		}
+
+		writer_.Enqueue( "par", [filename, par = str.str()]() {
+			std::ofstream ostr( filename.str() );
+			SCONE_ERROR_IF( !ostr.good(), "Could not open " + filename.str() );
+			ostr << par;
+		} );
+	}
+
+	void AsyncFileReporter::on_stop( const optimizer& opt, const spot::stop_condition& s )
+	{
+		writer_.Flush();
+	}
+
+	SearchDistributionReporter::SearchDistributionReporter( const path& filename, size_t interval ) :
+		filename_( filename ),
+		interval_( interval )
+	{}
+
+	void SearchDistributionReporter::on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best )
+	{
+		if ( interval_ > 0 && opt.current_step() % interval_ == 0 )
+			writer_.Enqueue( "search_distribution", [dist = dynamic_cast<const CmaOptimizerSpot&>( opt ).GetSearchDistribution(), filename = filename_]() {
+				dist.Save( filename );
+			} );
+	}
+
+	void SearchDistributionReporter::on_stop( const optimizer& opt, const spot::stop_condition& s )
+	{
+		writer_.Enqueue( "search_distribution", [dist = dynamic_cast<const CmaOptimizerSpot&>( opt ).GetSearchDistribution(), filename = filename_]() {
+			dist.Save( filename );
+		} );
+		writer_.Flush();
+	}
+
+	GenerationReporter::GenerationReporter( Objective& target ) :
+		target_( target )
+	{}
+
+	void GenerationReporter::on_pre_evaluate_population( const optimizer& opt, const search_point_vec& pop )
+	{
+		target_.BeginGeneration();
+	}
+
+	FitnessCacheReporter::FitnessCacheReporter( const Optimizer& target, size_t interval ) :
+		target_( target ),
+		interval_( interval ),
+		generations_( 0 )
+	{}
+
+	void FitnessCacheReporter::on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best )
+	{
+		if ( ++generations_ % interval_ == 0 )
+			writer_.Enqueue( "fitness_cache", [cache = target_.GetFitnessCache(), filename = target_.GetOutputFolder() / "fitness_cache.txt"]() {
+				cache->Save( filename );
+			} );
+	}
+
+	void FitnessCacheReporter::on_stop( const optimizer& opt, const spot::stop_condition& s )
+	{
+		writer_.Flush();
+	}
+
+	TelemetryReporter::TelemetryReporter( const Optimizer& target ) :
+		target_( target )
+	{}
+
+	void TelemetryReporter::on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best )
+	{
+		ReportTelemetry( target_, opt.current_step(), nullptr, writer_ );
+	}
+
+	void TelemetryReporter::on_stop( const optimizer& opt, const spot::stop_condition& s )
+	{
+		writer_.Flush();
+	}
+
+	ProfileReporter::ProfileReporter( const Optimizer& target, size_t interval ) :
+		target_( target ),
+		interval_( interval ),
+		generations_( 0 )
+	{}
+
+	void ProfileReporter::on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best )
+	{
+		if ( ++generations_ % interval_ == 0 )
+			target_.SaveProfile();
+	}
 }
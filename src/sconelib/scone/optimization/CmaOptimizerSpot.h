@@ -9,11 +9,15 @@
 #pragma once
 
 #include "CmaOptimizer.h"
+#include "SearchDistribution.h"
+#include "scone/core/AsyncOutputWriter.h"
 #include "spot/cma_optimizer.h"
 #include "spot/reporter.h"
 #include "xo/system/log_sink.h"
 #include "xo/time/timer.h"
 
+#include <deque>
+
 namespace scone
 {
 	using spot::optimizer;
@@ -22,16 +26,105 @@ namespace scone
 	using spot::fitness_vec;
 	using xo::index_t;
 
+	/// Evaluator that returns fitnesses that were computed beforehand, in the order of the points.
+	/** Used to pass the results of asynchronous evaluations to the spot optimizer. */
+	class SCONE_API PrecomputedEvaluator : public spot::evaluator
+	{
+	public:
+		fitness_vec fitnesses;
+		virtual std::vector< result< fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+	};
+
+	/// Evaluator that lets an Objective adjust the results of a generation before the optimizer uses them.
+	class SCONE_API GenerationEvaluator : public spot::evaluator
+	{
+	public:
+		GenerationEvaluator( Objective& objective, spot::evaluator& target ) : objective_( objective ), target_( target ) {}
+		virtual std::vector< result< fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+	private:
+		Objective& objective_;
+		spot::evaluator& target_;
+	};
+
 	/// Optimizer based on the CMA-ES algorithm by [Hansen].
 	class SCONE_API CmaOptimizerSpot : public CmaOptimizer, public spot::cma_optimizer
 	{
 	public:
-		CmaOptimizerSpot( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir );
+		CmaOptimizerSpot( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir, spot::evaluator* eval = nullptr );
 		virtual void SetOutputMode( OutputMode m ) override;
-		virtual ~CmaOptimizerSpot() {}
+		virtual ~CmaOptimizerSpot();
 		virtual void Run() override;
 		virtual double GetBestFitness() const override { return best_fitness(); }
+		virtual bool IsDeterministic() const override { return !async_evaluation && CmaOptimizer::IsDeterministic(); }
 		static spot::evaluator& GetEvaluator();
+
+		/// Evaluator for optimizations that run concurrently, which divides threads according to their weight.
+		static spot::evaluator& GetSharedEvaluator();
+
+		/// Evaluator used by this optimizer.
+		spot::evaluator& GetOptimizerEvaluator() const { return evaluator_; }
+
+		/// Use asynchronous steady-state CMA-ES, which samples new candidates as soon as a thread is available
+		/// and updates the distribution from completed evaluations; default = false.
+		/// Evaluations go through the regular evaluator one at a time; every lambda completed evaluations
+		/// are reported as a generation to the regular reporters and stop conditions.
+		/// Surrogate screening, checkpoints and CmaPoolOptimizer are not supported.
+		bool async_evaluation;
+
+		/// Fraction of candidates that is evaluated after ranking all candidates with a surrogate model;
+		/// lambda / surrogate_fraction candidates are sampled, of which the best lambda are evaluated;
+		/// 1 disables pre-screening; default = 1.
+		/// Screened candidates that rank among the best mu take part in the update of the search distribution.
+		double surrogate_fraction;
+
+		/// Fraction of candidates that is evaluated regardless of the surrogate ranking; default = 0.1.
+		double surrogate_random_fraction;
+
+		/// Minimum rank correlation between surrogate and evaluation, below which the next generation is not screened; default = 0.3.
+		double surrogate_min_correlation;
+
+		/// Number of most recent evaluations used to fit the surrogate, 0 means 4 * lambda; default = 0.
+		size_t surrogate_archive_size;
+
+		/// Stop an asynchronous optimization, running evaluations are interrupted.
+		void StopAsync();
+
+		/// Mean and std of the search distribution of the most recent generation, in parameter units.
+		spot::par_vec GetCurrentMean() const;
+		spot::par_vec GetCurrentStd() const;
+
+		/// Search distribution of the most recent generation, for use as init_distribution.
+		/// Without async_evaluation, the distribution only contains mean and std.
+		SearchDistribution GetSearchDistribution() const;
+
+		/// Fitnesses of the most recent generation, without the placeholders of candidates that were screened out.
+		const fitness_vec& GetEvaluatedFitnesses() const { return evaluated_fitnesses_; }
+
+		/// Average of the evaluated fitnesses of the most recent generation.
+		double GetEvaluatedAverage() const;
+
+		/// Relative improvement per generation of the average evaluated fitness, over the last window_size generations.
+		double GetEvaluatedProgress() const { return evaluated_progress_; }
+
+	protected:
+		friend class EvaluatedStatisticsReporter;
+		void UpdateEvaluatedStatistics( const fitness_vec& fitnesses );
+
+		virtual void internal_step() override;
+		void RunAsync();
+		void RunAsyncWorker();
+
+		struct AsyncState;
+		u_ptr< AsyncState > async_;
+		SearchDistribution async_distribution_;
+		xo::stop_token async_stop_token_;
+		spot::evaluator& evaluator_;
+		PrecomputedEvaluator precomputed_evaluator_; // constructed after cma_optimizer, which only keeps a reference
+		GenerationEvaluator generation_evaluator_; // idem
+		fitness_vec evaluated_fitnesses_;
+		std::deque< double > evaluated_averages_;
+		double evaluated_progress_;
 	};
 
 	class SCONE_API CmaOptimizerReporter : public spot::reporter
@@ -43,5 +136,110 @@ namespace scone
 		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
 		xo::timer timer_;
 		size_t number_of_evaluations_;
+		AsyncOutputWriter telemetry_writer_;
+	};
+
+	/// Writes a checkpoint of an Optimizer after a fixed number of generations.
+	class SCONE_API CheckpointReporter : public spot::reporter
+	{
+	public:
+		CheckpointReporter( const Optimizer& target, size_t interval );
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
+		virtual void on_stop( const optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		const Optimizer& target_;
+		size_t interval_;
+		size_t generations_;
+	};
+
+	/// Writes a .par file after a significant improvement, or when no file was written for a number of generations.
+	/** The parameters, mean and std are copied when the population is evaluated, and the file is written
+	by an AsyncOutputWriter, so that file output does not block the optimization. A queued file that has
+	not been written yet is replaced by a newer one. All files are written when the optimization stops. */
+	class SCONE_API AsyncFileReporter : public spot::reporter
+	{
+	public:
+		AsyncFileReporter( const path& output_folder, double min_improvement, size_t max_generations_without_output );
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
+		virtual void on_stop( const optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		path output_folder_;
+		double min_improvement_;
+		size_t max_generations_without_output_;
+		size_t last_output_gen_;
+		double last_output_fitness_;
+		spot::par_vec best_values_;
+		AsyncOutputWriter writer_;
+	};
+
+	/// Writes the search distribution of a CmaOptimizerSpot after a fixed number of generations, and when it stops.
+	/** The file is written by an AsyncOutputWriter, a queued file that has not been written yet is replaced by a newer one. */
+	class SCONE_API SearchDistributionReporter : public spot::reporter
+	{
+	public:
+		SearchDistributionReporter( const path& filename, size_t interval );
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
+		virtual void on_stop( const optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		path filename_;
+		size_t interval_;
+		AsyncOutputWriter writer_;
+	};
+
+	/// Notifies an Objective of the start of each generation.
+	class SCONE_API GenerationReporter : public spot::reporter
+	{
+	public:
+		GenerationReporter( Objective& target );
+		virtual void on_pre_evaluate_population( const optimizer& opt, const search_point_vec& pop ) override;
+
+	private:
+		Objective& target_;
+	};
+
+	/// Writes the fitness cache of an Optimizer after a fixed number of generations, so that it survives a crash.
+	/** The cache is written by an AsyncOutputWriter; pending output is written when the optimization stops. */
+	class SCONE_API FitnessCacheReporter : public spot::reporter
+	{
+	public:
+		FitnessCacheReporter( const Optimizer& target, size_t interval );
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
+		virtual void on_stop( const optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		const Optimizer& target_;
+		size_t interval_;
+		size_t generations_;
+		AsyncOutputWriter writer_;
+	};
+
+	/// Writes the evaluation telemetry of an Optimizer after each generation, for output modes without status.
+	/** The file is written by an AsyncOutputWriter; pending output is written when the optimization stops. */
+	class SCONE_API TelemetryReporter : public spot::reporter
+	{
+	public:
+		TelemetryReporter( const Optimizer& target );
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
+		virtual void on_stop( const optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		const Optimizer& target_;
+		AsyncOutputWriter writer_;
+	};
+
+	/// Writes the aggregated profile of an Optimizer after a fixed number of generations.
+	class SCONE_API ProfileReporter : public spot::reporter
+	{
+	public:
+		ProfileReporter( const Optimizer& target, size_t interval );
+		virtual void on_post_evaluate_population( const optimizer& opt, const search_point_vec& pop, const fitness_vec& fitnesses, bool new_best ) override;
+
+	private:
+		const Optimizer& target_;
+		size_t interval_;
+		size_t generations_;
 	};
 }
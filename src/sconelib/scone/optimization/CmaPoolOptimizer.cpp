@@ -8,13 +8,18 @@
 
 #include "CmaPoolOptimizer.h"
 #include "CmaOptimizerSpot.h"
+#include "scone/core/Exception.h"
 #include "spot/file_reporter.h"
+#include "FairShareEvaluator.h"
+#include "NetworkEvaluator.h"
+#include "ScheduledEvaluator.h"
+#include <algorithm>
 
 namespace scone
 {
 	CmaPoolOptimizer::CmaPoolOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir ) :
 	Optimizer( pn, scenario_pn, scenario_dir ),
-	optimizer_pool( *m_Objective, CmaOptimizerSpot::GetEvaluator(), pn )
+	optimizer_pool( *m_Objective, CmaOptimizerSpot::GetSharedEvaluator(), pn )
 	{
 		// re-initialize these parameters because we want different defaults
 		INIT_PROP( pn, prediction_window_, 300 );
@@ -24,6 +29,17 @@ namespace scone
 		INIT_PROP( pn, active_optimizations_, 6 );
 		INIT_PROP( pn, concurrent_optimizations_, 2 );
 		INIT_PROP( pn, random_seed_, 1 );
+		INIT_PROP( pn, adaptive_threads_, true );
+		INIT_PROP( pn, min_thread_share_, 0.25 );
+		SCONE_ERROR_IF( min_thread_share_ <= 0 || min_thread_share_ > 1, "min_thread_share must be between 0 and 1" );
+		SCONE_ERROR_IF( pn.get< bool >( "async_evaluation", false ), "async_evaluation is not supported by CmaPoolOptimizer" );
+	}
+
+	static FairShareEvaluator* GetFairShareEvaluator( spot::evaluator& eval )
+	{
+		if ( auto* se = dynamic_cast<ScheduledEvaluator*>( &eval ) )
+			return dynamic_cast<FairShareEvaluator*>( &se->GetTarget() );
+		else return dynamic_cast<FairShareEvaluator*>( &eval );
 	}
 
 	void CmaPoolOptimizer::Run()
@@ -31,6 +47,11 @@ namespace scone
 		// create output folder
 		PrepareOutputFolder();
 
+		// send scenario to remote workers
+		auto& eval = CmaOptimizerSpot::GetSharedEvaluator();
+		if ( auto* ne = dynamic_cast<NetworkEvaluator*>( &eval ) )
+			ne->SetScenario( GetObjective(), scenario_pn_copy_, GetOutputFolder() );
+
 		// fill the pool
 		for ( int i = 0; i < optimizations_; ++i )
 		{
@@ -40,12 +61,20 @@ namespace scone
 			props_.back().set( "type", "CmaOptimizer" ); // change type
 			props_.back().set( "output_root", GetOutputFolder() ); // make sure output is written to subdirectory
 			props_.back().set( "log_level", (int)xo::log::level::never ); // children don't log?
+			props_.back().set( "use_fitness_cache", false ); // children share the cache of the pool
+			props_.back().set( "checkpoint_interval", 0 ); // checkpoints are written by the pool
 
 			// create optimizer
-			auto o = std::make_unique< CmaOptimizerSpot >( props_.back(), scenario_pn_copy_, m_Objective->GetExternalResourceDir() );
+			auto o = std::make_unique< CmaOptimizerSpot >( props_.back(), scenario_pn_copy_, m_Objective->GetExternalResourceDir(), &eval );
+			if ( IsResuming() && i < GetResumeFolders().size() )
+				o->SetResumeFolder( GetOutputFolder() / GetResumeFolders()[ i ] );
 			o->PrepareOutputFolder();
-			o->add_reporter( std::make_unique< spot::file_reporter >(
+			if ( fitness_cache_ )
+				o->SetFitnessCache( fitness_cache_ );
+			o->add_reporter( std::make_unique< AsyncFileReporter >(
 				o->GetOutputFolder(), o->min_improvement_for_file_output, o->max_generations_without_file_output ) );
+			if ( adaptive_threads_ && GetFairShareEvaluator( eval ) )
+				o->add_reporter( std::make_unique< ThreadShareReporter >( *this ) );
 			o->SetOutputMode( output_mode_ );
 			push_back( std::move( o ) );
 		}
@@ -54,11 +83,62 @@ namespace scone
 		add_reporter( std::make_unique< spot::file_reporter >(
 			GetOutputFolder(), min_improvement_for_file_output, max_generations_without_file_output ) );
 		add_reporter( std::make_unique< CmaPoolOptimizerReporter >() );
+		if ( checkpoint_interval > 0 )
+			add_reporter( std::make_unique< CheckpointReporter >( *this, checkpoint_interval ) ); // single writer for all members
+		if ( use_fitness_cache && fitness_cache_save_interval > 0 )
+			add_reporter( std::make_unique< FitnessCacheReporter >( *this, fitness_cache_save_interval ) ); // cache is shared by the children
 
 		// reset the id, so that the ProgressDock can interpret OutputStatus() as a general message
 		id_.clear();
 
 		run();
+
+		SaveFitnessCache();
+	}
+
+	std::vector< String > CmaPoolOptimizer::GetCheckpointFolders() const
+	{
+		std::vector< String > folders;
+		for ( auto& o : optimizers_ )
+			folders.push_back( dynamic_cast<const Optimizer&>( *o ).GetOutputFolder().filename().str() );
+		return folders;
+	}
+
+	void CmaPoolOptimizer::UpdateThreadShare( const spot::optimizer& member, bool stopped )
+	{
+		auto* fse = GetFairShareEvaluator( CmaOptimizerSpot::GetSharedEvaluator() );
+		if ( !fse )
+			return;
+
+		// with scheduling, the evaluator receives a wrapper of the member objective
+		auto& cma = dynamic_cast<const CmaOptimizerSpot&>( member );
+		const spot::objective* objective = &cma.GetObjective();
+		if ( auto* se = dynamic_cast<ScheduledEvaluator*>( &CmaOptimizerSpot::GetSharedEvaluator() ) )
+			objective = &se->GetTargetObjective( *objective );
+
+		std::scoped_lock lock( member_mutex_ );
+		if ( stopped )
+		{
+			// the threads of stopped members are available to the others right away
+			member_predictions_.erase( objective );
+			fse->RemoveObjective( *objective );
+			return;
+		}
+		else if ( cma.current_step() < prediction_start_ )
+			return; // not enough data for prediction, keep default weight
+
+		member_predictions_[ objective ] = cma.predicted_fitness( prediction_look_ahead_ );
+
+		// weights are linear in predicted fitness, from min_thread_share_ for the worst to 1 for the best
+		auto [min_it, max_it] = std::minmax_element( member_predictions_.begin(), member_predictions_.end(),
+			[]( const auto& a, const auto& b ) { return a.second < b.second; } );
+		auto best = IsMinimizing() ? min_it->second : max_it->second;
+		auto worst = IsMinimizing() ? max_it->second : min_it->second;
+		for ( auto& [o, prediction] : member_predictions_ )
+		{
+			auto rel = best != worst ? ( prediction - worst ) / ( best - worst ) : 1.0;
+			fse->SetWeight( *o, min_thread_share_ + ( 1 - min_thread_share_ ) * rel );
+		}
 	}
 
 	void CmaPoolOptimizer::SetOutputMode( OutputMode m )
@@ -85,4 +165,14 @@ namespace scone
 		auto& cma = dynamic_cast<const CmaPoolOptimizer&>( opt );
 		cma.OutputStatus( "finished", s.what() );
 	}
+
+	void ThreadShareReporter::on_post_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop, const spot::fitness_vec& fitnesses, bool new_best )
+	{
+		pool_.UpdateThreadShare( opt, false );
+	}
+
+	void ThreadShareReporter::on_stop( const spot::optimizer& opt, const spot::stop_condition& s )
+	{
+		pool_.UpdateThreadShare( opt, true );
+	}
 }
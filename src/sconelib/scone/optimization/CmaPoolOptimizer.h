@@ -11,6 +11,8 @@
 #include "Optimizer.h"
 #include "spot/optimizer_pool.h"
 #include "xo/system/log_sink.h"
+#include <map>
+#include <mutex>
 
 namespace scone
 {
@@ -30,10 +32,34 @@ namespace scone
 		/// Random seed of the first optimization; default = 1.
 		long random_seed_;
 
+		/// Divide evaluation threads over the running optimizations based on their predicted fitness; default = 1.
+		bool adaptive_threads_;
+
+		/// Relative share of threads of the optimization with the worst predicted fitness; default = 0.25.
+		double min_thread_share_;
+
 		virtual double GetBestFitness() const override { return best_fitness(); }
+		virtual std::vector< String > GetCheckpointFolders() const override;
+
+		/// Update the thread share of a member optimization, called after each of its generations.
+		void UpdateThreadShare( const spot::optimizer& member, bool stopped );
 
 	protected:
 		std::vector< PropNode > props_;
+		std::map< const spot::objective*, double > member_predictions_;
+		std::mutex member_mutex_;
+	};
+
+	/// Reports the progress of a member optimization to its CmaPoolOptimizer.
+	class SCONE_API ThreadShareReporter : public spot::reporter
+	{
+	public:
+		ThreadShareReporter( CmaPoolOptimizer& pool ) : pool_( pool ) {}
+		virtual void on_post_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop, const spot::fitness_vec& fitnesses, bool new_best ) override;
+		virtual void on_stop( const spot::optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		CmaPoolOptimizer& pool_;
 	};
 
 	class SCONE_API CmaPoolOptimizerReporter : public spot::reporter
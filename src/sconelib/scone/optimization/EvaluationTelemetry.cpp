@@ -0,0 +1,161 @@
+/*
+** EvaluationTelemetry.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "EvaluationTelemetry.h"
+
+#include "xo/string/string_tools.h"
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#	include <psapi.h>
+#elif defined( __linux__ )
+#	include <unistd.h>
+#endif
+
+namespace scone
+{
+	EvaluationTelemetry::EvaluationTelemetry( size_t capacity ) :
+		head_( 0 ),
+		tail_( 0 ),
+		dropped_( 0 ),
+		enabled_( false )
+	{
+		// capacity is rounded up to a power of two, so that slots can be found with a mask
+		size_t n = 1;
+		while ( n < capacity )
+			n *= 2;
+		mask_ = n - 1;
+		slots_ = std::make_unique< Slot[] >( n );
+		for ( size_t i = 0; i < n; ++i )
+			slots_[ i ].sequence.store( i, std::memory_order_relaxed );
+	}
+
+	void EvaluationTelemetry::Add( const EvaluationRecord& r )
+	{
+		// a slot is free when its sequence equals the position of the writer
+		auto pos = head_.load( std::memory_order_relaxed );
+		Slot* slot;
+		while ( true )
+		{
+			slot = &slots_[ pos & mask_ ];
+			auto seq = slot->sequence.load( std::memory_order_acquire );
+			if ( seq == pos )
+			{
+				if ( head_.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+					break;
+			}
+			else if ( seq < pos )
+			{
+				dropped_.fetch_add( 1, std::memory_order_relaxed );
+				return;
+			}
+			else pos = head_.load( std::memory_order_relaxed );
+		}
+		slot->record = r;
+		slot->sequence.store( pos + 1, std::memory_order_release );
+	}
+
+	std::vector< EvaluationRecord > EvaluationTelemetry::Collect()
+	{
+		std::vector< EvaluationRecord > records;
+		while ( true )
+		{
+			auto& slot = slots_[ tail_ & mask_ ];
+			if ( slot.sequence.load( std::memory_order_acquire ) != tail_ + 1 )
+				break;
+			records.push_back( slot.record );
+			slot.sequence.store( tail_ + mask_ + 1, std::memory_order_release );
+			++tail_;
+		}
+		return records;
+	}
+
+	static std::vector< float > GetPercentiles( const std::vector< EvaluationRecord >& records, float EvaluationRecord::* field )
+	{
+		std::vector< float > v;
+		v.reserve( records.size() );
+		for ( auto& r : records )
+			v.push_back( r.*field );
+		std::sort( v.begin(), v.end() );
+		std::vector< float > p;
+		for ( auto f : { 0.0, 0.1, 0.5, 0.9, 1.0 } )
+			p.push_back( v.empty() ? 0.0f : v[ std::min( v.size() - 1, size_t( f * v.size() ) ) ] );
+		return p;
+	}
+
+	static size_t CountEarlyTerminations( const std::vector< EvaluationRecord >& records, double duration )
+	{
+		// allow for the last simulation step to end slightly before the duration
+		return std::count_if( records.begin(), records.end(), [&]( auto& r ) { return r.simulated_time < 0.999 * duration; } );
+	}
+
+	static const std::pair< const char*, float EvaluationRecord::* > g_RecordFields[] = {
+		{ "create_time", &EvaluationRecord::create_time },
+		{ "simulation_time", &EvaluationRecord::simulation_time },
+		{ "finish_time", &EvaluationRecord::finish_time },
+		{ "simulated_time", &EvaluationRecord::simulated_time },
+		{ "memory_mb", &EvaluationRecord::memory }
+	};
+
+	PropNode EvaluationTelemetry::GetSummary( const std::vector< EvaluationRecord >& records, double duration )
+	{
+		PropNode pn;
+		if ( records.empty() )
+			return pn;
+		for ( auto& [name, field] : g_RecordFields )
+		{
+			auto p = GetPercentiles( records, field );
+			pn.set( name, xo::stringf( "%.4g %.4g %.4g %.4g %.4g", p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ], p[ 4 ] ) );
+		}
+		pn.set( "early_terminations", CountEarlyTerminations( records, duration ) );
+		return pn;
+	}
+
+	String EvaluationTelemetry::GetLogHeader()
+	{
+		String str = "step\tevaluations\tearly_terminations\tdropped";
+		for ( auto& [name, field] : g_RecordFields )
+			for ( auto p : { "p10", "p50", "p90", "max" } )
+				str += xo::stringf( "\t%s_%s", name, p );
+		return str;
+	}
+
+	String EvaluationTelemetry::GetLogLine( index_t step, const std::vector< EvaluationRecord >& records, double duration, size_t dropped )
+	{
+		auto str = xo::stringf( "%d\t%d\t%d\t%d", int( step ), int( records.size() ), int( CountEarlyTerminations( records, duration ) ), int( dropped ) );
+		for ( auto& [name, field] : g_RecordFields )
+		{
+			auto p = GetPercentiles( records, field );
+			str += xo::stringf( "\t%.4g\t%.4g\t%.4g\t%.4g", p[ 1 ], p[ 2 ], p[ 3 ], p[ 4 ] );
+		}
+		return str;
+	}
+
+	size_t EvaluationTelemetry::GetResidentMemory()
+	{
+#if defined( _WIN32 )
+		PROCESS_MEMORY_COUNTERS pmc;
+		if ( GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof( pmc ) ) )
+			return pmc.WorkingSetSize;
+		return 0;
+#elif defined( __linux__ )
+		// second field of statm is the number of resident pages
+		std::ifstream str( "/proc/self/statm" );
+		size_t pages = 0, resident = 0;
+		if ( str >> pages >> resident )
+			return resident * size_t( sysconf( _SC_PAGESIZE ) );
+		return 0;
+#else
+		return 0;
+#endif
+	}
+}
@@ -0,0 +1,68 @@
+/*
+** EvaluationTelemetry.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "scone/core/PropNode.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace scone
+{
+	/// Duration of the stages of a single evaluation, the simulated time and the memory in use.
+	struct EvaluationRecord {
+		float create_time; // model construction [s]
+		float simulation_time; // simulation and result computation [s]
+		float finish_time; // fitness cache update and model destruction [s]
+		float simulated_time; // simulated time reached, less than the duration after early termination [s]
+		float memory; // resident memory of the process at the end of the simulation [MB]
+	};
+
+	/// Evaluation records, added by evaluation threads without locking and collected once per generation.
+	/** Records are stored in a bounded queue with a sequence number per slot; records that
+	are added while the queue is full are dropped. Collect() must be called from a single thread. */
+	class SCONE_API EvaluationTelemetry
+	{
+	public:
+		EvaluationTelemetry( size_t capacity = 4096 );
+
+		void SetEnabled( bool enabled ) { enabled_ = enabled; }
+		bool IsEnabled() const { return enabled_.load( std::memory_order_relaxed ); }
+
+		void Add( const EvaluationRecord& r );
+		std::vector< EvaluationRecord > Collect();
+		/// Total number of records that were dropped because the queue was full.
+		size_t GetDroppedCount() const { return dropped_; }
+
+		/// Percentiles of each stage, as "min p10 p50 p90 max"; duration is used to count early terminations.
+		static PropNode GetSummary( const std::vector< EvaluationRecord >& records, double duration );
+
+		/// Column names and a single line with the percentiles of each stage and the total number of dropped records, for a per-generation log.
+		static String GetLogHeader();
+		static String GetLogLine( index_t step, const std::vector< EvaluationRecord >& records, double duration, size_t dropped );
+
+		/// Resident memory of the process in bytes, or 0 if unknown.
+		static size_t GetResidentMemory();
+
+	private:
+		struct Slot {
+			std::atomic< size_t > sequence;
+			EvaluationRecord record;
+		};
+		std::unique_ptr< Slot[] > slots_;
+		size_t mask_;
+		std::atomic< size_t > head_;
+		size_t tail_;
+		std::atomic< size_t > dropped_;
+		std::atomic_bool enabled_;
+	};
+}
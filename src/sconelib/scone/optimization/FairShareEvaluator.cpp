@@ -0,0 +1,164 @@
+/*
+** FairShareEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "FairShareEvaluator.h"
+
+#include "scone/core/Exception.h"
+#include <algorithm>
+#include <chrono>
+
+namespace scone
+{
+	struct FairShareEvaluator::Batch
+	{
+		Batch( size_t n ) : results( n, xo::error_message( "Evaluation canceled" ) ), remaining( n ) {}
+		std::vector< result< fitness_t > > results;
+		size_t remaining;
+	};
+
+	FairShareEvaluator::FairShareEvaluator( size_t max_threads, xo::thread_priority prio ) :
+		thread_priority_( static_cast<int>( prio ) ),
+		stop_( false )
+	{
+		SCONE_ERROR_IF( max_threads == 0, "Number of threads must be > 0" );
+		for ( size_t i = 0; i < max_threads; ++i )
+			threads_.emplace_back( &FairShareEvaluator::WorkerThread, this );
+	}
+
+	FairShareEvaluator::~FairShareEvaluator()
+	{
+		{
+			std::scoped_lock lock( mutex_ );
+			stop_ = true;
+		}
+		work_cv_.notify_all();
+		for ( auto& t : threads_ )
+			t.join();
+	}
+
+	std::vector< result< fitness_t > > FairShareEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		Batch batch( point_vec.size() );
+		std::unique_lock lock( mutex_ );
+		auto& queue = queues_[ &o ];
+		queue.removed = false;
+
+		// jobs are inserted after the jobs with the same or a higher priority
+		auto pos = std::find_if( queue.jobs.begin(), queue.jobs.end(), [&]( const Job& j ) { return j.prio < prio; } );
+		std::vector< Job > jobs;
+		for ( index_t i = 0; i < point_vec.size(); ++i )
+			jobs.push_back( Job{ &point_vec[ i ], &st, &batch, i, prio } );
+		queue.jobs.insert( pos, jobs.begin(), jobs.end() );
+		work_cv_.notify_all();
+
+		bool canceled = false;
+		while ( batch.remaining > 0 )
+		{
+			done_cv_.wait_for( lock, std::chrono::milliseconds( 100 ) );
+			if ( !canceled && st.stop_requested() )
+			{
+				// remove the jobs that have not started, running jobs receive the stop request
+				auto& jobs = queues_[ &o ].jobs;
+				auto it = std::remove_if( jobs.begin(), jobs.end(), [&]( const Job& j ) { return j.batch == &batch; } );
+				batch.remaining -= jobs.end() - it;
+				jobs.erase( it, jobs.end() );
+				canceled = true;
+			}
+		}
+
+		return std::move( batch.results );
+	}
+
+	void FairShareEvaluator::SetWeight( const spot::objective& o, double weight )
+	{
+		SCONE_ERROR_IF( weight <= 0, "Evaluation weight must be > 0" );
+		std::scoped_lock lock( mutex_ );
+		queues_[ &o ].weight = weight;
+	}
+
+	void FairShareEvaluator::RemoveObjective( const spot::objective& o )
+	{
+		// queues with running evaluations are removed by the last thread that finishes
+		std::scoped_lock lock( mutex_ );
+		if ( auto it = queues_.find( &o ); it != queues_.end() )
+		{
+			if ( it->second.jobs.empty() && it->second.running == 0 )
+				queues_.erase( it );
+			else it->second.removed = true;
+		}
+	}
+
+	size_t FairShareEvaluator::GetPendingCount()
+	{
+		std::scoped_lock lock( mutex_ );
+		size_t n = 0;
+		for ( auto& kvp : queues_ )
+			n += kvp.second.jobs.size();
+		return n;
+	}
+
+	FairShareEvaluator::QueueMap::value_type* FairShareEvaluator::SelectQueue()
+	{
+		// pick the queue that is furthest below its share of the threads, or with the highest priority if equal
+		QueueMap::value_type* best = nullptr;
+		double best_load = 0.0;
+		spot::priority_t best_prio = 0;
+		for ( auto& kvp : queues_ )
+		{
+			if ( kvp.second.jobs.empty() )
+				continue;
+			auto load = ( kvp.second.running + 1 ) / kvp.second.weight;
+			auto prio = kvp.second.jobs.front().prio;
+			if ( !best || load < best_load || ( load == best_load && prio > best_prio ) )
+			{
+				best = &kvp;
+				best_load = load;
+				best_prio = prio;
+			}
+		}
+		return best;
+	}
+
+	void FairShareEvaluator::WorkerThread()
+	{
+		int current_priority = -1;
+		std::unique_lock lock( mutex_ );
+		while ( true )
+		{
+			QueueMap::value_type* selected = nullptr;
+			work_cv_.wait( lock, [&]() { return stop_ || ( selected = SelectQueue() ) != nullptr; } );
+			if ( stop_ )
+				return;
+
+			auto* objective = selected->first;
+			auto* queue = &selected->second;
+			auto job = queue->jobs.front();
+			queue->jobs.pop_front();
+			++queue->running;
+			lock.unlock();
+
+			if ( int prio = thread_priority_; prio != current_priority )
+			{
+				xo::set_thread_priority( static_cast<xo::thread_priority>( prio ) );
+				current_priority = prio;
+			}
+
+			result< fitness_t > r = xo::error_message( "Evaluation failed" );
+			try { r = objective->evaluate( *job.point, *job.st ); }
+			catch ( std::exception& e ) { r = xo::error_message( e.what() ); }
+
+			lock.lock();
+			--queue->running;
+			job.batch->results[ job.index ] = std::move( r );
+			--job.batch->remaining;
+			if ( queue->removed && queue->running == 0 && queue->jobs.empty() )
+				queues_.erase( objective );
+			done_cv_.notify_all();
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/*
+** FairShareEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "spot/evaluator.h"
+#include "spot/objective.h"
+#include "xo/system/system_tools.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace scone
+{
+	/// Thread pool evaluator that divides its threads over concurrent objectives in proportion to their weight.
+	/** Whenever a thread becomes available, it picks the next evaluation of the objective that has the fewest
+	running evaluations relative to its weight. Threads never wait while there is work, so threads of an objective
+	that has no pending evaluations (e.g. a stopped optimization) are immediately used by the others.
+	Evaluations of a single objective are started in order of priority, and then in the order in which they were submitted.
+	Priority also decides between objectives that are equally far below their share. */
+	class SCONE_API FairShareEvaluator : public spot::evaluator
+	{
+	public:
+		FairShareEvaluator( size_t max_threads, xo::thread_priority prio = xo::thread_priority::normal );
+		virtual ~FairShareEvaluator();
+
+		virtual std::vector< result< fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+		/// Set the relative share of threads for an objective, must be > 0; the default weight is 1.
+		void SetWeight( const spot::objective& o, double weight );
+
+		/// Remove all data of an objective that will no longer be evaluated.
+		/** If evaluations of the objective are still running, the data is removed when they are finished. */
+		void RemoveObjective( const spot::objective& o );
+
+		/// Set the priority of the threads, which is applied before their next evaluation.
+		void SetThreadPriority( xo::thread_priority prio ) { thread_priority_ = static_cast<int>( prio ); }
+
+		size_t GetThreadCount() const { return threads_.size(); }
+		size_t GetObjectiveCount() { std::scoped_lock lock( mutex_ ); return queues_.size(); }
+		size_t GetPendingCount();
+
+	private:
+		struct Batch;
+		struct Job { const spot::search_point* point; const xo::stop_token* st; Batch* batch; index_t index; spot::priority_t prio; };
+		struct Queue { std::deque< Job > jobs; size_t running = 0; double weight = 1.0; bool removed = false; };
+
+		using QueueMap = std::map< const spot::objective*, Queue >;
+
+		void WorkerThread();
+		QueueMap::value_type* SelectQueue();
+
+		QueueMap queues_;
+		std::vector< std::thread > threads_;
+		std::atomic_int thread_priority_;
+		bool stop_;
+		std::mutex mutex_;
+		std::condition_variable work_cv_;
+		std::condition_variable done_cv_;
+	};
+}
@@ -0,0 +1,192 @@
+/*
+** FitnessCache.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "FitnessCache.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+#include "scone/core/system_tools.h"
+#include "xo/serialization/prop_node_serializer_zml.h"
+#include "xo/string/string_tools.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace scone
+{
+	// FNV-1a, combined per 64-bit word
+	constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+	constexpr uint64_t fnv_prime = 1099511628211ull;
+
+	inline uint64_t hash_combine( uint64_t h, uint64_t v ) {
+		for ( int i = 0; i < 8; ++i, v >>= 8 )
+			h = ( h ^ ( v & 0xff ) ) * fnv_prime;
+		return h;
+	}
+
+	inline uint64_t hash_string( uint64_t h, const String& str ) {
+		for ( auto c : str )
+			h = ( h ^ static_cast<unsigned char>( c ) ) * fnv_prime;
+		return h;
+	}
+
+	FitnessCache::FitnessCache( double quantization ) :
+		quantization_( quantization ),
+		hits_( 0 ),
+		misses_( 0 )
+	{
+		SCONE_ERROR_IF( quantization_ <= 0.0, "Fitness cache quantization must be > 0" );
+	}
+
+	FitnessCache::key_t FitnessCache::GetKey( const SearchPoint& point, const String& signature ) const
+	{
+		uint64_t h = hash_string( fnv_offset_basis, signature );
+		h = hash_combine( h, point.size() );
+		for ( auto v : point.values() )
+		{
+			// values that don't fit in 64 bits after quantization (including nan and inf) are hashed as is
+			auto q = v / quantization_;
+			if ( std::abs( q ) < 9.0e18 )
+				h = hash_combine( h, static_cast<uint64_t>( std::llround( q ) ) );
+			else
+			{
+				uint64_t bits;
+				std::memcpy( &bits, &v, sizeof( bits ) );
+				h = hash_combine( hash_combine( h, ~uint64_t( 0 ) ), bits );
+			}
+		}
+		return h;
+	}
+
+	String FitnessCache::GetContentSignature( const String& signature, const PropNode& props, const std::vector< path >& files )
+	{
+		PropNode pn = props;
+		xo::error_code ec;
+		std::ostringstream str;
+		str << xo::prop_node_serializer_zml( pn, &ec );
+		SCONE_ERROR_IF( !ec.good(), "Could not serialize objective: " + ec.message() );
+		uint64_t h = hash_string( fnv_offset_basis, str.str() );
+
+		// files are identified by their name, so that the signature does not depend on the folder
+		for ( auto& f : files )
+		{
+			h = hash_string( h, f.filename().str() );
+			std::ifstream ifstr( f.str(), std::ios::binary );
+			if ( ifstr.good() )
+			{
+				std::ostringstream content;
+				content << ifstr.rdbuf();
+				h = hash_combine( hash_string( h, content.str() ), content.str().size() );
+			}
+		}
+		return signature + xo::stringf( ".%016llx", static_cast<unsigned long long>( h ) );
+	}
+
+	std::optional< spot::fitness_t > FitnessCache::TryGet( key_t key ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		if ( auto it = entries_.find( key ); it != entries_.end() )
+		{
+			++hits_;
+			return it->second;
+		}
+		++misses_;
+		return std::nullopt;
+	}
+
+	void FitnessCache::Insert( key_t key, spot::fitness_t fitness )
+	{
+		std::scoped_lock lock( mutex_ );
+		entries_[ key ] = fitness;
+	}
+
+	size_t FitnessCache::Load( const path& filename )
+	{
+		std::ifstream ifstr( filename.str() );
+		SCONE_ERROR_IF( !ifstr.good(), "Could not open fitness cache " + filename.str() );
+
+		double quantization = 0.0;
+		ifstr >> quantization;
+		if ( quantization != quantization_ )
+		{
+			log::warning( "Skipped ", filename, " because its quantization (", quantization, ") differs from ", quantization_ );
+			return 0;
+		}
+
+		std::scoped_lock lock( mutex_ );
+		size_t count = 0;
+		key_t key;
+		spot::fitness_t fitness;
+		while ( ifstr >> std::hex >> key >> std::dec >> fitness )
+		{
+			entries_[ key ] = fitness;
+			++count;
+		}
+		return count;
+	}
+
+	void FitnessCache::Save( const path& filename ) const
+	{
+		// write to temporary file first, so that an existing file survives a crash while writing
+		auto temp_filename = path( filename.str() + ".tmp" );
+		{
+			std::ofstream ofstr( temp_filename.str() );
+			SCONE_ERROR_IF( !ofstr.good(), "Could not write fitness cache " + temp_filename.str() );
+
+			std::scoped_lock lock( mutex_ );
+			ofstr << std::setprecision( 17 ) << quantization_ << '\n';
+			for ( auto& [ key, fitness ] : entries_ )
+				ofstr << std::hex << key << ' ' << std::dec << fitness << '\n';
+			SCONE_ERROR_IF( !ofstr.good(), "Could not write fitness cache " + temp_filename.str() );
+		}
+		RenameFile( temp_filename, filename );
+	}
+
+	void FitnessCache::Write( std::ostream& str ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		uint64_t count = entries_.size();
+		str.write( reinterpret_cast<const char*>( &quantization_ ), sizeof( quantization_ ) );
+		str.write( reinterpret_cast<const char*>( &count ), sizeof( count ) );
+		for ( auto& [ key, fitness ] : entries_ )
+		{
+			str.write( reinterpret_cast<const char*>( &key ), sizeof( key ) );
+			str.write( reinterpret_cast<const char*>( &fitness ), sizeof( fitness ) );
+		}
+	}
+
+	size_t FitnessCache::Read( std::istream& str )
+	{
+		double quantization = 0.0;
+		uint64_t count = 0;
+		str.read( reinterpret_cast<char*>( &quantization ), sizeof( quantization ) );
+		str.read( reinterpret_cast<char*>( &count ), sizeof( count ) );
+		SCONE_ERROR_IF( !str.good(), "Could not read fitness cache" );
+		SCONE_ERROR_IF( quantization != quantization_, "Fitness cache quantization does not match" );
+
+		std::scoped_lock lock( mutex_ );
+		for ( uint64_t i = 0; i < count; ++i )
+		{
+			key_t key;
+			spot::fitness_t fitness;
+			str.read( reinterpret_cast<char*>( &key ), sizeof( key ) );
+			str.read( reinterpret_cast<char*>( &fitness ), sizeof( fitness ) );
+			SCONE_ERROR_IF( !str.good(), "Unexpected end of fitness cache" );
+			entries_[ key ] = fitness;
+		}
+		return count;
+	}
+
+	size_t FitnessCache::GetSize() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return entries_.size();
+	}
+}
@@ -0,0 +1,64 @@
+/*
+** FitnessCache.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "scone/core/memory_tools.h"
+#include "Params.h"
+#include "spot/objective.h"
+
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace scone
+{
+	/// Thread-safe cache of fitness values, keyed by a hash of the quantized parameter values and the objective signature.
+	/** Only use this for deterministic objectives, since cached results are returned without re-evaluation.
+	Keys are 64-bit hashes, the parameter values themselves are not stored. */
+	class SCONE_API FitnessCache
+	{
+	public:
+		FitnessCache( double quantization );
+
+		using key_t = uint64_t;
+
+		key_t GetKey( const SearchPoint& point, const String& signature ) const;
+
+		/// Signature for GetKey() that includes a hash of the objective props and the contents of its resource files,
+		/// so that values cached for a different scenario or model file are not used.
+		static String GetContentSignature( const String& signature, const PropNode& props, const std::vector< path >& files );
+		std::optional< spot::fitness_t > TryGet( key_t key ) const;
+		void Insert( key_t key, spot::fitness_t fitness );
+
+		/// read entries from file, returns the number of entries read
+		size_t Load( const path& filename );
+		void Save( const path& filename ) const;
+
+		/// binary serialization, used for checkpoints
+		void Write( std::ostream& str ) const;
+		size_t Read( std::istream& str );
+
+		size_t GetSize() const;
+		size_t GetHitCount() const { return hits_; }
+		size_t GetMissCount() const { return misses_; }
+		double GetQuantization() const { return quantization_; }
+
+	private:
+		double quantization_;
+		std::unordered_map< key_t, spot::fitness_t > entries_;
+		mutable std::atomic< size_t > hits_;
+		mutable std::atomic< size_t > misses_;
+		mutable std::mutex mutex_;
+	};
+}
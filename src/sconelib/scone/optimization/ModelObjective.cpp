@@ -13,6 +13,8 @@
 #include "xo/filesystem/filesystem.h"
 #include "opt_tools.h"
 #include "scone/core/profiler_config.h"
+#include "scone/core/ProfileAggregator.h"
+#include "xo/time/timer.h"
 
 namespace scone
 {
@@ -39,15 +41,54 @@ namespace scone
 		signature_ = model_->GetSignature();
 
 		AddExternalResources( *model_ );
+		fitness_cache_signature_ = FitnessCache::GetContentSignature( GetSignature(), props, GetExternalResources() );
 	}
 
 	result<fitness_t> ModelObjective::evaluate( const SearchPoint& point, const xo::stop_token& st ) const
 	{
 		if ( !st.stop_requested() )
 		{
+			FitnessCache::key_t cache_key = 0;
+			if ( fitness_cache_ )
+			{
+				cache_key = fitness_cache_->GetKey( point, fitness_cache_signature_ );
+				if ( auto fitness = fitness_cache_->TryGet( cache_key ) )
+					return *fitness;
+			}
+
+			xo::timer t;
 			SearchPoint params( point );
-			auto model = CreateModelFromParams( params );
-			return EvaluateModel( *model, st );
+			auto plan = GetParamBindingPlan();
+			ParamBinder binder( params, plan.get() );
+			auto model = CreateModelFromParams( binder );
+			if ( !binder.IsReplayed() )
+				UpdateParamBindingPlan( binder );
+			else if ( binder.IsFirstReplay() )
+				VerifyParamBindingPlan( plan );
+			auto create_time = t().seconds();
+			auto fitness = EvaluateCandidate( *model, st );
+			auto simulation_time = t().seconds();
+			auto simulated_time = model->GetTime();
+			auto memory = telemetry_.IsEnabled() ? EvaluationTelemetry::GetResidentMemory() : 0;
+			if ( ProfileAggregator::IsActive() )
+				ProfileAggregator::GetInstance().FlushThread( static_cast<const Objective*>( this ) );
+
+			if ( fitness && !st.stop_requested() )
+			{
+				if ( IsPartialResult( *model ) )
+					AddPartialResult( point, fitness.value() );
+				else if ( fitness_cache_ )
+					fitness_cache_->Insert( cache_key, fitness.value() );
+			}
+
+			if ( telemetry_.IsEnabled() )
+			{
+				model.reset();
+				auto finish_time = t().seconds();
+				telemetry_.Add( EvaluationRecord{ float( create_time ), float( simulation_time - create_time ),
+					float( finish_time - simulation_time ), float( simulated_time ), float( memory / 1e6 ) } );
+			}
+			return fitness;
 		}
 		else return xo::error_message( "Optimization canceled" );
 	}
@@ -78,6 +119,31 @@ namespace scone
 		return model;
 	}
 
+	s_ptr< const ParamBindingPlan > ModelObjective::GetParamBindingPlan() const
+	{
+		std::scoped_lock lock( param_binding_plan_mutex_ );
+		if ( param_binding_plan_ && param_binding_plan_->IsValidFor( GetSignature(), info().dim() ) )
+			return param_binding_plan_;
+		else return nullptr;
+	}
+
+	void ModelObjective::UpdateParamBindingPlan( ParamBinder& binder ) const
+	{
+		auto plan = std::make_shared< const ParamBindingPlan >( binder.ExtractPlan( GetSignature() ) );
+		std::scoped_lock lock( param_binding_plan_mutex_ );
+		param_binding_plan_ = std::move( plan );
+		log::trace( "Recorded parameter binding plan with ", param_binding_plan_->bindings.size(), " lookups" );
+	}
+
+	void ModelObjective::VerifyParamBindingPlan( const s_ptr< const ParamBindingPlan >& plan ) const
+	{
+		auto verified_plan = std::make_shared< ParamBindingPlan >( *plan );
+		verified_plan->verified = true;
+		std::scoped_lock lock( param_binding_plan_mutex_ );
+		if ( param_binding_plan_ == plan )
+			param_binding_plan_ = std::move( verified_plan );
+	}
+
 	ModelUP ModelObjective::CreateModelFromParFile( const path& parfile ) const
 	{
 		SearchPoint params( info_ );
@@ -11,6 +11,9 @@
 #include "scone/optimization/Objective.h"
 #include "scone/model/Model.h"
 #include "scone/core/Factories.h"
+#include "EvaluationTelemetry.h"
+#include "ParamBindingPlan.h"
+#include <mutex>
 
 namespace scone
 {
@@ -24,6 +27,15 @@ namespace scone
 		virtual result<fitness_t> evaluate( const SearchPoint& point, const xo::stop_token& st ) const override;
 		virtual result<fitness_t> EvaluateModel( Model& m, const xo::stop_token& st ) const;
 
+		/// Evaluate a model created from a search point during optimization; default calls EvaluateModel().
+		virtual result<fitness_t> EvaluateCandidate( Model& m, const xo::stop_token& st ) const { return EvaluateModel( m, st ); }
+
+		// true if the fitness of m after EvaluateCandidate() is an estimate, which is not added to the fitness cache
+		virtual bool IsPartialResult( const Model& m ) const { return false; }
+
+		// called with the estimated fitness of a point for which IsPartialResult() is true
+		virtual void AddPartialResult( const SearchPoint& point, fitness_t fitness ) const {}
+
 		virtual void AdvanceSimulationTo( Model& m, TimeInSeconds t ) const = 0;
 		virtual TimeInSeconds GetDuration() const = 0;
 		virtual fitness_t GetResult( Model& m ) const = 0;
@@ -37,6 +49,9 @@ namespace scone
 		const Model& GetModel() const { return *model_; }
 		Model& GetModel() { return *model_; }
 
+		/// Timing and memory of evaluations in this process, recorded while enabled.
+		EvaluationTelemetry& GetTelemetry() const { return telemetry_; }
+
 	protected:
 		FactoryProps model_props;
 		FactoryProps controller_props;
@@ -44,8 +59,18 @@ namespace scone
 
 		ModelUP model_;
 		String signature_; // cached variable, because we need to create a model to get the signature
+		String fitness_cache_signature_; // signature_ with a hash of the props and model files
 		virtual String GetClassSignature() const override { return signature_; }
 		TimeInSeconds evaluation_step_size_;
+
+		// parameter lookups recorded during the first model construction
+		s_ptr< const ParamBindingPlan > GetParamBindingPlan() const;
+		void UpdateParamBindingPlan( ParamBinder& binder ) const;
+		void VerifyParamBindingPlan( const s_ptr< const ParamBindingPlan >& plan ) const;
+		mutable s_ptr< const ParamBindingPlan > param_binding_plan_;
+		mutable std::mutex param_binding_plan_mutex_;
+
+		mutable EvaluationTelemetry telemetry_;
 	};
 
 	/// Create ModelObjective from a PropNode
@@ -0,0 +1,469 @@
+/*
+** NetworkEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "NetworkEvaluator.h"
+
+#include "ModelObjective.h"
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+#include "scone/core/Settings.h"
+#include "xo/serialization/prop_node_serializer_zml.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else
+#	include <unistd.h>
+#endif
+
+namespace scone
+{
+	// message layout: uint32 type, uint64 payload size, payload
+	enum message_type : uint32_t { msg_hello = 1, msg_scenario, msg_evaluate, msg_result, msg_goodbye };
+	const uint32_t network_protocol_version = 3;
+	const uint64_t max_message_size = uint64_t( 1 ) << 30;
+	const int max_attempts = 3;
+
+	struct message_writer
+	{
+		template< typename T > void write( const T& v ) { buf.append( reinterpret_cast<const char*>( &v ), sizeof( T ) ); }
+		void write_string( const String& s ) { write< uint64_t >( s.size() ); buf += s; }
+		String buf;
+	};
+
+	struct message_reader
+	{
+		message_reader( const String& b ) : buf( b ), pos( 0 ) {}
+		template< typename T > T read() {
+			SCONE_ERROR_IF( pos + sizeof( T ) > buf.size(), "Invalid network message" );
+			T v;
+			std::memcpy( &v, buf.data() + pos, sizeof( T ) );
+			pos += sizeof( T );
+			return v;
+		}
+		String read_string() {
+			auto n = read< uint64_t >();
+			SCONE_ERROR_IF( pos + n > buf.size(), "Invalid network message" );
+			pos += n;
+			return buf.substr( pos - n, n );
+		}
+		const String& buf;
+		size_t pos;
+	};
+
+	static bool send_message( const Socket& s, uint32_t type, const String& payload = String() )
+	{
+		uint64_t size = payload.size();
+		return s.Send( &type, sizeof( type ) ) && s.Send( &size, sizeof( size ) ) && s.Send( payload.data(), payload.size() );
+	}
+
+	static bool receive_message( const Socket& s, uint32_t& type, String& payload )
+	{
+		uint64_t size = 0;
+		if ( !s.Receive( &type, sizeof( type ) ) || !s.Receive( &size, sizeof( size ) ) || size > max_message_size )
+			return false;
+		payload.resize( size );
+		return s.Receive( &payload[ 0 ], size );
+	}
+
+	// hello message: uint32 protocol version, uint64 process id of the worker, string token
+	static bool ReadHello( const String& payload, uint64_t& process_id, const String& token )
+	{
+		try
+		{
+			message_reader msg( payload );
+			if ( msg.read< uint32_t >() != network_protocol_version )
+				return false;
+			process_id = msg.read< uint64_t >();
+			return msg.read_string() == token && msg.pos == payload.size();
+		}
+		catch ( std::exception& ) { return false; }
+	}
+
+	static bool IsLocalAddress( const String& address )
+	{
+		if ( address.compare( 0, 5, "unix:" ) == 0 )
+			return true;
+		auto host = address.substr( 0, address.rfind( ':' ) );
+		return host == "127.0.0.1" || host == "localhost" || host == "[::1]";
+	}
+
+	// workers from other machines must be authenticated
+	static const String& CheckListenAddress( const String& address, const String& token )
+	{
+		SCONE_ERROR_IF( token.empty() && !IsLocalAddress( address ), "optimizer.network_token must be set to accept evaluation workers on " + address );
+		return address;
+	}
+
+	// FNV-1a hash of the parameter names, used to check if a worker evaluates the right objective
+	static uint64_t GetParameterHash( const spot::objective_info& info )
+	{
+		uint64_t h = 14695981039346656037ull;
+		for ( index_t i = 0; i < info.dim(); ++i )
+		{
+			for ( auto c : info[ i ].name )
+				h = ( h ^ static_cast<unsigned char>( c ) ) * 1099511628211ull;
+			h = ( h ^ 0xff ) * 1099511628211ull; // separator
+		}
+		return h;
+	}
+
+	// scenarios are identified by the signature and parameters of their objective
+	static uint64_t GetObjectiveKey( const spot::objective& o )
+	{
+		uint64_t h = GetParameterHash( o.info() );
+		if ( auto* so = dynamic_cast<const Objective*>( &o ) )
+			for ( auto c : so->GetSignature() )
+				h = ( h ^ static_cast<unsigned char>( c ) ) * 1099511628211ull;
+		return h;
+	}
+
+	static uint64_t GetCurrentProcessNumber()
+	{
+#ifdef _WIN32
+		return GetCurrentProcessId();
+#else
+		return uint64_t( getpid() );
+#endif
+	}
+
+	struct NetworkEvaluator::Batch
+	{
+		Batch( size_t n ) : results( n, xo::error_message( "Evaluation canceled" ) ), remaining( n ), canceled( false ) {}
+		std::vector< result< fitness_t > > results;
+		size_t remaining;
+		bool canceled;
+		std::condition_variable cv;
+	};
+
+	NetworkEvaluator::NetworkEvaluator( const String& address, double timeout, const String& token ) :
+		address_( address ),
+		timeout_( timeout ),
+		token_( token ),
+		listener_( Socket::Listen( CheckListenAddress( address, token ) ) ),
+		shutdown_( false ),
+		scenario_id_( 0 ),
+		next_job_id_( 1 )
+	{
+		// use the actual port if the system picked one
+		if ( address_.size() > 2 && address_.compare( address_.size() - 2, 2, ":0" ) == 0 )
+			address_ = address_.substr( 0, address_.size() - 1 ) + std::to_string( listener_.GetLocalPort() );
+
+		accept_thread_ = std::thread( &NetworkEvaluator::AcceptConnections, this );
+		log::info( "Waiting for evaluation workers on ", address_ );
+	}
+
+	NetworkEvaluator::~NetworkEvaluator()
+	{
+		Shutdown();
+	}
+
+	void NetworkEvaluator::Shutdown()
+	{
+		{
+			std::scoped_lock lock( mutex_ );
+			shutdown_ = true;
+			for ( auto& w : workers_ )
+				w.socket.Shutdown();
+		}
+		listener_.Shutdown();
+		jobs_cv_.notify_all();
+		if ( accept_thread_.joinable() )
+			accept_thread_.join();
+		for ( auto& w : workers_ )
+			if ( w.thread.joinable() )
+				w.thread.join();
+	}
+
+	void NetworkEvaluator::SetScenario( const spot::objective& o, const PropNode& scenario_pn, const path& scenario_dir )
+	{
+		PropNode pn = scenario_pn;
+		xo::error_code ec;
+		std::ostringstream str;
+		str << xo::prop_node_serializer_zml( pn, &ec );
+		SCONE_ERROR_IF( !ec.good(), "Could not serialize scenario: " + ec.message() );
+
+		message_writer msg;
+		msg.write_string( str.str() );
+		msg.write_string( scenario_dir.str() );
+		msg.write( GetParameterHash( o.info() ) );
+
+		std::scoped_lock lock( mutex_ );
+		auto& s = scenarios_[ GetObjectiveKey( o ) ];
+		if ( !s || s->message != msg.buf )
+			s = std::make_shared< Scenario >( Scenario{ ++scenario_id_, std::move( msg.buf ) } );
+	}
+
+	std::vector< result< fitness_t > > NetworkEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		auto batch = std::make_shared< Batch >( point_vec.size() );
+		auto key = GetObjectiveKey( o );
+		std::unique_lock lock( mutex_ );
+		auto scenario_it = scenarios_.find( key );
+		SCONE_ERROR_IF( scenario_it == scenarios_.end(), "No scenario was set for the objective of this network evaluation" );
+		for ( index_t i = 0; i < point_vec.size(); ++i )
+			jobs_.push_back( Job{ next_job_id_++, point_vec[ i ].values(), batch, i, 0, scenario_it->second } );
+		jobs_cv_.notify_all();
+
+		bool warned = false;
+		while ( batch->remaining > 0 && !st.stop_requested() )
+		{
+			if ( workers_.empty() && !warned )
+			{
+				log::warning( "No evaluation workers connected, waiting for workers on ", address_ );
+				warned = true;
+			}
+			batch->cv.wait_for( lock, std::chrono::milliseconds( 100 ) );
+			if ( std::any_of( workers_.begin(), workers_.end(), []( const Worker& w ) { return w.finished; } ) )
+			{
+				lock.unlock();
+				RemoveFinishedWorkers();
+				lock.lock();
+			}
+		}
+
+		if ( batch->remaining > 0 )
+		{
+			// evaluation was stopped, remove jobs that have not started
+			batch->canceled = true;
+			jobs_.erase( std::remove_if( jobs_.begin(), jobs_.end(), [&]( const Job& j ) { return j.batch == batch; } ), jobs_.end() );
+		}
+
+		return batch->results;
+	}
+
+	size_t NetworkEvaluator::GetWorkerCount() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return std::count_if( workers_.begin(), workers_.end(), []( const Worker& w ) { return !w.finished; } );
+	}
+
+	void NetworkEvaluator::AcceptConnections()
+	{
+		while ( !shutdown_ )
+		{
+			auto s = listener_.Accept();
+			if ( !s.IsValid() )
+			{
+				if ( !shutdown_ )
+					std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+				continue;
+			}
+
+			std::scoped_lock lock( mutex_ );
+			if ( shutdown_ )
+				break;
+			auto& w = workers_.emplace_back();
+			w.socket = std::move( s );
+			w.thread = std::thread( &NetworkEvaluator::ServeWorker, this, std::ref( w ) );
+		}
+	}
+
+	void NetworkEvaluator::ServeWorker( Worker& w )
+	{
+		// a worker that crashed or hangs without closing the connection is detected by a timeout
+		w.socket.SetKeepAlive( true );
+		w.socket.SetReceiveTimeout( timeout_ );
+
+		uint32_t type = 0;
+		String payload;
+		if ( receive_message( w.socket, type, payload ) && type == msg_hello && ReadHello( payload, w.process_id, token_ ) )
+		{
+			log::info( "Evaluation worker connected, workers: ", GetWorkerCount() );
+			while ( true )
+			{
+				Job job;
+				String scenario;
+				{
+					std::unique_lock lock( mutex_ );
+					jobs_cv_.wait( lock, [&]() { return shutdown_ || !jobs_.empty(); } );
+					if ( shutdown_ )
+						break;
+					job = std::move( jobs_.front() );
+					jobs_.pop_front();
+					if ( job.batch->canceled )
+						continue;
+					if ( w.scenario_id != job.scenario->id )
+					{
+						message_writer msg;
+						msg.write( job.scenario->id );
+						scenario = msg.buf + job.scenario->message;
+						w.scenario_id = job.scenario->id;
+					}
+				}
+
+				message_writer msg;
+				msg.write( job.id );
+				msg.write< uint64_t >( job.values.size() );
+				msg.buf.append( reinterpret_cast<const char*>( job.values.data() ), job.values.size() * sizeof( double ) );
+
+				auto start_time = std::chrono::steady_clock::now();
+				bool ok = ( scenario.empty() || send_message( w.socket, msg_scenario, scenario ) )
+					&& send_message( w.socket, msg_evaluate, msg.buf )
+					&& receive_message( w.socket, type, payload ) && type == msg_result;
+				bool timed_out = !ok && std::chrono::duration< double >( std::chrono::steady_clock::now() - start_time ).count() >= timeout_;
+
+				if ( ok )
+				{
+					try
+					{
+						message_reader reply( payload );
+						SCONE_ERROR_IF( reply.read< uint64_t >() != job.id, "Unexpected evaluation result" );
+						auto success = reply.read< uint8_t >();
+						auto fitness = reply.read< fitness_t >();
+						auto error = reply.read_string();
+						std::scoped_lock lock( mutex_ );
+						job.batch->results[ job.index ] = success ? result< fitness_t >( fitness ) : result< fitness_t >( xo::error_message( error ) );
+						if ( --job.batch->remaining == 0 )
+							job.batch->cv.notify_all();
+					}
+					catch ( std::exception& e )
+					{
+						log::warning( "Invalid reply from evaluation worker: ", e.what() );
+						ok = false;
+					}
+				}
+
+				if ( !ok )
+				{
+					// worker was lost, resubmit evaluation unless it keeps failing
+					if ( timed_out )
+						log::warning( "No reply from evaluation worker within ", timeout_, "s" );
+					std::unique_lock lock( mutex_ );
+					if ( ++job.attempts < max_attempts )
+					{
+						log::warning( "Lost connection to evaluation worker, resubmitting evaluation" );
+						jobs_.push_front( std::move( job ) );
+						lock.unlock();
+						jobs_cv_.notify_one();
+					}
+					else
+					{
+						log::warning( "Evaluation failed on ", max_attempts, " workers" );
+						job.batch->results[ job.index ] = xo::error_message( "Evaluation lost on all attempts" );
+						if ( --job.batch->remaining == 0 )
+							job.batch->cv.notify_all();
+						lock.unlock();
+					}
+					if ( timed_out )
+						OnWorkerTimeout( w.process_id );
+					break;
+				}
+			}
+		}
+		else log::warning( "Rejected evaluation worker with invalid handshake or token" );
+
+		send_message( w.socket, msg_goodbye );
+		std::scoped_lock lock( mutex_ );
+		w.finished = true;
+	}
+
+	void NetworkEvaluator::RemoveFinishedWorkers()
+	{
+		std::list< Worker > finished;
+		{
+			std::scoped_lock lock( mutex_ );
+			for ( auto it = workers_.begin(); it != workers_.end(); )
+			{
+				auto next = std::next( it );
+				if ( it->finished )
+					finished.splice( finished.end(), workers_, it );
+				it = next;
+			}
+		}
+		for ( auto& w : finished )
+			w.thread.join();
+	}
+
+	void RunEvaluationWorker( const String& address )
+	{
+		auto* token_env = std::getenv( "SCONE_WORKER_TOKEN" );
+		String token = token_env ? String( token_env ) : GetSconeSetting<String>( "optimizer.network_token" );
+
+		log::info( "Connecting to ", address );
+		auto s = Socket::Connect( address );
+		s.SetKeepAlive( true );
+		message_writer hello;
+		hello.write( network_protocol_version );
+		hello.write( GetCurrentProcessNumber() );
+		hello.write_string( token );
+		SCONE_ERROR_IF( !send_message( s, msg_hello, hello.buf ), "Could not connect to " + address );
+		log::info( "Connected to ", address );
+
+		ModelObjectiveUP objective;
+		String scenario_error = "No scenario received";
+		uint32_t type = 0;
+		String payload;
+		size_t evaluations = 0;
+		while ( receive_message( s, type, payload ) && type != msg_goodbye )
+		{
+			message_reader msg( payload );
+			if ( type == msg_scenario )
+			{
+				msg.read< uint64_t >(); // scenario id
+				auto zml = msg.read_string();
+				auto scenario_dir = path( msg.read_string() );
+				auto parameter_hash = msg.read< uint64_t >();
+
+				PropNode scenario_pn;
+				xo::error_code ec;
+				std::istringstream str( zml );
+				xo::prop_node_serializer_zml zml_reader( scenario_pn, &ec );
+				str >> zml_reader;
+				SCONE_ERROR_IF( !ec.good(), "Could not read scenario: " + ec.message() );
+
+				objective = CreateModelObjective( scenario_pn, scenario_dir );
+				log::info( "Received scenario ", objective->GetSignature(), " dim=", objective->dim() );
+				if ( GetParameterHash( objective->info() ) != parameter_hash )
+				{
+					// evaluations of this scenario are answered with an error
+					scenario_error = "Parameters of scenario " + objective->GetSignature() + " do not match the optimization";
+					log::error( scenario_error );
+					objective.reset();
+				}
+			}
+			else if ( type == msg_evaluate )
+			{
+				auto id = msg.read< uint64_t >();
+				auto n = msg.read< uint64_t >();
+				std::vector< double > values( n );
+				for ( auto& v : values )
+					v = msg.read< double >();
+
+				message_writer reply;
+				reply.write( id );
+				try
+				{
+					SCONE_ERROR_IF( !objective, scenario_error );
+					SCONE_ERROR_IF( n != objective->dim(), "Parameter count does not match scenario" );
+					SearchPoint point( objective->info(), values );
+					auto fitness = objective->evaluate( point, xo::stop_token() );
+					reply.write< uint8_t >( fitness ? 1 : 0 );
+					reply.write< fitness_t >( fitness ? fitness.value() : 0.0 );
+					reply.write_string( fitness ? "" : fitness.error().message() );
+				}
+				catch ( std::exception& e )
+				{
+					reply.write< uint8_t >( 0 );
+					reply.write< fitness_t >( 0.0 );
+					reply.write_string( e.what() );
+				}
+				if ( !send_message( s, msg_result, reply.buf ) )
+					break;
+				++evaluations;
+			}
+		}
+		log::info( "Disconnected from ", address, " after ", evaluations, " evaluations" );
+	}
+}
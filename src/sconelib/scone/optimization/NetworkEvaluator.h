@@ -0,0 +1,87 @@
+/*
+** NetworkEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "scone/core/PropNode.h"
+#include "scone/core/Socket.h"
+#include "Objective.h"
+#include "spot/evaluator.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace scone
+{
+	/// Evaluator that distributes evaluations over worker processes (sconecmd --worker) connected through sockets.
+	/** Workers can join and leave at any time; evaluations of lost workers are resubmitted to other workers.
+	A worker that does not reply within the timeout is considered lost. Each worker process evaluates one
+	point at a time on a single core, so start one worker per core to use all cores of a machine.
+	Workers receive the scenario once and create the model from scenario_dir, which must be accessible to them.
+	Workers must present the token of the evaluator, which is required for addresses other than localhost. */
+	class SCONE_API NetworkEvaluator : public spot::evaluator
+	{
+	public:
+		NetworkEvaluator( const String& address, double timeout = 600.0, const String& token = String() );
+		virtual ~NetworkEvaluator();
+
+		/// Set the scenario that is sent to the workers when evaluating objective o; must be called before evaluation.
+		/** Scenarios of different objectives can be set, the scenario of an objective is replaced if it was set before. */
+		void SetScenario( const spot::objective& o, const PropNode& scenario_pn, const path& scenario_dir );
+
+		virtual std::vector< result< fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+		size_t GetWorkerCount() const;
+		const String& GetAddress() const { return address_; }
+
+	protected:
+		/// Disconnect all workers and stop accepting new ones; called on destruction.
+		void Shutdown();
+
+		/// Called when the worker with this process id did not reply within the timeout.
+		virtual void OnWorkerTimeout( uint64_t process_id ) {}
+
+		const String& GetToken() const { return token_; }
+
+	private:
+		struct Batch;
+		struct Scenario { uint64_t id; String message; };
+		struct Job { uint64_t id; std::vector< double > values; s_ptr< Batch > batch; index_t index; int attempts; s_ptr< const Scenario > scenario; };
+		struct Worker { Socket socket; std::thread thread; uint64_t scenario_id = 0; uint64_t process_id = 0; bool finished = false; };
+
+		void AcceptConnections();
+		void ServeWorker( Worker& w );
+		void RemoveFinishedWorkers();
+
+		String address_;
+		double timeout_;
+		String token_;
+		Socket listener_;
+		std::thread accept_thread_;
+		std::atomic_bool shutdown_;
+
+		std::map< uint64_t, s_ptr< const Scenario > > scenarios_;
+		uint64_t scenario_id_;
+		uint64_t next_job_id_;
+		std::deque< Job > jobs_;
+		std::list< Worker > workers_;
+		mutable std::mutex mutex_;
+		std::condition_variable jobs_cv_;
+	};
+
+	/// Connect to a NetworkEvaluator and evaluate search points until the connection is closed.
+	/** The token is taken from the SCONE_WORKER_TOKEN environment variable, or from optimizer.network_token. */
+	void SCONE_API RunEvaluationWorker( const String& address );
+}
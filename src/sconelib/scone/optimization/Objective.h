@@ -13,6 +13,7 @@
 #include "spot/objective.h"
 #include "scone/core/system_tools.h"
 #include "scone/core/HasExternalResources.h"
+#include "FitnessCache.h"
 
 namespace scone
 {
@@ -31,8 +32,25 @@ namespace scone
 		const path& GetExternalResourceDir() const { return external_resource_dir_; }
 		void SetExternalResourceDir( const path& dir ) { external_resource_dir_ = dir; }
 
+		// optional cache for skipping evaluations of previously evaluated points
+		void SetFitnessCache( s_ptr< FitnessCache > cache ) { fitness_cache_ = std::move( cache ); }
+		const s_ptr< FitnessCache >& GetFitnessCache() const { return fitness_cache_; }
+
+		// true if the fitness of a point does not depend on the order of evaluations
+		virtual bool IsDeterministic() const { return true; }
+
+		// called by the optimizer before the candidates of a new generation are evaluated
+		virtual void BeginGeneration() {}
+
+		// called by the optimizer after the candidates of a generation are evaluated, before the results are used
+		virtual void EndGeneration( const spot::search_point_vec& points, std::vector< result< fitness_t > >& results ) {}
+
+		// true if EndGeneration() changes results, which requires all evaluations to take place in this process
+		virtual bool AdjustsGenerationResults() const { return false; }
+
 	protected:
 		// this is where external resources of the objective reside
 		path external_resource_dir_;
+		s_ptr< FitnessCache > fitness_cache_;
 	};
 }
@@ -13,6 +13,8 @@
 #include "scone/core/string_tools.h"
 #include "scone/core/Factories.h"
 #include "scone/core/math.h"
+#include "scone/core/ProfileAggregator.h"
+#include "scone/core/ProfileTimeline.h"
 #include "scone/optimization/Objective.h"
 
 #include "xo/filesystem/filesystem.h"
@@ -21,12 +23,33 @@
 #include "xo/serialization/serialize.h"
 #include "xo/serialization/prop_node_serializer_zml.h"
 #include "xo/system/error_code.h"
+#include <algorithm>
+#include <fstream>
 #include <mutex>
 #include <sstream>
 
 namespace scone
 {
 	std::mutex g_status_output_mutex;
+	const char checkpoint_header[] = { 'S', 'C', 'O', 'N', 'E', 'C', 'P', '3' };
+
+	static void WriteCheckpointString( std::ostream& str, const String& s )
+	{
+		uint64_t size = s.size();
+		str.write( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+		str.write( s.data(), s.size() );
+	}
+
+	static bool ReadCheckpointString( std::istream& str, String& s )
+	{
+		uint64_t size = 0;
+		str.read( reinterpret_cast<char*>( &size ), sizeof( size ) );
+		if ( !str.good() || size > 4096 )
+			return false;
+		s.resize( size );
+		str.read( s.data(), size );
+		return str.good();
+	}
 
 	Optimizer::Optimizer( const PropNode& props, const PropNode& scenario_pn, const path& scenario_dir ) :
 		HasSignature( props ),
@@ -59,6 +82,15 @@ namespace scone
 		INIT_PROP( props, min_progress, 1e-6 );
 		INIT_PROP( props, min_progress_samples, 200 );
 
+		INIT_PROP( props, use_fitness_cache, false );
+		INIT_PROP( props, fitness_cache_quantization, 1e-9 );
+		INIT_PROP( props, fitness_cache_file, path( "" ) );
+		INIT_PROP( props, fitness_cache_save_interval, 100 );
+		INIT_PROP( props, checkpoint_interval, 0 );
+		INIT_PROP( props, profile_interval, 0 );
+		INIT_PROP( props, profile_timeline_events, 0 );
+		INIT_PROP( props, evaluation_telemetry, false );
+
 		// initialize parameters from file
 		if ( use_init_file && !init_file.empty() )
 		{
@@ -66,6 +98,20 @@ namespace scone
 			auto result = GetObjective().info().import_mean_std( init_file, use_init_file_std, init_file_std_factor, init_file_std_offset );
 			log::debug( "Imported ", result.first, " of ", GetObjective().info().dim(), ", skipped ", result.second, " parameters from ", init_file );
 		}
+
+		// initialize fitness cache, which is also needed for checkpoints
+		if ( checkpoint_interval > 0 )
+			log::debug( "Checkpoints enable the fitness cache, which keeps all evaluations in memory" );
+		if ( use_fitness_cache || checkpoint_interval > 0 )
+		{
+			SetFitnessCache( std::make_shared< FitnessCache >( fitness_cache_quantization ) );
+			if ( !fitness_cache_file.empty() )
+			{
+				fitness_cache_file = FindFile( fitness_cache_file );
+				auto count = fitness_cache_->Load( fitness_cache_file );
+				log::debug( "Imported ", count, " cached fitness values from ", fitness_cache_file );
+			}
+		}
 	}
 
 	Optimizer::~Optimizer()
@@ -126,16 +172,123 @@ namespace scone
 		return s;
 	}
 
+	void Optimizer::SetFitnessCache( s_ptr< FitnessCache > cache )
+	{
+		fitness_cache_ = cache;
+		GetObjective().SetFitnessCache( std::move( cache ) );
+	}
+
+	void Optimizer::SaveFitnessCache() const
+	{
+		if ( fitness_cache_ && use_fitness_cache )
+		{
+			fitness_cache_->Save( GetOutputFolder() / "fitness_cache.txt" );
+			log::info( "Fitness cache: ", fitness_cache_->GetSize(), " entries, ", fitness_cache_->GetHitCount(), " hits, ", fitness_cache_->GetMissCount(), " misses" );
+		}
+	}
+
+	void Optimizer::SaveCheckpoint( size_t generation ) const
+	{
+		SCONE_ASSERT( fitness_cache_ );
+		if ( !IsDeterministic() )
+			return; // replaying evaluations would not restore the optimizer state
+
+		// write to temporary file first, so that an existing checkpoint survives a crash while writing
+		// the lock prevents concurrent writes, for instance by members of an optimizer pool
+		std::scoped_lock lock( checkpoint_mutex_ );
+		auto filename = GetOutputFolder() / "checkpoint.bin";
+		auto temp_filename = path( filename.str() + ".tmp" );
+		{
+			std::ofstream ostr( temp_filename.str(), std::ios::binary );
+			SCONE_ERROR_IF( !ostr.good(), "Could not write checkpoint " + temp_filename.str() );
+			auto folders = GetCheckpointFolders();
+			uint64_t gen = generation;
+			uint64_t folder_count = folders.size();
+			ostr.write( checkpoint_header, sizeof( checkpoint_header ) );
+			WriteCheckpointString( ostr, GetClassSignature() );
+			ostr.write( reinterpret_cast<const char*>( &gen ), sizeof( gen ) );
+			ostr.write( reinterpret_cast<const char*>( &folder_count ), sizeof( folder_count ) );
+			for ( auto& f : folders )
+				WriteCheckpointString( ostr, f );
+			fitness_cache_->Write( ostr );
+			SCONE_ERROR_IF( !ostr.good(), "Could not write checkpoint " + temp_filename.str() );
+		}
+		RenameFile( temp_filename, filename );
+		log::debug( "Saved checkpoint at generation ", generation, " with ", fitness_cache_->GetSize(), " evaluations" );
+	}
+
+	void Optimizer::SaveProfile() const
+	{
+		auto& pa = ProfileAggregator::GetInstance();
+		xo::save_file( pa.GetReport( &GetObjective() ), GetOutputFolder() / "profile.zml" );
+		log::debug( "Saved profile of ", pa.GetEvaluationCount( &GetObjective() ), " evaluations" );
+	}
+
+	void Optimizer::SaveProfileTimeline() const
+	{
+		auto& pt = ProfileTimeline::GetInstance();
+		pt.WriteChromeTrace( GetOutputFolder() / "profile.trace.json" );
+		pt.WriteFoldedStacks( GetOutputFolder() / "profile.folded" );
+		log::info( "Saved profile timeline with ", pt.GetEventCount(), " events" );
+		if ( auto dropped = pt.GetDroppedEventCount() )
+			log::warning( dropped, " profile events were dropped, increase profile_timeline_events to record all events" );
+	}
+
+	void Optimizer::SetResumeFolder( const path& folder )
+	{
+		SCONE_ASSERT( output_folder_.empty() );
+		resume_folder_ = folder;
+
+		auto filename = folder / "checkpoint.bin";
+		if ( !xo::file_exists( filename ) )
+			return; // no checkpoint written yet, the optimization restarts in the same folder
+
+		SCONE_ERROR_IF( !IsDeterministic(), "Cannot resume " + folder.str() + " because the optimization is not deterministic" );
+
+		std::ifstream istr( filename.str(), std::ios::binary );
+		char header[ sizeof( checkpoint_header ) ];
+		String signature;
+		uint64_t generation = 0, folder_count = 0;
+		istr.read( header, sizeof( header ) );
+		SCONE_ERROR_IF( !istr.good() || !std::equal( header, header + sizeof( header ), checkpoint_header ) || !ReadCheckpointString( istr, signature ),
+			"Invalid checkpoint file: " + filename.str() );
+		istr.read( reinterpret_cast<char*>( &generation ), sizeof( generation ) );
+		istr.read( reinterpret_cast<char*>( &folder_count ), sizeof( folder_count ) );
+		SCONE_ERROR_IF( !istr.good() || folder_count > 4096, "Invalid checkpoint file: " + filename.str() );
+		resume_folders_.resize( folder_count );
+		for ( auto& f : resume_folders_ )
+			SCONE_ERROR_IF( !ReadCheckpointString( istr, f ), "Invalid checkpoint file: " + filename.str() );
+		SCONE_ERROR_IF( signature != GetClassSignature(), "Cannot resume " + folder.str() + " because its signature (" + signature
+			+ ") differs from the current scenario (" + GetClassSignature() + ")" );
+
+		if ( !fitness_cache_ )
+			SetFitnessCache( std::make_shared< FitnessCache >( fitness_cache_quantization ) );
+		auto count = fitness_cache_->Read( istr );
+		log::info( "Resuming from generation ", generation, ", replaying ", count, " evaluations from ", filename );
+	}
+
 	void Optimizer::PrepareOutputFolder()
 	{
 		SCONE_ASSERT( output_folder_.empty() );
 
+		if ( IsResuming() && xo::exists( resume_folder_ ) )
+		{
+			// continue in the existing folder, which already contains config and resources
+			output_folder_ = resume_folder_;
+			id_ = output_folder_.filename().str();
+			if ( log_level_ < xo::log::level::never )
+				log_sink_ = std::make_unique<AsyncLogSink>(
+					GetOutputFolder() / "optimization.log", log_level_, xo::log::sink_mode::current_thread, true );
+			GetObjective().SetExternalResourceDir( GetOutputFolder() );
+			return;
+		}
+
 		output_folder_ = xo::create_unique_directory( output_root / GetSignature() );
 		id_ = output_folder_.filename().str();
 
 		// create log sink if enabled
 		if ( log_level_ < xo::log::level::never )
-			log_sink_ = std::make_unique<xo::log::file_sink>(
+			log_sink_ = std::make_unique<AsyncLogSink>(
 				GetOutputFolder() / "optimization.log", log_level_, xo::log::sink_mode::current_thread );
 
 		// prepare output folder, and initialize
@@ -12,8 +12,9 @@
 #include "Params.h"
 #include "scone/core/HasSignature.h"
 #include "scone/core/types.h"
-#include "xo/system/log_sink.h"
+#include "scone/core/AsyncLogSink.h"
 #include <deque>
+#include <mutex>
 
 namespace scone
 {
@@ -64,6 +65,35 @@ namespace scone
 		/// The maximum number of iterations without file output; default = 1000.
 		size_t max_generations_without_file_output;
 
+		/// Skip evaluation of parameter sets that have been evaluated before (deterministic scenarios only); default = false.
+		bool use_fitness_cache;
+
+		/// Step size to which parameter values are rounded when looking up cached fitness values; default = 1e-9.
+		double fitness_cache_quantization;
+
+		/// Fitness cache file (fitness_cache.txt) of a previous optimization to initialize the fitness cache; default = "".
+		path fitness_cache_file;
+
+		/// Number of generations after which the fitness cache is written to fitness_cache.txt, 0 = only at the end; default = 100.
+		size_t fitness_cache_save_interval;
+
+		/// Number of generations after which a checkpoint is written to the output folder, 0 = never; default = 0.
+		/// Resuming from a checkpoint replays all previous evaluations, restoring the exact optimizer state.
+		/// Checkpoints enable the fitness cache, which keeps all evaluations in memory, and are only written for deterministic optimizations.
+		size_t checkpoint_interval;
+
+		/// Number of generations after which the profile of all evaluations is written to profile.zml in the output folder, 0 = never; default = 0.
+		/// Profiled scopes are merged across the evaluations and threads of this optimizer, and a summary is included in the status output.
+		size_t profile_interval;
+
+		/// Maximum number of profiled scopes recorded per thread for a timeline of the optimization, 0 = off; default = 0.
+		/// The timeline is written to profile.trace.json (Chrome trace format) and profile.folded (folded stacks) in the output folder.
+		size_t profile_timeline_events;
+
+		/// Record the duration, simulated time and memory of each evaluation; default = false.
+		/// Percentiles per generation are included in the status output and written to telemetry.txt in the output folder.
+		bool evaluation_telemetry;
+
 		Objective& GetObjective() { return *m_Objective; }
 		const Objective& GetObjective() const { return *m_Objective; }
 		virtual void Run() = 0;
@@ -93,6 +123,29 @@ namespace scone
 
 		void PrepareOutputFolder();
 
+		// share a fitness cache, e.g. between optimizations in a pool
+		void SetFitnessCache( s_ptr< FitnessCache > cache );
+		const s_ptr< FitnessCache >& GetFitnessCache() const { return fitness_cache_; }
+		void SaveFitnessCache() const;
+
+		// checkpoints for resuming optimizations
+		void SaveCheckpoint( size_t generation ) const;
+		void SetResumeFolder( const path& folder );
+		bool IsResuming() const { return !resume_folder_.empty(); }
+
+		// folders of member optimizations, relative to the output folder, which are stored in the checkpoint
+		virtual std::vector< String > GetCheckpointFolders() const { return {}; }
+		const std::vector< String >& GetResumeFolders() const { return resume_folders_; }
+
+		// true if the optimization gives the same results when it is repeated, required for checkpoints
+		virtual bool IsDeterministic() const { return GetObjective().IsDeterministic(); }
+
+		// write the aggregated profile of all evaluations to the output folder
+		void SaveProfile() const;
+
+		// write the recorded profile timeline to the output folder
+		void SaveProfileTimeline() const;
+
 	protected:
 		ObjectiveUP m_Objective;
 		virtual String GetClassSignature() const override;
@@ -107,9 +160,13 @@ namespace scone
 		mutable String id_;
 
 		xo::log::level log_level_;
-		u_ptr< xo::log::file_sink > log_sink_;
+		u_ptr< AsyncLogSink > log_sink_;
 
 		PropNode scenario_pn_copy_; // copy for creating props in output folder
+		s_ptr< FitnessCache > fitness_cache_;
+		path resume_folder_;
+		std::vector< String > resume_folders_;
+		mutable std::mutex checkpoint_mutex_;
 	};
 
 	template< typename T >
@@ -0,0 +1,75 @@
+/*
+** ParamBindingPlan.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ParamBindingPlan.h"
+
+namespace scone
+{
+	ParamBinder::ParamBinder( SearchPoint& point, const ParamBindingPlan* plan ) :
+		point_( point ),
+		plan_( plan && plan->dim == point.info().size() ? plan : nullptr ),
+		position_( 0 ),
+		recording_( false )
+	{
+		if ( !plan_ )
+			StartRecording();
+	}
+
+	spot::optional_par_value ParamBinder::try_get( const String& full_name ) const
+	{
+		if ( !recording_ )
+		{
+			if ( position_ < plan_->bindings.size() && ( plan_->verified || plan_->bindings[ position_ ].name == full_name ) )
+			{
+				auto idx = plan_->bindings[ position_++ ].index;
+				if ( idx != no_index )
+					return point_.values()[ idx ];
+				else return spot::optional_par_value();
+			}
+			else StartRecording(); // lookup sequence differs from plan
+		}
+
+		auto it = name_index_.find( full_name );
+		recorded_.push_back( { full_name, it != name_index_.end() ? it->second : no_index } );
+		return point_.try_get( full_name );
+	}
+
+	spot::par_value ParamBinder::add( const ParInfo& pi )
+	{
+		return point_.add( pi );
+	}
+
+	bool ParamBinder::IsReplayed() const
+	{
+		return !recording_ && position_ == plan_->bindings.size();
+	}
+
+	ParamBindingPlan ParamBinder::ExtractPlan( const String& signature )
+	{
+		if ( !recording_ )
+			StartRecording(); // plan has unused bindings
+		return ParamBindingPlan{ signature, point_.info().size(), std::move( recorded_ ), false };
+	}
+
+	void ParamBinder::StartRecording() const
+	{
+		if ( recording_ )
+			return;
+
+		// bindings that were replayed successfully are kept
+		if ( plan_ )
+			recorded_.assign( plan_->bindings.begin(), plan_->bindings.begin() + position_ );
+
+		const auto& info = point_.info();
+		name_index_.reserve( info.size() );
+		for ( index_t i = 0; i < info.size(); ++i )
+			name_index_[ info[ i ].name ] = i;
+
+		recording_ = true;
+	}
+}
@@ -0,0 +1,70 @@
+/*
+** ParamBindingPlan.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "Params.h"
+
+#include <vector>
+#include <unordered_map>
+
+namespace scone
+{
+	/// Ordered list of parameter lookups performed during model construction.
+	struct SCONE_API ParamBindingPlan
+	{
+		struct Binding {
+			String name;
+			index_t index;
+		};
+
+		String signature;
+		size_t dim = 0;
+		std::vector< Binding > bindings;
+		bool verified = false; // a replay has matched the names of all bindings
+
+		bool IsValidFor( const String& sig, size_t d ) const { return signature == sig && dim == d; }
+	};
+
+	/// Params for model construction that replays a ParamBindingPlan, or records a new one.
+	/** Lookups are resolved by index into the SearchPoint. The names of a new plan are compared during its
+	first replay; after that, the plan is marked as verified and lookups are replayed by position only.
+	After the first mismatch, the binder falls back to regular lookups and records a new plan,
+	which starts with the bindings that were replayed before the mismatch. */
+	class SCONE_API ParamBinder : public Params
+	{
+	public:
+		ParamBinder( SearchPoint& point, const ParamBindingPlan* plan );
+		virtual ~ParamBinder() = default;
+
+		virtual size_t size() const override { return point_.size(); }
+		virtual spot::optional_par_value try_get( const String& full_name ) const override;
+		virtual spot::par_value add( const ParInfo& pi ) override;
+
+		/// true if all lookups were resolved using the plan
+		bool IsReplayed() const;
+
+		/// true if all lookups were resolved using a plan that was not verified before
+		bool IsFirstReplay() const { return IsReplayed() && !plan_->verified; }
+
+		/// get the plan recorded during construction; only valid if !IsReplayed()
+		ParamBindingPlan ExtractPlan( const String& signature );
+
+	private:
+		void StartRecording() const;
+
+		SearchPoint& point_;
+		const ParamBindingPlan* plan_;
+		mutable index_t position_;
+		mutable bool recording_;
+		mutable std::vector< ParamBindingPlan::Binding > recorded_;
+		mutable std::unordered_map< String, index_t > name_index_;
+	};
+}
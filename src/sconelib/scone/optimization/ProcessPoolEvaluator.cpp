@@ -0,0 +1,216 @@
+/*
+** ProcessPoolEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ProcessPoolEvaluator.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+#include "xo/system/system_tools.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#	define SCONE_SCONECMD_EXECUTABLE "sconecmd.exe"
+#else
+#	include <csignal>
+#	include <cstring>
+#	include <spawn.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#	define SCONE_SCONECMD_EXECUTABLE "sconecmd"
+extern char** environ;
+#endif
+
+namespace scone
+{
+	static String GetLocalWorkerAddress()
+	{
+#ifdef _WIN32
+		return "127.0.0.1:0"; // port is picked by the system
+#else
+		static std::atomic_int counter = 0;
+		return "unix:/tmp/scone-" + std::to_string( getpid() ) + "-" + std::to_string( counter++ ) + ".sock";
+#endif
+	}
+
+	// random token, so that only our own worker processes can connect
+	static String GenerateWorkerToken()
+	{
+		std::random_device rd;
+		String token;
+		char buf[ 9 ];
+		for ( int i = 0; i < 4; ++i )
+		{
+			std::snprintf( buf, sizeof( buf ), "%08x", static_cast<unsigned>( rd() ) );
+			token += buf;
+		}
+		return token;
+	}
+
+	// process id used to identify a worker over the network
+	static uint64_t GetNativeProcessId( intptr_t p )
+	{
+#ifdef _WIN32
+		return GetProcessId( reinterpret_cast<HANDLE>( p ) );
+#else
+		return uint64_t( p );
+#endif
+	}
+
+	ProcessPoolEvaluator::ProcessPoolEvaluator( size_t num_processes, double timeout ) :
+		NetworkEvaluator( GetLocalWorkerAddress(), timeout, GenerateWorkerToken() ),
+		stop_monitor_( false )
+	{
+		SCONE_ERROR_IF( num_processes == 0, "Number of worker processes must be > 0" );
+		for ( size_t i = 0; i < num_processes; ++i )
+			processes_.push_back( Process{ StartWorkerProcess() } );
+		monitor_thread_ = std::thread( &ProcessPoolEvaluator::MonitorProcesses, this );
+		log::info( "Started ", num_processes, " worker processes" );
+	}
+
+	ProcessPoolEvaluator::~ProcessPoolEvaluator()
+	{
+		{
+			std::scoped_lock lock( monitor_mutex_ );
+			stop_monitor_ = true;
+		}
+		monitor_cv_.notify_all();
+		if ( monitor_thread_.joinable() )
+			monitor_thread_.join();
+
+		// closing the connections makes the workers exit
+		Shutdown();
+
+		for ( auto& proc : processes_ )
+		{
+			auto p = proc.id;
+			if ( p == invalid_process )
+				continue;
+#ifdef _WIN32
+			auto h = reinterpret_cast<HANDLE>( p );
+			if ( WaitForSingleObject( h, 2000 ) != WAIT_OBJECT_0 )
+				TerminateProcess( h, 1 );
+			CloseHandle( h );
+#else
+			auto pid = static_cast<pid_t>( p );
+			int status = 0, attempts = 0;
+			while ( waitpid( pid, &status, WNOHANG ) == 0 )
+			{
+				if ( ++attempts == 20 )
+					kill( pid, SIGKILL );
+				std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+			}
+#endif
+		}
+
+#ifndef _WIN32
+		std::remove( GetAddress().substr( 5 ).c_str() ); // remove unix socket file
+#endif
+	}
+
+	ProcessPoolEvaluator::process_id_t ProcessPoolEvaluator::StartWorkerProcess() const
+	{
+		auto exe = ( xo::get_application_dir() / SCONE_SCONECMD_EXECUTABLE ).str();
+#ifdef _WIN32
+		auto cmd = "\"" + exe + "\" --worker " + GetAddress() + " -l 4";
+		SetEnvironmentVariableA( "SCONE_WORKER_TOKEN", GetToken().c_str() ); // inherited by the worker
+		STARTUPINFOA si{};
+		si.cb = sizeof( si );
+		PROCESS_INFORMATION pi{};
+		SCONE_ERROR_IF( !CreateProcessA( nullptr, &cmd[ 0 ], nullptr, nullptr, FALSE, BELOW_NORMAL_PRIORITY_CLASS, nullptr, nullptr, &si, &pi ),
+			"Could not start worker process " + exe );
+		CloseHandle( pi.hThread );
+		return reinterpret_cast<process_id_t>( pi.hProcess );
+#else
+		String address = GetAddress();
+		char* argv[] = { &exe[ 0 ], const_cast<char*>( "--worker" ), &address[ 0 ], const_cast<char*>( "-l" ), const_cast<char*>( "4" ), nullptr };
+
+		// pass the token through the environment, so that it doesn't show in the process list
+		String token_var = "SCONE_WORKER_TOKEN=" + GetToken();
+		std::vector< char* > envp;
+		for ( char** e = environ; *e; ++e )
+			if ( std::strncmp( *e, "SCONE_WORKER_TOKEN=", 19 ) != 0 )
+				envp.push_back( *e );
+		envp.push_back( &token_var[ 0 ] );
+		envp.push_back( nullptr );
+
+		pid_t pid = 0;
+		SCONE_ERROR_IF( posix_spawn( &pid, exe.c_str(), nullptr, nullptr, argv, envp.data() ) != 0,
+			"Could not start worker process " + exe );
+		return static_cast<process_id_t>( pid );
+#endif
+	}
+
+	void ProcessPoolEvaluator::MonitorProcesses()
+	{
+		std::unique_lock lock( monitor_mutex_ );
+		while ( !monitor_cv_.wait_for( lock, std::chrono::milliseconds( 500 ), [&]() { return stop_monitor_.load(); } ) )
+		{
+			auto now = std::chrono::steady_clock::now();
+			for ( auto& p : processes_ )
+			{
+				if ( p.id != invalid_process )
+				{
+#ifdef _WIN32
+					auto h = reinterpret_cast<HANDLE>( p.id );
+					bool exited = WaitForSingleObject( h, 0 ) == WAIT_OBJECT_0;
+					if ( exited )
+						CloseHandle( h );
+#else
+					int status = 0;
+					bool exited = waitpid( static_cast<pid_t>( p.id ), &status, WNOHANG ) != 0;
+#endif
+					if ( !exited )
+						continue;
+
+					// evaluations of the lost process are resubmitted by NetworkEvaluator
+					log::warning( "Worker process exited unexpectedly, starting new worker" );
+					p.id = invalid_process;
+				}
+				else if ( now < p.retry_time )
+					continue;
+
+				try
+				{
+					p.id = StartWorkerProcess();
+					p.failures = 0;
+				}
+				catch ( std::exception& e )
+				{
+					// retry after 1, 2, 4, ... 60 seconds
+					auto delay = std::min( 60, 1 << std::min( p.failures++, 6 ) );
+					p.retry_time = now + std::chrono::seconds( delay );
+					log::error( e.what(), ", retrying in ", delay, "s" );
+				}
+			}
+		}
+	}
+
+	void ProcessPoolEvaluator::OnWorkerTimeout( uint64_t process_id )
+	{
+		// the hung process is terminated here and restarted by MonitorProcesses()
+		std::scoped_lock lock( monitor_mutex_ );
+		for ( auto& p : processes_ )
+		{
+			if ( p.id != invalid_process && GetNativeProcessId( p.id ) == process_id )
+			{
+				log::warning( "Terminating unresponsive worker process ", process_id );
+#ifdef _WIN32
+				TerminateProcess( reinterpret_cast<HANDLE>( p.id ), 1 );
+#else
+				kill( static_cast<pid_t>( p.id ), SIGKILL );
+#endif
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+/*
+** ProcessPoolEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "NetworkEvaluator.h"
+#include <chrono>
+
+namespace scone
+{
+	/// Evaluator that runs evaluations in a pool of local sconecmd worker processes.
+	/** Each process has its own address space, so there is no contention on global mutexes, caches
+	or the heap. Workers that crash or don't reply within the timeout are restarted, and their evaluation
+	is resubmitted. If a worker cannot be started, it is retried after an increasing delay. */
+	class SCONE_API ProcessPoolEvaluator : public NetworkEvaluator
+	{
+	public:
+		ProcessPoolEvaluator( size_t num_processes, double timeout = 600.0 );
+		virtual ~ProcessPoolEvaluator();
+
+		size_t GetProcessCount() const { return processes_.size(); }
+
+	protected:
+		virtual void OnWorkerTimeout( uint64_t process_id ) override;
+
+	private:
+		using process_id_t = intptr_t;
+		static constexpr process_id_t invalid_process = -1;
+		process_id_t StartWorkerProcess() const;
+		void MonitorProcesses();
+
+		struct Process {
+			process_id_t id;
+			int failures = 0;
+			std::chrono::steady_clock::time_point retry_time;
+		};
+		std::vector< Process > processes_;
+		std::thread monitor_thread_;
+		std::atomic_bool stop_monitor_;
+		std::mutex monitor_mutex_;
+		std::condition_variable monitor_cv_;
+	};
+}
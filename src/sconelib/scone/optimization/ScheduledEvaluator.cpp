@@ -0,0 +1,202 @@
+/*
+** ScheduledEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ScheduledEvaluator.h"
+
+#include "scone/core/Exception.h"
+#include "xo/time/timer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace scone
+{
+	// hash of the exact parameter values, used to match timings to search points
+	static uint64_t GetValueHash( const std::vector< double >& values )
+	{
+		uint64_t h = 14695981039346656037ull;
+		for ( auto v : values )
+		{
+			uint64_t bits;
+			std::memcpy( &bits, &v, sizeof( bits ) );
+			h = ( h ^ bits ) * 1099511628211ull;
+		}
+		return h;
+	}
+
+	/// Objective that forwards evaluation to a target objective and records the wall time of each evaluation.
+	class ScheduledEvaluator::TimedObjective : public spot::objective
+	{
+	public:
+		TimedObjective( const spot::objective& target ) : target_( target ) { info_ = target.info(); }
+
+		virtual result< fitness_t > evaluate( const spot::search_point& point, const xo::stop_token& st ) const override {
+			xo::timer t;
+			auto r = target_.evaluate( point, st );
+			auto duration = t().seconds();
+			std::scoped_lock lock( mutex_ );
+			durations_[ GetValueHash( point.values() ) ] = duration;
+			return r;
+		}
+
+		std::unordered_map< uint64_t, double > TakeDurations() const {
+			std::unordered_map< uint64_t, double > durations;
+			std::scoped_lock lock( mutex_ );
+			durations.swap( durations_ );
+			return durations;
+		}
+
+	private:
+		const spot::objective& target_;
+		mutable std::unordered_map< uint64_t, double > durations_;
+		mutable std::mutex mutex_;
+	};
+
+	ScheduledEvaluator::ScheduledEvaluator( spot::evaluator& target, size_t history_size, size_t neighbours ) :
+		target_( target ),
+		history_size_( history_size ),
+		neighbours_( neighbours ),
+		longest_first_( true )
+	{
+		SCONE_ERROR_IF( neighbours_ == 0, "Number of neighbours must be > 0" );
+	}
+
+	ScheduledEvaluator::~ScheduledEvaluator()
+	{}
+
+	std::vector< result< fitness_t > > ScheduledEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		TimedObjective* timed_objective;
+		std::vector< double > predicted;
+		{
+			std::scoped_lock lock( mutex_ );
+			auto& data = GetObjectiveData( o );
+			timed_objective = data.timed_objective.get();
+			if ( longest_first_ )
+				predicted = PredictDurations( o, data.history, point_vec );
+		}
+
+		// longest expected duration first; without predictions the order stays the same
+		std::vector< index_t > order( point_vec.size() );
+		std::iota( order.begin(), order.end(), index_t( 0 ) );
+		if ( !predicted.empty() )
+			std::stable_sort( order.begin(), order.end(), [&]( index_t a, index_t b ) { return predicted[ a ] > predicted[ b ]; } );
+
+		spot::search_point_vec ordered_points;
+		ordered_points.reserve( point_vec.size() );
+		for ( auto i : order )
+			ordered_points.push_back( point_vec[ i ] );
+
+		xo::timer t;
+		auto ordered_results = target_.evaluate( *timed_objective, ordered_points, st, prio );
+		auto wall_time = t().seconds();
+
+		std::vector< result< fitness_t > > results( point_vec.size(), xo::error_message( "Evaluation canceled" ) );
+		for ( index_t k = 0; k < order.size() && k < ordered_results.size(); ++k )
+			results[ order[ k ] ] = std::move( ordered_results[ k ] );
+
+		// store timings, evaluations that did not run (e.g. when stopped) get a duration of zero
+		auto durations = timed_objective->TakeDurations();
+		std::scoped_lock lock( mutex_ );
+		auto& data = GetObjectiveData( o );
+		data.last_batch.durations.assign( point_vec.size(), 0.0 );
+		for ( index_t i = 0; i < point_vec.size(); ++i )
+		{
+			if ( auto it = durations.find( GetValueHash( point_vec[ i ].values() ) ); it != durations.end() )
+			{
+				data.last_batch.durations[ i ] = it->second;
+				data.history.push_back( Record{ point_vec[ i ].values(), it->second } );
+			}
+		}
+		while ( data.history.size() > history_size_ )
+			data.history.pop_front();
+		data.last_batch.predicted = std::move( predicted );
+		data.last_batch.wall_time = wall_time;
+
+		return results;
+	}
+
+	ScheduledEvaluator::BatchTiming ScheduledEvaluator::GetLastBatchTiming( const spot::objective& o ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		if ( auto it = objectives_.find( &o ); it != objectives_.end() )
+			return it->second.last_batch;
+		return BatchTiming();
+	}
+
+	const spot::objective& ScheduledEvaluator::GetTargetObjective( const spot::objective& o )
+	{
+		std::scoped_lock lock( mutex_ );
+		return *GetObjectiveData( o ).timed_objective;
+	}
+
+	void ScheduledEvaluator::RemoveObjective( const spot::objective& o )
+	{
+		// objectives are identified by address, which can be reused by a new objective
+		std::scoped_lock lock( mutex_ );
+		objectives_.erase( &o );
+	}
+
+	ScheduledEvaluator::ObjectiveData& ScheduledEvaluator::GetObjectiveData( const spot::objective& o )
+	{
+		auto& data = objectives_[ &o ];
+		if ( !data.timed_objective )
+			data.timed_objective = std::make_unique< TimedObjective >( o );
+		return data;
+	}
+
+	std::vector< double > ScheduledEvaluator::PredictDurations( const spot::objective& o, const std::deque< Record >& history, const spot::search_point_vec& point_vec ) const
+	{
+		if ( history.empty() )
+			return {};
+
+		const auto& info = o.info();
+		std::vector< double > scale( info.dim() );
+		for ( index_t i = 0; i < scale.size(); ++i )
+			scale[ i ] = info[ i ].std > 0 ? 1.0 / info[ i ].std : 1.0;
+
+		// inverse-distance weighted average of the nearest recorded evaluations
+		std::vector< double > predicted( point_vec.size() );
+		std::vector< std::pair< double, double > > dist;
+		dist.reserve( history.size() );
+		for ( index_t p = 0; p < point_vec.size(); ++p )
+		{
+			const auto& values = point_vec[ p ].values();
+			if ( values.size() != scale.size() )
+				return {};
+			dist.clear();
+			for ( index_t h = 0; h < history.size(); ++h )
+			{
+				if ( history[ h ].values.size() != scale.size() )
+					continue;
+				double d2 = 0.0;
+				for ( index_t i = 0; i < scale.size(); ++i )
+				{
+					auto d = ( values[ i ] - history[ h ].values[ i ] ) * scale[ i ];
+					d2 += d * d;
+				}
+				dist.emplace_back( d2, history[ h ].duration );
+			}
+			if ( dist.empty() )
+				return {};
+			auto k = std::min( neighbours_, dist.size() );
+			std::partial_sort( dist.begin(), dist.begin() + k, dist.end() );
+			double sum_w = 0.0, sum_wd = 0.0;
+			for ( index_t n = 0; n < k; ++n )
+			{
+				auto w = 1.0 / ( std::sqrt( dist[ n ].first ) + 1e-9 );
+				sum_w += w;
+				sum_wd += w * dist[ n ].second;
+			}
+			predicted[ p ] = sum_wd / sum_w;
+		}
+		return predicted;
+	}
+}
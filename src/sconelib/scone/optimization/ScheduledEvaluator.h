@@ -0,0 +1,77 @@
+/*
+** ScheduledEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "scone/core/memory_tools.h"
+#include "spot/evaluator.h"
+#include "spot/objective.h"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace scone
+{
+	/// Evaluator that records the duration of each evaluation, and dispatches the candidates that are expected to take longest first.
+	/** The duration of each candidate is predicted from the recorded durations of its nearest neighbours
+	in parameter space (measured in units of the parameter std), or left unchanged if there are no records yet.
+	Evaluation is forwarded to a target evaluator, which is expected to start evaluations in order.
+	This reduces the time at the end of a generation during which only a few threads are busy.
+	If longest-first is disabled, candidates are dispatched in their original order and only the durations are recorded. */
+	class SCONE_API ScheduledEvaluator : public spot::evaluator
+	{
+	public:
+		ScheduledEvaluator( spot::evaluator& target, size_t history_size = 256, size_t neighbours = 3 );
+		virtual ~ScheduledEvaluator();
+
+		/// Dispatch the candidates with the longest predicted duration first; default = true.
+		void SetLongestFirst( bool enable ) { longest_first_ = enable; }
+		bool GetLongestFirst() const { return longest_first_; }
+
+		virtual std::vector< result< fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+		/// Timing of the most recent evaluate() call for an objective.
+		struct BatchTiming {
+			std::vector< double > durations; // wall time per evaluation, in the original order
+			std::vector< double > predicted; // predicted wall time, or empty if there was no history
+			double wall_time = 0.0;
+		};
+		BatchTiming GetLastBatchTiming( const spot::objective& o ) const;
+
+		spot::evaluator& GetTarget() { return target_; }
+
+		/// The objective that is passed to the target evaluator when evaluating o.
+		const spot::objective& GetTargetObjective( const spot::objective& o );
+
+		/// Remove the recorded data of an objective, must be called before the objective is destroyed.
+		void RemoveObjective( const spot::objective& o );
+
+	private:
+		class TimedObjective;
+		struct Record { std::vector< double > values; double duration; };
+		struct ObjectiveData {
+			u_ptr< TimedObjective > timed_objective;
+			std::deque< Record > history;
+			BatchTiming last_batch;
+		};
+
+		ObjectiveData& GetObjectiveData( const spot::objective& o );
+		std::vector< double > PredictDurations( const spot::objective& o, const std::deque< Record >& history, const spot::search_point_vec& point_vec ) const;
+
+		spot::evaluator& target_;
+		size_t history_size_;
+		size_t neighbours_;
+		std::atomic_bool longest_first_;
+		std::map< const spot::objective*, ObjectiveData > objectives_;
+		mutable std::mutex mutex_;
+	};
+}
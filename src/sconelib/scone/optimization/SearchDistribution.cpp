@@ -0,0 +1,120 @@
+/*
+** SearchDistribution.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "SearchDistribution.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+#include "scone/core/system_tools.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+
+namespace scone
+{
+	double SearchDistribution::GetStd( index_t i ) const
+	{
+		return std::sqrt( std::max( 0.0, covariance[ i * dim() + i ] ) );
+	}
+
+	void SearchDistribution::Save( const path& filename ) const
+	{
+		// write to temporary file first, so that a crash never leaves an incomplete file
+		auto temp_filename = path( filename.str() + ".tmp" );
+		{
+			std::ofstream str( temp_filename.str() );
+			SCONE_ERROR_IF( !str.good(), "Could not create " + temp_filename.str() );
+			str << std::setprecision( 17 ) << dim() << "\n";
+			for ( index_t i = 0; i < dim(); ++i )
+				str << names[ i ] << "\t" << mean[ i ] << "\n";
+			for ( index_t i = 0; i < dim(); ++i )
+			{
+				for ( index_t j = 0; j < dim(); ++j )
+					str << ( j > 0 ? "\t" : "" ) << covariance[ i * dim() + j ];
+				str << "\n";
+			}
+		}
+		RenameFile( temp_filename, filename );
+	}
+
+	SearchDistribution SearchDistribution::Load( const path& filename )
+	{
+		std::ifstream str( filename.str() );
+		SCONE_ERROR_IF( !str.good(), "Could not open " + filename.str() );
+
+		SearchDistribution d;
+		size_t n = 0;
+		str >> n;
+		d.names.resize( n );
+		d.mean.resize( n );
+		d.covariance.resize( n * n );
+		for ( index_t i = 0; i < n; ++i )
+			str >> d.names[ i ] >> d.mean[ i ];
+		for ( auto& c : d.covariance )
+			str >> c;
+		SCONE_ERROR_IF( str.fail(), "Error reading search distribution from " + filename.str() );
+		return d;
+	}
+
+	std::vector< double > SearchDistribution::ApplyTo( ObjectiveInfo& info, double regularization ) const
+	{
+		std::unordered_map< String, index_t > source_index;
+		for ( index_t i = 0; i < dim(); ++i )
+			source_index[ names[ i ] ] = i;
+
+		// map parameters by name, and compute the average std reduction of the imported parameters
+		const auto n = info.dim();
+		std::vector< index_t > source( n, no_index );
+		double std_ratio_sum = 0.0;
+		size_t imported = 0;
+		for ( index_t i = 0; i < n; ++i )
+		{
+			if ( auto it = source_index.find( info[ i ].name ); it != source_index.end() )
+			{
+				source[ i ] = it->second;
+				if ( info[ i ].std > 0 )
+					std_ratio_sum += GetStd( it->second ) / info[ i ].std;
+				++imported;
+			}
+		}
+		auto added_std_factor = imported > 0 && std_ratio_sum > 0 ? std_ratio_sum / imported : 1.0;
+		const double min_std_fraction = 1e-6, min_std = 1e-12;
+
+		for ( index_t i = 0; i < n; ++i )
+		{
+			if ( source[ i ] != no_index )
+			{
+				// a collapsed distribution would never be searched, so the std is kept positive
+				info[ i ].mean = mean[ source[ i ] ];
+				info[ i ].std = std::max( GetStd( source[ i ] ), std::max( min_std_fraction * info[ i ].std, min_std ) );
+			}
+			else info[ i ].std *= added_std_factor;
+		}
+
+		// correlation matrix, which is the covariance in coordinates normalized by the new std
+		std::vector< double > corr( n * n, 0.0 );
+		for ( index_t i = 0; i < n; ++i )
+		{
+			corr[ i * n + i ] = 1.0;
+			for ( index_t j = 0; j < i; ++j )
+			{
+				if ( source[ i ] != no_index && source[ j ] != no_index )
+				{
+					auto si = GetStd( source[ i ] ), sj = GetStd( source[ j ] );
+					if ( si > 0 && sj > 0 )
+						corr[ i * n + j ] = corr[ j * n + i ] = ( 1 - regularization ) * covariance[ source[ i ] * dim() + source[ j ] ] / ( si * sj );
+				}
+			}
+		}
+
+		log::info( "Imported search distribution of ", imported, " of ", n, " parameters; std of other parameters scaled by ", added_std_factor );
+		return corr;
+	}
+}
@@ -0,0 +1,41 @@
+/*
+** SearchDistribution.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "Params.h"
+
+#include <vector>
+
+namespace scone
+{
+	/// Multivariate normal search distribution of an optimization, in parameter units.
+	/** Used to start a new optimization from the mean, step size and covariance of a previous one.
+	Parameters are identified by name, so that distributions can be transferred between different parameter sets. */
+	struct SCONE_API SearchDistribution
+	{
+		std::vector< String > names;
+		std::vector< double > mean;
+		std::vector< double > covariance; // row-major, includes the step size
+
+		size_t dim() const { return names.size(); }
+		double GetStd( index_t i ) const;
+
+		void Save( const path& filename ) const;
+		static SearchDistribution Load( const path& filename );
+
+		/// Create the distribution for the parameters in info, and set mean and std of info accordingly.
+		/** Returns the correlation matrix in info-normalized coordinates. Parameters not in this distribution keep
+		their mean and get their std multiplied by the average std reduction of the imported parameters.
+		Correlations are shrunk towards zero by a fraction of regularization. The std of imported parameters is at least
+		1e-6 times their original std. */
+		std::vector< double > ApplyTo( ObjectiveInfo& info, double regularization ) const;
+	};
+}
@@ -15,6 +15,8 @@
 #include "scone/core/string_tools.h"
 #include "scone/core/system_tools.h"
 #include "scone/core/Factories.h"
+#include <algorithm>
+#include <optional>
 
 namespace scone
 {
@@ -25,8 +27,13 @@ namespace scone
 		SCONE_THROW_IF( !model_->GetMeasure(), "No Measure defined in ModelObjective" );
 
 		INIT_PROP( pn, max_duration, 1e12 );
+		INIT_PROP( pn, short_horizon, 0.0 );
+		INIT_PROP( pn, short_horizon_fraction, 0.5 );
+		SCONE_ERROR_IF( short_horizon_fraction <= 0 || short_horizon_fraction > 1, "short_horizon_fraction must be between 0 and 1" );
 
 		signature_ += stringf( ".D%.0f", max_duration );
+		if ( UsesShortHorizon() )
+			signature_ += stringf( ".S%g", short_horizon );
 	}
 
 	SimulationObjective::~SimulationObjective()
@@ -36,4 +43,103 @@ namespace scone
 	{
 		m.AdvanceSimulationTo( t );
 	}
+
+	bool SimulationObjective::SimulateUntil( Model& m, TimeInSeconds end_time, const xo::stop_token& st ) const
+	{
+		m.SetSimulationEndTime( end_time );
+		while ( !m.HasSimulationEnded() )
+		{
+			if ( st.stop_requested() )
+				return false;
+			AdvanceSimulationTo( m, std::min( m.GetTime() + evaluation_step_size_, end_time ) );
+		}
+		return true;
+	}
+
+	result<fitness_t> SimulationObjective::EvaluateCandidate( Model& m, const xo::stop_token& st ) const
+	{
+		if ( !UsesShortHorizon() )
+			return EvaluateModel( m, st );
+
+		// first stage, results of simulations that terminate early (e.g. after a fall) are final
+		if ( !SimulateUntil( m, short_horizon, st ) )
+			return xo::error_message( "Optimization canceled" );
+		if ( m.GetTime() < short_horizon )
+			return GetResult( m );
+
+		// compare the intermediate result to that of the other candidates of this generation
+		auto partial = GetResult( m );
+		bool proceed = true;
+		{
+			std::scoped_lock lock( generation_mutex_ );
+			if ( generation_partial_.size() >= 4 )
+			{
+				auto sorted = generation_partial_;
+				auto n = std::min( sorted.size() - 1, size_t( short_horizon_fraction * sorted.size() ) );
+				std::nth_element( sorted.begin(), sorted.begin() + n, sorted.end(), [&]( auto a, auto b ) { return IsBetter( a, b ); } );
+				proceed = !IsBetter( sorted[ n ], partial );
+			}
+			generation_partial_.push_back( partial );
+		}
+
+		// the intermediate result is replaced by EndGeneration(), after all candidates are evaluated
+		if ( !proceed )
+			return partial;
+
+		// second stage, continue the same simulation until max_duration
+		m.GetMeasure()->ResetResult();
+		if ( !SimulateUntil( m, max_duration, st ) )
+			return xo::error_message( "Optimization canceled" );
+		return GetResult( m );
+	}
+
+	bool SimulationObjective::IsPartialResult( const Model& m ) const
+	{
+		// candidates that were screened out stopped at short_horizon
+		return UsesShortHorizon() && m.GetSimulationEndTime() < max_duration && m.GetTime() >= short_horizon;
+	}
+
+	void SimulationObjective::AddPartialResult( const SearchPoint& point, fitness_t fitness ) const
+	{
+		std::scoped_lock lock( generation_mutex_ );
+		generation_screened_[ point.values() ] = fitness;
+	}
+
+	void SimulationObjective::BeginGeneration()
+	{
+		std::scoped_lock lock( generation_mutex_ );
+		generation_partial_.clear();
+		generation_screened_.clear();
+	}
+
+	void SimulationObjective::EndGeneration( const spot::search_point_vec& points, std::vector< result< fitness_t > >& results )
+	{
+		std::scoped_lock lock( generation_mutex_ );
+		if ( generation_screened_.empty() )
+			return;
+
+		// find the screened candidates, and the worst full-duration result
+		std::vector< std::pair< fitness_t, index_t > > screened;
+		std::optional< fitness_t > worst;
+		for ( index_t i = 0; i < points.size() && i < results.size(); ++i )
+		{
+			if ( !results[ i ] )
+				continue;
+			if ( auto it = generation_screened_.find( points[ i ].values() ); it != generation_screened_.end() )
+				screened.emplace_back( it->second, i );
+			else if ( !worst || IsBetter( *worst, results[ i ].value() ) )
+				worst = results[ i ].value();
+		}
+		if ( screened.empty() || !worst )
+			return; // without full-duration results, the intermediate results keep their order
+
+		// screened candidates are ranked below the worst full-duration result, in the order of their intermediate result
+		std::stable_sort( screened.begin(), screened.end(), [&]( auto& a, auto& b ) { return IsBetter( a.first, b.first ); } );
+		auto step = 1e-6 * std::max( 1.0, std::abs( *worst ) );
+		for ( index_t k = 0; k < screened.size(); ++k )
+		{
+			auto penalty = std::abs( screened[ k ].first - screened.front().first ) + step * ( k + 1 );
+			results[ screened[ k ].second ] = info().minimize() ? *worst + penalty : *worst - penalty;
+		}
+	}
 }
@@ -17,6 +17,8 @@
 #include <vector>
 #include "xo/filesystem/path.h"
 #include "ModelObjective.h"
+#include <map>
+#include <mutex>
 
 namespace scone
 {
@@ -30,9 +32,41 @@ namespace scone
 		/// Maximum duration after which the evaluation is terminated; default = 1e12 (+/-31000 years)
 		double max_duration;
 
+		/// Duration of the first stage of a two-stage evaluation, 0 means evaluations always run to max_duration; default = 0.
+		/** Only candidates whose fitness at short_horizon is among the best short_horizon_fraction of the candidates
+		of the current generation continue to max_duration. When all candidates of the generation are evaluated,
+		the other candidates get a fitness worse than the worst full-duration result of the generation, in the order
+		of their fitness at short_horizon; they are not added to the fitness cache. The comparison only includes
+		candidates whose first stage has finished, which depends on the order in which evaluations finish;
+		optimizations with short_horizon are therefore not reproducible, and cannot be resumed from a checkpoint.
+		Two-stage evaluations require evaluation threads in the optimization process, and cannot be used with
+		async_evaluation or with network or process evaluation. */
+		double short_horizon;
+
+		/// Fraction of candidates that continue after the first stage of a two-stage evaluation; default = 0.5.
+		double short_horizon_fraction;
+
+		virtual result<fitness_t> EvaluateCandidate( Model& m, const xo::stop_token& st ) const override;
 		virtual void AdvanceSimulationTo( Model& m, TimeInSeconds t ) const override;
 		virtual TimeInSeconds GetDuration() const override { return max_duration; }
 		virtual fitness_t GetResult( Model& m ) const override { return m.GetMeasure()->GetWeightedResult( m ); }
 		virtual PropNode GetReport( Model& m ) const override { return m.GetMeasure()->GetReport(); }
+		virtual bool IsDeterministic() const override { return !UsesShortHorizon(); }
+		virtual bool IsPartialResult( const Model& m ) const override;
+		virtual void AddPartialResult( const SearchPoint& point, fitness_t fitness ) const override;
+		virtual void BeginGeneration() override;
+		virtual void EndGeneration( const spot::search_point_vec& points, std::vector< result< fitness_t > >& results ) override;
+		virtual bool AdjustsGenerationResults() const override { return UsesShortHorizon(); }
+
+		bool UsesShortHorizon() const { return short_horizon > 0 && short_horizon < max_duration; }
+
+	private:
+		bool SimulateUntil( Model& m, TimeInSeconds end_time, const xo::stop_token& st ) const;
+		bool IsBetter( fitness_t a, fitness_t b ) const { return info().minimize() ? a < b : a > b; }
+
+		// results of two-stage evaluations in the current generation
+		mutable std::vector< fitness_t > generation_partial_;
+		mutable std::map< spot::par_vec, fitness_t > generation_screened_;
+		mutable std::mutex generation_mutex_;
 	};
 }
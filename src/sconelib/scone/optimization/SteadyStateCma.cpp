@@ -0,0 +1,287 @@
+/*
+** SteadyStateCma.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "SteadyStateCma.h"
+
+#include "scone/core/Exception.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace scone
+{
+	// eigen decomposition of symmetric matrix a (n x n, row-major) using cyclic Jacobi rotations
+	// eigenvalues are stored in d, eigenvectors in the columns of v
+	static void symmetric_eigen( size_t n, std::vector< double > a, std::vector< double >& d, std::vector< double >& v )
+	{
+		v.assign( n * n, 0.0 );
+		for ( size_t i = 0; i < n; ++i )
+			v[ i * n + i ] = 1.0;
+
+		for ( int sweep = 0; sweep < 50; ++sweep )
+		{
+			double off = 0.0;
+			for ( size_t p = 0; p < n; ++p )
+				for ( size_t q = p + 1; q < n; ++q )
+					off += a[ p * n + q ] * a[ p * n + q ];
+			if ( off < 1e-30 )
+				break;
+
+			for ( size_t p = 0; p < n; ++p )
+			{
+				for ( size_t q = p + 1; q < n; ++q )
+				{
+					double apq = a[ p * n + q ];
+					if ( std::abs( apq ) < 1e-300 )
+						continue;
+					double theta = ( a[ q * n + q ] - a[ p * n + p ] ) / ( 2 * apq );
+					double t = ( theta >= 0 ? 1.0 : -1.0 ) / ( std::abs( theta ) + std::sqrt( theta * theta + 1 ) );
+					double c = 1 / std::sqrt( t * t + 1 ), s = t * c;
+					for ( size_t k = 0; k < n; ++k )
+					{
+						double akp = a[ k * n + p ], akq = a[ k * n + q ];
+						a[ k * n + p ] = c * akp - s * akq;
+						a[ k * n + q ] = s * akp + c * akq;
+					}
+					for ( size_t k = 0; k < n; ++k )
+					{
+						double apk = a[ p * n + k ], aqk = a[ q * n + k ];
+						a[ p * n + k ] = c * apk - s * aqk;
+						a[ q * n + k ] = s * apk + c * aqk;
+					}
+					for ( size_t k = 0; k < n; ++k )
+					{
+						double vkp = v[ k * n + p ], vkq = v[ k * n + q ];
+						v[ k * n + p ] = c * vkp - s * vkq;
+						v[ k * n + q ] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		d.resize( n );
+		for ( size_t i = 0; i < n; ++i )
+			d[ i ] = a[ i * n + i ];
+	}
+
+	SteadyStateCma::SteadyStateCma( size_t dim, int lambda, double sigma, long random_seed, bool minimize ) :
+		n_( dim ),
+		lambda_( lambda > 0 ? lambda : 4 + int( 3 * std::log( double( dim ) ) ) ),
+		mu_( lambda_ / 2 ),
+		minimize_( minimize ),
+		sigma_( sigma ),
+		mean_( dim, 0.0 ),
+		generation_mean_( dim, 0.0 ),
+		C_( dim * dim, 0.0 ),
+		decomposition_{ vec_t( dim * dim, 0.0 ), vec_t( dim, 1.0 ) },
+		decomposition_pending_( false ),
+		pc_( dim, 0.0 ),
+		ps_( dim, 0.0 ),
+		generation_( 0 ),
+		generation_evaluations_( 0 ),
+		eigen_generation_( 0 ),
+		rng_( random_seed )
+	{
+		SCONE_ASSERT( n_ > 0 && mu_ > 0 );
+		for ( size_t i = 0; i < n_; ++i )
+			C_[ i * n_ + i ] = decomposition_.B[ i * n_ + i ] = 1.0;
+
+		// recombination weights and strategy parameters, see [Hansen 2016]
+		weights_.resize( mu_ );
+		for ( int i = 0; i < mu_; ++i )
+			weights_[ i ] = std::log( ( lambda_ + 1 ) / 2.0 ) - std::log( i + 1.0 );
+		auto sum_w = std::accumulate( weights_.begin(), weights_.end(), 0.0 );
+		for ( auto& w : weights_ )
+			w /= sum_w;
+		mu_eff_ = 1.0 / std::inner_product( weights_.begin(), weights_.end(), weights_.begin(), 0.0 );
+
+		double n = double( n_ );
+		cs_ = ( mu_eff_ + 2 ) / ( n + mu_eff_ + 5 );
+		ds_ = 1 + 2 * std::max( 0.0, std::sqrt( ( mu_eff_ - 1 ) / ( n + 1 ) ) - 1 ) + cs_;
+		cc_ = ( 4 + mu_eff_ / n ) / ( n + 4 + 2 * mu_eff_ / n );
+		c1_ = 2 / ( ( n + 1.3 ) * ( n + 1.3 ) + mu_eff_ );
+		cmu_ = std::min( 1 - c1_, 2 * ( mu_eff_ - 2 + 1 / mu_eff_ ) / ( ( n + 2 ) * ( n + 2 ) + mu_eff_ ) );
+		chi_n_ = std::sqrt( n ) * ( 1 - 1 / ( 4 * n ) + 1 / ( 21 * n * n ) );
+
+		// update after a quarter of a generation, so that free threads can be used with little delay
+		batch_size_ = std::max( 1, lambda_ / 4 );
+	}
+
+	SteadyStateCma::vec_t SteadyStateCma::Sample()
+	{
+		const auto& B = decomposition_.B;
+		const auto& D = decomposition_.D;
+		vec_t z( n_ ), x( mean_ );
+		for ( auto& zi : z )
+			zi = norm_( rng_ );
+		for ( size_t i = 0; i < n_; ++i )
+			for ( size_t j = 0; j < n_; ++j )
+				x[ i ] += sigma_ * B[ i * n_ + j ] * D[ j ] * z[ j ];
+		return x;
+	}
+
+	bool SteadyStateCma::Tell( const vec_t& x, double fitness )
+	{
+		SCONE_ASSERT( x.size() == n_ );
+		pending_.push_back( Result{ x, fitness } );
+		window_.push_back( Result{ x, fitness } );
+		if ( window_.size() > size_t( lambda_ ) )
+			window_.pop_front();
+
+		if ( pending_.size() < batch_size_ )
+			return false;
+
+		UpdateBatch();
+		generation_evaluations_ += pending_.size();
+		pending_.clear();
+
+		if ( generation_evaluations_ < size_t( lambda_ ) )
+			return false;
+
+		UpdateGeneration();
+		generation_evaluations_ = 0;
+		return true;
+	}
+
+	void SteadyStateCma::SetCovariance( const vec_t& c )
+	{
+		SCONE_ASSERT( c.size() == n_ * n_ );
+		C_ = c;
+		std::fill( pc_.begin(), pc_.end(), 0.0 );
+		std::fill( ps_.begin(), ps_.end(), 0.0 );
+		decomposition_ = Decompose( n_, C_ );
+		eigen_generation_ = generation_;
+	}
+
+	SteadyStateCma::vec_t SteadyStateCma::GetPendingDecomposition()
+	{
+		// update B and D lazily, as in regular CMA-ES
+		if ( decomposition_pending_ || double( generation_ - eigen_generation_ ) * ( c1_ + cmu_ ) * n_ * 10 < 1.0 )
+			return vec_t();
+		decomposition_pending_ = true;
+		eigen_generation_ = generation_;
+		return C_;
+	}
+
+	SteadyStateCma::Decomposition SteadyStateCma::Decompose( size_t dim, const vec_t& covariance )
+	{
+		Decomposition d;
+		vec_t eigenvalues;
+		symmetric_eigen( dim, covariance, eigenvalues, d.B );
+		d.D.resize( dim );
+		for ( size_t i = 0; i < dim; ++i )
+			d.D[ i ] = std::sqrt( std::max( eigenvalues[ i ], 1e-20 ) );
+		return d;
+	}
+
+	void SteadyStateCma::SetDecomposition( Decomposition d )
+	{
+		SCONE_ASSERT( d.B.size() == n_ * n_ && d.D.size() == n_ );
+		decomposition_ = std::move( d );
+		decomposition_pending_ = false;
+	}
+
+	void SteadyStateCma::UpdateDecomposition()
+	{
+		if ( auto c = GetPendingDecomposition(); !c.empty() )
+			SetDecomposition( Decompose( n_, c ) );
+	}
+
+	SteadyStateCma::vec_t SteadyStateCma::std() const
+	{
+		vec_t s( n_ );
+		for ( size_t i = 0; i < n_; ++i )
+			s[ i ] = sigma_ * std::sqrt( C_[ i * n_ + i ] );
+		return s;
+	}
+
+	void SteadyStateCma::UpdateBatch()
+	{
+		// steps relative to the current mean, clipped in Mahalanobis norm for samples of older distributions
+		const auto& B = decomposition_.B;
+		const auto& D = decomposition_.D;
+		const double max_norm = std::sqrt( double( n_ ) ) + 2.0 * n_ / ( n_ + 2.0 );
+		std::vector< vec_t > steps;
+		std::vector< double > step_weights;
+		for ( auto& r : pending_ )
+		{
+			auto rank = std::count_if( window_.begin(), window_.end(), [&]( const Result& o ) { return IsBetter( o.fitness, r.fitness ); } );
+			if ( rank >= mu_ )
+				continue;
+
+			vec_t y( n_ ), by( n_, 0.0 );
+			for ( size_t i = 0; i < n_; ++i )
+				y[ i ] = ( r.x[ i ] - mean_[ i ] ) / sigma_;
+			for ( size_t j = 0; j < n_; ++j )
+				for ( size_t i = 0; i < n_; ++i )
+					by[ j ] += B[ i * n_ + j ] * y[ i ] / D[ j ];
+			auto norm = std::sqrt( std::inner_product( by.begin(), by.end(), by.begin(), 0.0 ) );
+			if ( norm > max_norm )
+				for ( auto& yi : y )
+					yi *= max_norm / norm;
+
+			steps.push_back( std::move( y ) );
+			step_weights.push_back( weights_[ rank ] );
+		}
+
+		// mean and rank-mu update, in proportion to the weights in this batch
+		auto total_weight = std::accumulate( step_weights.begin(), step_weights.end(), 0.0 );
+		for ( size_t k = 0; k < steps.size(); ++k )
+			for ( size_t i = 0; i < n_; ++i )
+				mean_[ i ] += sigma_ * step_weights[ k ] * steps[ k ][ i ];
+
+		for ( size_t i = 0; i < n_; ++i )
+		{
+			for ( size_t j = 0; j <= i; ++j )
+			{
+				double rank_mu = 0.0;
+				for ( size_t k = 0; k < steps.size(); ++k )
+					rank_mu += step_weights[ k ] * steps[ k ][ i ] * steps[ k ][ j ];
+				C_[ i * n_ + j ] = C_[ j * n_ + i ] = ( 1 - cmu_ * total_weight ) * C_[ i * n_ + j ] + cmu_ * rank_mu;
+			}
+		}
+	}
+
+	void SteadyStateCma::UpdateGeneration()
+	{
+		// mean shift of the past generation, in units of sigma
+		const auto& B = decomposition_.B;
+		const auto& D = decomposition_.D;
+		vec_t delta( n_ ), c_inv_delta( n_, 0.0 ), tmp( n_, 0.0 );
+		for ( size_t i = 0; i < n_; ++i )
+			delta[ i ] = ( mean_[ i ] - generation_mean_[ i ] ) / sigma_;
+		for ( size_t j = 0; j < n_; ++j )
+			for ( size_t i = 0; i < n_; ++i )
+				tmp[ j ] += B[ i * n_ + j ] * delta[ i ] / D[ j ];
+		for ( size_t i = 0; i < n_; ++i )
+			for ( size_t j = 0; j < n_; ++j )
+				c_inv_delta[ i ] += B[ i * n_ + j ] * tmp[ j ];
+
+		// evolution paths
+		auto cs_factor = std::sqrt( cs_ * ( 2 - cs_ ) * mu_eff_ );
+		for ( size_t i = 0; i < n_; ++i )
+			ps_[ i ] = ( 1 - cs_ ) * ps_[ i ] + cs_factor * c_inv_delta[ i ];
+		auto ps_norm = std::sqrt( std::inner_product( ps_.begin(), ps_.end(), ps_.begin(), 0.0 ) );
+		bool hsig = ps_norm / std::sqrt( 1 - std::pow( 1 - cs_, 2.0 * ( generation_ + 1 ) ) ) / chi_n_ < 1.4 + 2 / ( n_ + 1.0 );
+		auto cc_factor = std::sqrt( cc_ * ( 2 - cc_ ) * mu_eff_ );
+		for ( size_t i = 0; i < n_; ++i )
+			pc_[ i ] = ( 1 - cc_ ) * pc_[ i ] + ( hsig ? cc_factor * delta[ i ] : 0.0 );
+
+		// rank-one update
+		auto decay = c1_ * ( hsig ? 0.0 : cc_ * ( 2 - cc_ ) );
+		for ( size_t i = 0; i < n_; ++i )
+			for ( size_t j = 0; j <= i; ++j )
+				C_[ i * n_ + j ] = C_[ j * n_ + i ] = ( 1 - c1_ + decay ) * C_[ i * n_ + j ] + c1_ * pc_[ i ] * pc_[ j ];
+
+		// step size
+		sigma_ *= std::exp( ( cs_ / ds_ ) * ( ps_norm / chi_n_ - 1 ) );
+
+		++generation_;
+		generation_mean_ = mean_;
+	}
+}
@@ -0,0 +1,95 @@
+/*
+** SteadyStateCma.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace scone
+{
+	/// Steady-state CMA-ES, which updates the distribution as soon as evaluations complete.
+	/** Samples are drawn one at a time and can be returned in any order. Every batch of completed samples
+	is ranked against the last lambda results, and updates the mean and rank-mu covariance proportional
+	to its recombination weights. Evolution paths and step size are updated once every lambda results,
+	similar to a regular CMA-ES generation. All coordinates are normalized; callers scale them.
+	The class is not thread-safe, but the eigen decomposition can be computed without holding a lock,
+	see GetPendingDecomposition(). */
+	class SCONE_API SteadyStateCma
+	{
+	public:
+		using vec_t = std::vector< double >;
+
+		SteadyStateCma( size_t dim, int lambda, double sigma, long random_seed, bool minimize );
+
+		/// sample a new candidate from the current distribution
+		vec_t Sample();
+
+		/// add the fitness of a (possibly outdated) sample; returns true if a generation was completed
+		/// the eigen decomposition used by Sample() is not updated, see GetPendingDecomposition()
+		bool Tell( const vec_t& x, double fitness );
+
+		/// eigenvectors (column-major) and sqrt of eigenvalues of the covariance
+		struct Decomposition { vec_t B, D; };
+
+		/// copy of the covariance if the eigen decomposition is outdated and not being computed, or empty otherwise
+		/// compute it with Decompose(), which can run without locking, and apply it with SetDecomposition();
+		/// Sample() uses the previous decomposition meanwhile
+		vec_t GetPendingDecomposition();
+		static Decomposition Decompose( size_t dim, const vec_t& covariance );
+		void SetDecomposition( Decomposition d );
+
+		/// update the eigen decomposition if it is outdated, for single-threaded use
+		void UpdateDecomposition();
+
+		/// set the covariance matrix (row-major, excluding sigma), e.g. from a previous optimization
+		void SetCovariance( const vec_t& c );
+
+		size_t dim() const { return n_; }
+		int lambda() const { return lambda_; }
+		int mu() const { return mu_; }
+		double sigma() const { return sigma_; }
+		size_t generation() const { return generation_; }
+		const vec_t& mean() const { return mean_; }
+		vec_t std() const;
+		const vec_t& covariance() const { return C_; }
+
+	private:
+		void UpdateBatch();
+		void UpdateGeneration();
+		bool IsBetter( double a, double b ) const { return minimize_ ? a < b : a > b; }
+
+		size_t n_;
+		int lambda_;
+		int mu_;
+		bool minimize_;
+		size_t batch_size_;
+		vec_t weights_;
+		double mu_eff_, cs_, ds_, cc_, c1_, cmu_, chi_n_;
+
+		double sigma_;
+		vec_t mean_, generation_mean_;
+		vec_t C_;
+		Decomposition decomposition_;
+		bool decomposition_pending_;
+		vec_t pc_, ps_;
+		size_t generation_;
+		size_t generation_evaluations_;
+		size_t eigen_generation_;
+
+		struct Result { vec_t x; double fitness; };
+		std::deque< Result > window_;
+		std::vector< Result > pending_;
+		std::mt19937_64 rng_;
+		std::normal_distribution< double > norm_;
+	};
+}
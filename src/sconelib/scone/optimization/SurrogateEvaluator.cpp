@@ -0,0 +1,281 @@
+/*
+** SurrogateEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "SurrogateEvaluator.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/memory_tools.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace scone
+{
+	// solve a x = b for symmetric positive definite a (n x n, row-major) using Cholesky decomposition
+	static bool cholesky_solve( size_t n, std::vector< double > a, std::vector< double >& x )
+	{
+		for ( size_t j = 0; j < n; ++j )
+		{
+			double d = a[ j * n + j ];
+			for ( size_t k = 0; k < j; ++k )
+				d -= a[ j * n + k ] * a[ j * n + k ];
+			if ( d <= 0 )
+				return false;
+			a[ j * n + j ] = std::sqrt( d );
+			for ( size_t i = j + 1; i < n; ++i )
+			{
+				double s = a[ i * n + j ];
+				for ( size_t k = 0; k < j; ++k )
+					s -= a[ i * n + k ] * a[ j * n + k ];
+				a[ i * n + j ] = s / a[ j * n + j ];
+			}
+		}
+		for ( size_t i = 0; i < n; ++i )
+		{
+			for ( size_t k = 0; k < i; ++k )
+				x[ i ] -= a[ i * n + k ] * x[ k ];
+			x[ i ] /= a[ i * n + i ];
+		}
+		for ( size_t i = n; i-- > 0; )
+		{
+			for ( size_t k = i + 1; k < n; ++k )
+				x[ i ] -= a[ k * n + i ] * x[ k ];
+			x[ i ] /= a[ i * n + i ];
+		}
+		return true;
+	}
+
+	static std::vector< double > ranks( const std::vector< double >& v )
+	{
+		std::vector< index_t > idx( v.size() );
+		std::iota( idx.begin(), idx.end(), index_t( 0 ) );
+		std::sort( idx.begin(), idx.end(), [&]( index_t a, index_t b ) { return v[ a ] < v[ b ]; } );
+		std::vector< double > r( v.size() );
+		for ( index_t i = 0; i < idx.size(); ++i )
+			r[ idx[ i ] ] = double( i );
+		return r;
+	}
+
+	// Spearman rank correlation
+	static double rank_correlation( const std::vector< double >& a, const std::vector< double >& b )
+	{
+		auto ra = ranks( a ), rb = ranks( b );
+		auto n = double( a.size() ), mean = ( n - 1 ) / 2;
+		double sab = 0.0, saa = 0.0, sbb = 0.0;
+		for ( index_t i = 0; i < a.size(); ++i )
+		{
+			sab += ( ra[ i ] - mean ) * ( rb[ i ] - mean );
+			saa += ( ra[ i ] - mean ) * ( ra[ i ] - mean );
+			sbb += ( rb[ i ] - mean ) * ( rb[ i ] - mean );
+		}
+		return saa > 0 && sbb > 0 ? sab / std::sqrt( saa * sbb ) : 0.0;
+	}
+
+	SurrogateEvaluator::SurrogateEvaluator( spot::evaluator& target, long random_seed ) :
+		target_( target ),
+		rng_( random_seed )
+	{}
+
+	std::vector< result< fitness_t > > SurrogateEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		std::unique_lock lock( mutex_ );
+		auto it = objectives_.find( &o );
+		if ( it == objectives_.end() )
+		{
+			lock.unlock();
+			return target_.evaluate( o, point_vec, st, prio );
+		}
+
+		auto& data = it->second;
+		const auto& opt = data.options;
+		const auto n = point_vec.size();
+		const bool minimize = o.info().minimize();
+		auto n_eval = std::max( { size_t( opt.fraction * n ), std::min( opt.min_evaluations, n ), std::min( size_t( 1 ), n ) } );
+
+		// rank candidates with the surrogate, once there are enough evaluations to fit it
+		std::vector< double > predicted;
+		if ( n_eval < n && data.archive.size() >= n && !data.skip_next )
+			predicted = Predict( data.archive, point_vec );
+		data.skip_next = false;
+
+		std::vector< index_t > order( n ), selected;
+		std::iota( order.begin(), order.end(), index_t( 0 ) );
+		if ( predicted.empty() )
+			selected = order;
+		else
+		{
+			std::sort( order.begin(), order.end(), [&]( index_t a, index_t b ) { return minimize ? predicted[ a ] < predicted[ b ] : predicted[ a ] > predicted[ b ]; } );
+			auto n_random = std::min( n_eval, size_t( std::round( opt.random_fraction * n ) ) );
+			selected.assign( order.begin(), order.begin() + ( n_eval - n_random ) );
+			std::vector< index_t > rest( order.begin() + ( n_eval - n_random ), order.end() );
+			std::shuffle( rest.begin(), rest.end(), rng_ );
+			selected.insert( selected.end(), rest.begin(), rest.begin() + n_random );
+		}
+		lock.unlock();
+
+		spot::search_point_vec selected_points;
+		selected_points.reserve( selected.size() );
+		for ( auto i : selected )
+			selected_points.push_back( point_vec[ i ] );
+		auto selected_results = target_.evaluate( o, selected_points, st, prio );
+
+		lock.lock();
+		std::vector< result< fitness_t > > results( n, xo::error_message( "Evaluation canceled" ) );
+		std::vector< bool > evaluated( n, false );
+		std::vector< double > pred_values, eval_values;
+		auto worst = o.info().worst_fitness();
+		bool has_worst = false;
+		for ( index_t k = 0; k < selected.size() && k < selected_results.size(); ++k )
+		{
+			auto i = selected[ k ];
+			evaluated[ i ] = true;
+			if ( selected_results[ k ] )
+			{
+				auto f = selected_results[ k ].value();
+				data.archive.push_back( Sample{ point_vec[ i ].values(), f } );
+				if ( !predicted.empty() )
+				{
+					pred_values.push_back( predicted[ i ] );
+					eval_values.push_back( f );
+				}
+				if ( !has_worst || ( minimize ? f > worst : f < worst ) )
+					worst = f;
+				has_worst = true;
+			}
+			results[ i ] = std::move( selected_results[ k ] );
+		}
+		while ( data.archive.size() > opt.archive_size )
+			data.archive.pop_front();
+
+		data.last_screened = n - selected.size();
+		data.last_evaluated = evaluated;
+		data.last_correlation = std::numeric_limits< double >::quiet_NaN();
+		if ( !predicted.empty() && !st.stop_requested() )
+		{
+			// disable screening for the next batch if the surrogate does not predict the ranking
+			if ( pred_values.size() >= 3 )
+			{
+				data.last_correlation = rank_correlation( pred_values, eval_values );
+				data.skip_next = data.last_correlation < opt.min_correlation;
+			}
+
+			// candidates that were screened out are ranked below all evaluated candidates
+			auto step = std::max( 1e-6 * std::abs( worst ), 1e-9 );
+			int rank = 0;
+			for ( auto i : order )
+				if ( !evaluated[ i ] )
+					results[ i ] = worst + ( minimize ? step : -step ) * ++rank;
+		}
+
+		return results;
+	}
+
+	void SurrogateEvaluator::SetOptions( const spot::objective& o, const Options& opt )
+	{
+		SCONE_ERROR_IF( opt.fraction <= 0 || opt.fraction > 1, "Surrogate fraction must be between 0 and 1" );
+		SCONE_ERROR_IF( opt.random_fraction < 0 || opt.random_fraction > opt.fraction, "Surrogate random fraction must be between 0 and fraction" );
+		std::scoped_lock lock( mutex_ );
+		objectives_[ &o ].options = opt;
+	}
+
+	double SurrogateEvaluator::GetLastCorrelation( const spot::objective& o ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto it = objectives_.find( &o );
+		return it != objectives_.end() ? it->second.last_correlation : std::numeric_limits< double >::quiet_NaN();
+	}
+
+	size_t SurrogateEvaluator::GetLastScreenedCount( const spot::objective& o ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto it = objectives_.find( &o );
+		return it != objectives_.end() ? it->second.last_screened : 0;
+	}
+
+	std::vector< bool > SurrogateEvaluator::GetLastEvaluated( const spot::objective& o ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto it = objectives_.find( &o );
+		return it != objectives_.end() ? it->second.last_evaluated : std::vector< bool >();
+	}
+
+	void SurrogateEvaluator::RemoveObjective( const spot::objective& o )
+	{
+		// objectives are identified by address, which can be reused by a new objective
+		std::scoped_lock lock( mutex_ );
+		objectives_.erase( &o );
+	}
+
+	SurrogateEvaluator& SurrogateEvaluator::GetInstance( spot::evaluator& target )
+	{
+		static std::mutex instance_mutex;
+		static std::map< spot::evaluator*, u_ptr< SurrogateEvaluator > > instances;
+		std::scoped_lock lock( instance_mutex );
+		auto& inst = instances[ &target ];
+		if ( !inst )
+			inst = std::make_unique< SurrogateEvaluator >( target );
+		return *inst;
+	}
+
+	std::vector< double > SurrogateEvaluator::Predict( const std::deque< Sample >& archive, const spot::search_point_vec& point_vec ) const
+	{
+		const auto dim = point_vec.front().values().size();
+		for ( auto& p : point_vec )
+			if ( p.values().size() != dim )
+				return {};
+
+		// samples of a different dimension can't be compared
+		std::vector< const Sample* > samples;
+		for ( auto& s : archive )
+			if ( s.values.size() == dim )
+				samples.push_back( &s );
+		const auto n = samples.size();
+		if ( n < point_vec.size() )
+			return {};
+
+		// coordinates are scaled by the std of the candidates, which follows the step size of the optimizer
+		std::vector< double > mean( dim, 0.0 ), scale( dim, 0.0 );
+		for ( auto& p : point_vec )
+			for ( index_t i = 0; i < dim; ++i )
+				mean[ i ] += p.values()[ i ] / point_vec.size();
+		for ( auto& p : point_vec )
+			for ( index_t i = 0; i < dim; ++i )
+				scale[ i ] += ( p.values()[ i ] - mean[ i ] ) * ( p.values()[ i ] - mean[ i ] ) / point_vec.size();
+		for ( auto& s : scale )
+			s = s > 0 ? 1.0 / std::sqrt( s ) : 1.0;
+
+		// gaussian kernel with a width that matches the typical distance between candidates
+		auto kernel = [&]( const std::vector< double >& a, const std::vector< double >& b ) {
+			double d2 = 0.0;
+			for ( index_t i = 0; i < dim; ++i )
+				d2 += ( a[ i ] - b[ i ] ) * ( a[ i ] - b[ i ] ) * scale[ i ] * scale[ i ];
+			return std::exp( -d2 / ( 2.0 * dim ) );
+		};
+
+		double f_mean = 0.0;
+		for ( auto* s : samples )
+			f_mean += s->fitness / n;
+
+		std::vector< double > k( n * n ), w( n );
+		for ( index_t i = 0; i < n; ++i )
+		{
+			w[ i ] = samples[ i ]->fitness - f_mean;
+			for ( index_t j = 0; j <= i; ++j )
+				k[ i * n + j ] = k[ j * n + i ] = kernel( samples[ i ]->values, samples[ j ]->values );
+			k[ i * n + i ] += 1e-6; // regularization
+		}
+		if ( !cholesky_solve( n, std::move( k ), w ) )
+			return {};
+
+		std::vector< double > predicted( point_vec.size(), f_mean );
+		for ( index_t p = 0; p < point_vec.size(); ++p )
+			for ( index_t i = 0; i < n; ++i )
+				predicted[ p ] += w[ i ] * kernel( point_vec[ p ].values(), samples[ i ]->values );
+		return predicted;
+	}
+}
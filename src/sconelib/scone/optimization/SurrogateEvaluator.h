@@ -0,0 +1,85 @@
+/*
+** SurrogateEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "spot/evaluator.h"
+#include "spot/objective.h"
+
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+
+namespace scone
+{
+	/// Evaluator that pre-screens candidates with a surrogate model, and only evaluates the most promising ones.
+	/** The surrogate is a Gaussian radial basis function model, fitted to the most recent evaluations of each objective,
+	in coordinates scaled by the spread of the current candidates. Candidates that are not evaluated receive a
+	placeholder fitness that is worse than that of all evaluated candidates, in the order predicted by the surrogate,
+	so that the optimizer ranks them last; GetLastEvaluated() tells which candidates were evaluated, so that
+	placeholders can be excluded from statistics.
+	A fraction of the candidates is always selected at random, and screening is skipped for one batch when the
+	rank correlation between prediction and evaluation is too low. Objectives without options are evaluated as usual. */
+	class SCONE_API SurrogateEvaluator : public spot::evaluator
+	{
+	public:
+		struct Options {
+			double fraction = 1.0; // fraction of candidates that is evaluated, rounded down
+			double random_fraction = 0.1; // fraction of candidates that is selected at random
+			double min_correlation = 0.3; // minimum rank correlation required for screening
+			size_t min_evaluations = 0; // minimum number of evaluations per batch
+			size_t archive_size = 100; // number of evaluations used to fit the surrogate
+		};
+
+		SurrogateEvaluator( spot::evaluator& target, long random_seed = 123 );
+		virtual ~SurrogateEvaluator() {}
+
+		virtual std::vector< result< fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+		/// Enable pre-screening for an objective.
+		void SetOptions( const spot::objective& o, const Options& opt );
+
+		/// Rank correlation between surrogate and evaluated fitness of the last batch, or NaN if not available.
+		double GetLastCorrelation( const spot::objective& o ) const;
+
+		/// Number of candidates that were not evaluated in the last batch.
+		size_t GetLastScreenedCount( const spot::objective& o ) const;
+
+		/// For each candidate of the last batch, true if it was evaluated, false if it has a placeholder fitness.
+		std::vector< bool > GetLastEvaluated( const spot::objective& o ) const;
+
+		/// Remove the options and archive of an objective, must be called before the objective is destroyed.
+		void RemoveObjective( const spot::objective& o );
+
+		spot::evaluator& GetTarget() { return target_; }
+
+		/// Get the instance of SurrogateEvaluator for a target evaluator.
+		static SurrogateEvaluator& GetInstance( spot::evaluator& target );
+
+	private:
+		struct Sample { std::vector< double > values; double fitness; };
+		struct ObjectiveData {
+			Options options;
+			std::deque< Sample > archive;
+			double last_correlation = std::numeric_limits< double >::quiet_NaN();
+			size_t last_screened = 0;
+			std::vector< bool > last_evaluated;
+			bool skip_next = false;
+		};
+		std::vector< double > Predict( const std::deque< Sample >& archive, const spot::search_point_vec& point_vec ) const;
+
+		spot::evaluator& target_;
+		std::map< const spot::objective*, ObjectiveData > objectives_;
+		std::mt19937_64 rng_;
+		mutable std::mutex mutex_;
+	};
+}
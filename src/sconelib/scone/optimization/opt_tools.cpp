@@ -16,8 +16,19 @@
 #include "xo/container/prop_node_tools.h"
 #include "xo/filesystem/filesystem.h"
 #include "xo/serialization/char_stream.h"
+#include "xo/serialization/prop_node_serializer_zml.h"
 #include "xo/utility/irange.h"
 #include "xo/container/container_algorithms.h"
+#include "xo/string/string_tools.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <thread>
 
 using xo::timer;
 
@@ -67,6 +78,11 @@ namespace scone
 		statistics.set( "result", mo->GetReport( *model ) );
 		statistics.set( "simulation time", model->GetTime() );
 		statistics.set( "performance (x real-time)", model->GetTime() / duration );
+		if ( auto* pc = model->GetPerfCounters() )
+		{
+			pc->LogReport( model->GetTime() );
+			statistics.add_child( "perf_counters", pc->GetReport( model->GetTime() ) );
+		}
 
 		return statistics;
 	}
@@ -78,4 +94,185 @@ namespace scone
 		auto folder = file.parent_path();
 		return xo::find_file( { path( file ).replace_extension( "scone" ), folder / "config.scone", folder / "config.xml" } );
 	}
+
+	// returns the generation number at the start of a .par filename, or -1
+	static int GetParFileGeneration( const std::filesystem::path& file )
+	{
+		auto name = file.filename().string();
+		auto digits = std::find_if_not( name.begin(), name.end(), []( char c ) { return std::isdigit( static_cast<unsigned char>( c ) ); } ) - name.begin();
+		return digits > 0 ? std::stoi( name.substr( 0, digits ) ) : -1;
+	}
+
+	std::vector< path > FindParFiles( const String& files )
+	{
+		namespace fs = std::filesystem;
+		std::vector< path > par_files;
+		fs::path p( files );
+
+		if ( fs::is_directory( p ) )
+		{
+			// last .par file of each folder
+			std::map< fs::path, fs::path > last_par;
+			for ( auto& entry : fs::recursive_directory_iterator( p ) )
+			{
+				if ( entry.is_regular_file() && entry.path().extension() == ".par" )
+				{
+					auto& last = last_par[ entry.path().parent_path() ];
+					if ( last.empty() || GetParFileGeneration( entry.path() ) > GetParFileGeneration( last ) )
+						last = entry.path();
+				}
+			}
+			for ( auto& [folder, file] : last_par )
+				par_files.emplace_back( file.string() );
+		}
+		else if ( files.find_first_of( "*?" ) != String::npos )
+		{
+			// wildcard pattern, matched against the path relative to the first folder without wildcards
+			auto base = p;
+			while ( base.has_parent_path() && base.string().find_first_of( "*?" ) != String::npos )
+				base = base.parent_path();
+			if ( base.string().find_first_of( "*?" ) != String::npos )
+				base = ".";
+			auto pattern = std::regex_replace( p.generic_string(), std::regex( R"([.^$|()\[\]{}+\\])" ), "\\$&" );
+			pattern = std::regex_replace( std::regex_replace( pattern, std::regex( R"(\*)" ), "[^/]*" ), std::regex( R"(\?)" ), "[^/]" );
+			std::regex re( pattern );
+			for ( auto& entry : fs::recursive_directory_iterator( base ) )
+				if ( entry.is_regular_file() && std::regex_match( entry.path().generic_string(), re ) )
+					par_files.emplace_back( entry.path().string() );
+			std::sort( par_files.begin(), par_files.end(), []( const path& a, const path& b ) { return a.str() < b.str(); } );
+		}
+		else if ( p.extension() == ".par" )
+			par_files.emplace_back( files );
+		else
+		{
+			// list file, one .par file per line, relative to the list file
+			std::ifstream str( files );
+			SCONE_ERROR_IF( !str.good(), "Could not open " + files );
+			for ( String line; std::getline( str, line ); )
+			{
+				line = xo::trim_str( line );
+				if ( !line.empty() && line[ 0 ] != '#' )
+					par_files.emplace_back( fs::path( line ).is_absolute() ? line : ( p.parent_path() / line ).string() );
+			}
+		}
+
+		SCONE_ERROR_IF( par_files.empty(), "Could not find any .par files in " + files );
+		return par_files;
+	}
+
+	std::vector< PropNode > EvaluateParFiles( const std::vector< path >& par_files, const std::function< PropNode( const path& ) >& load_scenario, size_t num_threads )
+	{
+		// create one optimizer per scenario; this is done sequentially, since it can use non-thread-safe resources
+		// par files are grouped by the content of their scenario, because each result folder has its own copy
+		struct Group { PropNode scenario_pn; OptimizerUP optimizer; ModelObjective* objective = nullptr; String error; };
+		std::map< String, Group > groups;
+		std::vector< Group* > par_groups;
+		for ( auto& par_file : par_files )
+		{
+			auto scenario_file = FindScenario( par_file );
+			String scenario_key;
+			PropNode scenario_pn;
+			try
+			{
+				scenario_pn = load_scenario( scenario_file );
+				PropNode pn = scenario_pn;
+				xo::error_code ec;
+				std::ostringstream str;
+				str << xo::prop_node_serializer_zml( pn, &ec );
+				SCONE_ERROR_IF( !ec.good(), "Could not serialize scenario: " + ec.message() );
+				scenario_key = str.str();
+			}
+			catch ( std::exception& e )
+			{
+				// unique key, so that the error is only reported for this file
+				scenario_key = "error:" + par_file.str();
+				groups[ scenario_key ].error = e.what();
+			}
+
+			auto& g = groups[ scenario_key ];
+			if ( !g.optimizer && g.error.empty() )
+			{
+				try
+				{
+					g.scenario_pn = std::move( scenario_pn );
+					g.optimizer = CreateOptimizer( g.scenario_pn, scenario_file.parent_path() );
+					g.objective = dynamic_cast<ModelObjective*>( &g.optimizer->GetObjective() );
+					SCONE_ERROR_IF( !g.objective, "Scenario does not contain a ModelObjective" );
+					LogUnusedProperties( g.scenario_pn );
+				}
+				catch ( std::exception& e ) { g.error = e.what(); }
+			}
+			par_groups.push_back( &g );
+		}
+		log::info( "Evaluating ", par_files.size(), " files from ", groups.size(), " scenarios using ", num_threads, " threads" );
+
+		std::vector< PropNode > results( par_files.size() );
+		std::atomic< size_t > next_index = 0;
+		auto evaluate_files = [&]() {
+			for ( index_t idx = next_index++; idx < par_files.size(); idx = next_index++ )
+			{
+				auto& pn = results[ idx ];
+				auto& g = *par_groups[ idx ];
+				pn.set( "file", par_files[ idx ] );
+				try
+				{
+					SCONE_ERROR_IF( !g.error.empty(), g.error );
+					auto model = g.objective->CreateModelFromParFile( par_files[ idx ] );
+					timer tmr;
+					auto fitness = g.objective->EvaluateModel( *model, xo::stop_token() );
+					auto duration = tmr().seconds();
+					SCONE_ERROR_IF( !fitness, "Evaluation failed: " + fitness.error().message() );
+					pn.set( "fitness", fitness.value() );
+					pn.set( "simulation_time", model->GetTime() );
+					pn.set( "x_realtime", model->GetTime() / duration );
+					pn.add_child( "report", g.objective->GetReport( *model ) );
+				}
+				catch ( std::exception& e )
+				{
+					pn.set( "error", e.what() );
+					log::error( par_files[ idx ].str(), ": ", e.what() );
+				}
+			}
+		};
+
+		std::vector< std::thread > threads;
+		for ( size_t i = 1; i < std::max< size_t >( num_threads, 1 ); ++i )
+			threads.emplace_back( evaluate_files );
+		evaluate_files();
+		for ( auto& t : threads )
+			t.join();
+
+		return results;
+	}
+
+	void WriteEvaluationSummary( const std::vector< PropNode >& results, std::ostream& str )
+	{
+		// columns for the top-level measures in the reports, in order of appearance
+		std::vector< String > report_keys;
+		for ( auto& pn : results )
+			if ( auto* report = pn.try_get_child( "report" ) )
+				for ( const auto& [key, child] : *report )
+					if ( std::find( report_keys.begin(), report_keys.end(), key ) == report_keys.end() )
+						report_keys.push_back( key );
+
+		str << "file\tfitness\tsimulation_time\tx_realtime";
+		for ( auto& key : report_keys )
+			str << "\t" << key;
+		str << "\terror\n";
+
+		for ( auto& pn : results )
+		{
+			str << pn.get< String >( "file" ) << "\t" << pn.get< String >( "fitness", "" )
+				<< "\t" << pn.get< String >( "simulation_time", "" ) << "\t" << pn.get< String >( "x_realtime", "" );
+			auto* report = pn.try_get_child( "report" );
+			for ( auto& key : report_keys )
+			{
+				// report values start with the weighted result, followed by details
+				auto* child = report ? report->try_get_child( key ) : nullptr;
+				auto value = child ? child->raw_value() : String();
+				str << "\t" << value.substr( 0, value.find( '\t' ) );
+			}
+			str << "\t" << pn.get< String >( "error", "" ) << "\n";
+		}
+	}
 }
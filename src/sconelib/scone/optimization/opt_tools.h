@@ -15,6 +15,8 @@
 #include "scone/core/Log.h"
 #include "scone/core/types.h"
 #include "scone/optimization/Optimizer.h"
+#include <functional>
+#include <iosfwd>
 
 namespace scone
 {
@@ -26,4 +28,16 @@ namespace scone
 
 	/// Returns .scone file for a given .par file, or returns argument if already .scone.
 	SCONE_API path FindScenario( const path& scenario_or_par_file );
+
+	/// Returns .par files from a single .par file, a list file with one .par file per line, a wildcard pattern
+	/// (e.g. results/*/0*.par), or a directory. For directories, the last .par file of each sub-folder is used.
+	SCONE_API std::vector< path > FindParFiles( const String& files );
+
+	/// Evaluates .par files in parallel, without writing results. The scenario and objective are created once
+	/// for all .par files with identical scenario contents. Returns a PropNode with statistics for each file.
+	SCONE_API std::vector< PropNode > EvaluateParFiles( const std::vector< path >& par_files,
+		const std::function< PropNode( const path& ) >& load_scenario, size_t num_threads );
+
+	/// Write the statistics from EvaluateParFiles as a tab-separated table.
+	SCONE_API void WriteEvaluationSummary( const std::vector< PropNode >& results, std::ostream& str );
 }
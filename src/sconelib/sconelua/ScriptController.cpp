@@ -22,7 +22,8 @@ namespace scone
 		Controller( pn, par, model, loc ),
 		script_file( FindFile( pn.get<path>( "script_file" ) ) ),
 		INIT_MEMBER( pn, external_files, std::vector<path>() ),
-		script_( new lua_script( script_file, pn, par, model ) )
+		script_( new lua_script( script_file, pn, par, model ) ),
+		lua_model_( new LuaModel( model ) )
 	{
 		// optional functions
 		if ( auto f = script_->try_find_function( "init" ) )
@@ -36,9 +37,8 @@ namespace scone
 		if ( init_ )
 		{
 			LuaParams lp( par );
-			LuaModel lm( model );
 			auto side = static_cast<double>( loc.GetSide() );
-			init_( &lm, &lp, side );
+			init_( lua_model_.get(), &lp, side );
 		}
 
 		// add lua files as external resources
@@ -63,8 +63,7 @@ namespace scone
 	{
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
-		LuaModel lm( model );
-		return update_( &lm );
+		return update_( lua_model_.get() );
 	}
 
 	String ScriptController::GetClassSignature() const
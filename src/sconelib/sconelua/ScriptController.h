@@ -50,6 +50,7 @@ namespace scone
 		virtual String GetClassSignature() const override;
 
 		u_ptr< class lua_script > script_;
+		u_ptr< struct LuaModel > lua_model_;
 		std::function<void( struct LuaModel*, struct LuaParams*, double )> init_;
 		std::function<bool( struct LuaModel* )> update_;
 		std::function<double( struct LuaFrame* )> store_;
@@ -11,7 +11,8 @@ namespace scone
 		Measure( pn, par, model, loc ),
 		script_file( FindFile( pn.get<path>( "script_file" ) ) ),
 		INIT_MEMBER( pn, external_files, std::vector<path>() ),
-		script_( new lua_script( script_file, pn, par, const_cast<Model&>( model ) ) ) // const_cast is needed because Lua doesn't care about const
+		script_( new lua_script( script_file, pn, par, const_cast<Model&>( model ) ) ), // const_cast is needed because Lua doesn't care about const
+		lua_model_( new LuaModel( const_cast<Model&>( model ) ) )
 	{
 		// optional functions
 		if ( auto f = script_->try_find_function( "init" ) )
@@ -25,10 +26,7 @@ namespace scone
 		result_ = script_->find_function( "result" );
 
 		if ( init_ )
-		{
-			LuaModel lm( const_cast<Model&>( model ) );
-			init_( &lm );
-		}
+			init_( lua_model_.get() );
 
 		// add lua files as external resources
 		model.AddExternalResource( script_->script_file_ );
@@ -36,10 +34,12 @@ namespace scone
 			model.AddExternalResource( FindFile( f ) );
 	}
 
+	ScriptMeasure::~ScriptMeasure()
+	{}
+
 	double ScriptMeasure::ComputeResult( const Model& model )
 	{
-		LuaModel lm( const_cast<Model&>( model ) );
-		return result_( &lm );
+		return result_( lua_model_.get() );
 	}
 
 	bool ScriptMeasure::UpdateMeasure( const Model& model, double timestamp )
@@ -47,10 +47,7 @@ namespace scone
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
 		if ( update_ )
-		{
-			LuaModel lm( const_cast<Model&>( model ) );
-			return update_( &lm );
-		}
+			return update_( lua_model_.get() );
 		else return false;
 	}
 
@@ -41,6 +41,7 @@ namespace scone
 	{
 	public:
 		ScriptMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
+		virtual ~ScriptMeasure();
 		
 		virtual double ComputeResult( const Model& model ) override;
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
@@ -57,6 +58,7 @@ namespace scone
 
 	private:
 		u_ptr< class lua_script > script_;
+		u_ptr< struct LuaModel > lua_model_;
 		std::function<void( struct LuaModel* )> init_;
 		std::function<bool( struct LuaModel* )> update_;
 		std::function<double( struct LuaModel* )> result_;
@@ -87,7 +87,22 @@ namespace scone
 			"muscle_count", &LuaModel::muscle_count,
 			"body", &LuaModel::body,
 			"find_body", &LuaModel::find_body,
-			"body_count", &LuaModel::body_count
+			"body_count", &LuaModel::body_count,
+			"muscle_excitation_array", &LuaModel::muscle_excitation_array,
+			"muscle_activation_array", &LuaModel::muscle_activation_array,
+			"muscle_fiber_length_array", &LuaModel::muscle_fiber_length_array,
+			"muscle_normalized_fiber_length_array", &LuaModel::muscle_normalized_fiber_length_array,
+			"muscle_contraction_velocity_array", &LuaModel::muscle_contraction_velocity_array,
+			"muscle_force_array", &LuaModel::muscle_force_array,
+			"muscle_normalized_force_array", &LuaModel::muscle_normalized_force_array,
+			"dof_position_array", &LuaModel::dof_position_array,
+			"dof_velocity_array", &LuaModel::dof_velocity_array,
+			"body_com_pos_array", &LuaModel::body_com_pos_array,
+			"body_com_vel_array", &LuaModel::body_com_vel_array,
+			"body_ang_vel_array", &LuaModel::body_ang_vel_array,
+			"body_contact_force_array", &LuaModel::body_contact_force_array,
+			"actuator_input_array", &LuaModel::actuator_input_array,
+			"add_actuator_inputs", &LuaModel::add_actuator_inputs
 			);
 
 		lua.new_usertype<LuaParams>( "LuaParams", sol::constructors<>(),
@@ -31,6 +31,26 @@ namespace scone
 		return *it;
 	}
 
+	/// fill a persistent LuaArray with a value for each item in vec
+	template< typename A, typename T, typename F > A& FillLuaArray( A& arr, const std::vector<T>& vec, F f ) {
+		arr.resize( vec.size() );
+		for ( index_t i = 0; i < vec.size(); ++i )
+			arr[ i ] = f( *vec[ i ] );
+		return arr;
+	}
+
+	/// fill a persistent LuaArray with x, y, z components of a Vec3 for each item in vec
+	template< typename A, typename T, typename F > A& FillLuaArrayVec3( A& arr, const std::vector<T>& vec, F f ) {
+		arr.resize( 3 * vec.size() );
+		for ( index_t i = 0; i < vec.size(); ++i ) {
+			const Vec3 v = f( *vec[ i ] );
+			arr[ 3 * i ] = v.x;
+			arr[ 3 * i + 1 ] = v.y;
+			arr[ 3 * i + 2 ] = v.z;
+		}
+		return arr;
+	}
+
 	/// Access to scone logging and parameters
 	/** Use this for logging, or accessing parameters defined in scone. Lua example:
 	\verbatim
@@ -59,6 +79,18 @@ namespace scone
 	using LuaVec3 = Vec3d;
 	using LuaQuat = Quatd;
 
+	/// Array of numbers for bulk access to model quantities, indexing starts at 1.
+	/** Arrays are owned by the model and are updated in-place each time they are requested,
+	so they can be kept between calls without any copying. Lua example:
+	\verbatim
+	local lengths = model:muscle_fiber_length_array() -- updates and returns the array
+	for i = 1, #lengths do
+		-- process lengths[ i ]
+	end
+	\endverbatim
+	*/
+	using LuaArray = std::vector<LuaNumber>;
+
 	/// Access to writing data for scone Analysis window
 	struct LuaFrame
 	{
@@ -245,7 +277,62 @@ namespace scone
 		/// number of bodies
 		int body_count() { return static_cast<int>( mod_.GetBodies().size() ); }
 
+		/// get the excitation of all muscles as array
+		LuaArray& muscle_excitation_array() { return FillLuaArray( muscle_excitation_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetExcitation(); } ); }
+		/// get the activation of all muscles as array
+		LuaArray& muscle_activation_array() { return FillLuaArray( muscle_activation_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetActivation(); } ); }
+		/// get the fiber length [m] of all muscles as array
+		LuaArray& muscle_fiber_length_array() { return FillLuaArray( muscle_fiber_length_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetFiberLength(); } ); }
+		/// get the normalized fiber length of all muscles as array
+		LuaArray& muscle_normalized_fiber_length_array() { return FillLuaArray( muscle_normalized_fiber_length_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetNormalizedFiberLength(); } ); }
+		/// get the contraction velocity [m/s] of all muscles as array
+		LuaArray& muscle_contraction_velocity_array() { return FillLuaArray( muscle_contraction_velocity_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetFiberVelocity(); } ); }
+		/// get the force [N] of all muscles as array
+		LuaArray& muscle_force_array() { return FillLuaArray( muscle_force_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetForce(); } ); }
+		/// get the normalized force of all muscles as array
+		LuaArray& muscle_normalized_force_array() { return FillLuaArray( muscle_normalized_force_, mod_.GetMuscles(), []( const Muscle& m ) { return m.GetNormalizedForce(); } ); }
+
+		/// get the position [m] or [rad] of all dofs as array
+		LuaArray& dof_position_array() { return FillLuaArray( dof_position_, mod_.GetDofs(), []( const Dof& d ) { return d.GetPos(); } ); }
+		/// get the velocity [m/s] or [rad/s] of all dofs as array
+		LuaArray& dof_velocity_array() { return FillLuaArray( dof_velocity_, mod_.GetDofs(), []( const Dof& d ) { return d.GetVel(); } ); }
+
+		/// get the com position [m] of all bodies as array { x1, y1, z1, x2, y2, z2, ... }
+		LuaArray& body_com_pos_array() { return FillLuaArrayVec3( body_com_pos_, mod_.GetBodies(), []( const Body& b ) { return b.GetComPos(); } ); }
+		/// get the com velocity [m/s] of all bodies as array { x1, y1, z1, x2, y2, z2, ... }
+		LuaArray& body_com_vel_array() { return FillLuaArrayVec3( body_com_vel_, mod_.GetBodies(), []( const Body& b ) { return b.GetComVel(); } ); }
+		/// get the angular velocity [rad/s] of all bodies as array { x1, y1, z1, x2, y2, z2, ... }
+		LuaArray& body_ang_vel_array() { return FillLuaArrayVec3( body_ang_vel_, mod_.GetBodies(), []( const Body& b ) { return b.GetAngVel(); } ); }
+		/// get the contact force [N] of all bodies as array { x1, y1, z1, x2, y2, z2, ... }
+		LuaArray& body_contact_force_array() { return FillLuaArrayVec3( body_contact_force_, mod_.GetBodies(), []( const Body& b ) { return b.GetContactForce(); } ); }
+
+		/// get the current input of all actuators as array
+		LuaArray& actuator_input_array() { return FillLuaArray( actuator_input_, mod_.GetActuators(), []( const Actuator& a ) { return a.GetInput(); } ); }
+		/// add values to the inputs of all actuators; values must contain one entry per actuator
+		void add_actuator_inputs( const LuaArray& values ) {
+			auto& acts = mod_.GetActuators();
+			SCONE_ERROR_IF( values.size() != acts.size(), "Array size must be equal to number of actuators (" + xo::to_str( acts.size() ) + ")" );
+			for ( index_t i = 0; i < acts.size(); ++i )
+				acts[ i ]->AddInput( values[ i ] );
+		}
+
 		Model& mod_;
+
+	private:
+		LuaArray muscle_excitation_;
+		LuaArray muscle_activation_;
+		LuaArray muscle_fiber_length_;
+		LuaArray muscle_normalized_fiber_length_;
+		LuaArray muscle_contraction_velocity_;
+		LuaArray muscle_force_;
+		LuaArray muscle_normalized_force_;
+		LuaArray dof_position_;
+		LuaArray dof_velocity_;
+		LuaArray body_com_pos_;
+		LuaArray body_com_vel_;
+		LuaArray body_ang_vel_;
+		LuaArray body_contact_force_;
+		LuaArray actuator_input_;
 	};
 
 	/// parameter access for use in lua scripting.
@@ -14,7 +14,7 @@ namespace scone
 	ContactForceOpenSim3::ContactForceOpenSim3( ModelOpenSim3& model, const OpenSim::HuntCrossleyForce& osForce ) :
 		m_osForce( osForce ),
 		m_Model( model ),
-		m_LastNumDynamicsRealizations( -1 )
+		m_Realization( -1 )
 	{
 		auto& osForceNonConst = const_cast<OpenSim::HuntCrossleyForce&>( m_osForce ); // hack for OpenSim bug
 		auto& osGeometry = osForceNonConst.getContactParametersSet().get( 0 ).getGeometry();
@@ -85,26 +85,17 @@ namespace scone
 
 	void ContactForceOpenSim3::UpdateForceValues() const
 	{
-		auto& osModel = m_Model.GetOsimModel();
-		auto& tkState = m_Model.GetTkState();
-
-		// realize the state and check the number of realizations
-		// IMPORTANT: we use the getNumRealizationsOfThisStage() instead of time or step
-		// because FixTkState() calls this multiple times before integration
-		osModel.getMultibodySystem().realize( tkState, SimTK::Stage::Dynamics );
-		int num_dyn = osModel.getMultibodySystem().getNumRealizationsOfThisStage( SimTK::Stage::Dynamics );
-
-		// update m_ContactForceValues only if needed (performance)
-		if ( m_LastNumDynamicsRealizations != num_dyn )
-		{
-			OpenSim::Array<double> forces = m_osForce.getRecordValues( tkState );
-			for ( int i = 0; i < forces.size(); ++i )
-				m_Values[ i ] = forces[ i ];
-			m_LastNumDynamicsRealizations = num_dyn;
-
-			m_Force.set( -m_Values[ 0 ], -m_Values[ 1 ], -m_Values[ 2 ] );
-			m_Moment.set( -m_Values[ 3 ], -m_Values[ 4 ], -m_Values[ 5 ] );
-			m_Point = GetPlaneCop( m_PlaneNormal, m_PlaneLocation, m_Force, m_Moment );
-		}
+		auto realization = m_Model.RealizeDynamics();
+		if ( realization == m_Realization )
+			return;
+
+		m_Realization = realization;
+		OpenSim::Array<double> forces = m_osForce.getRecordValues( m_Model.GetTkState() );
+		for ( int i = 0; i < forces.size(); ++i )
+			m_Values[ i ] = forces[ i ];
+
+		m_Force.set( -m_Values[ 0 ], -m_Values[ 1 ], -m_Values[ 2 ] );
+		m_Moment.set( -m_Values[ 3 ], -m_Values[ 4 ], -m_Values[ 5 ] );
+		m_Point = GetPlaneCop( m_PlaneNormal, m_PlaneLocation, m_Force, m_Moment );
 	}
 }
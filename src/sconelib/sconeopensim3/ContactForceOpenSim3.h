@@ -41,8 +41,9 @@ namespace scone
 		mutable Vec3 m_Moment;
 		mutable Vec3 m_Point;
 
+		// read force values from OpenSim into preallocated storage, once per realization of Dynamics
 		void UpdateForceValues() const;
-		mutable int m_LastNumDynamicsRealizations;
+		mutable int m_Realization;
 		mutable std::vector< Real > m_Values;
 		std::vector< String > m_Labels;
 		Vec3 m_PlaneNormal;
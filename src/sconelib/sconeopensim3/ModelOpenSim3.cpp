@@ -569,6 +569,7 @@ namespace scone
 
 				{
 					SCONE_PROFILE_SCOPE( GetProfiler(), "SimTK::TimeStepper::stepTo" );
+					ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Step" );
 					auto status = m_pTkTimeStepper->stepTo( target_time );
 					if ( status == SimTK::Integrator::EndOfSimulation )
 						RequestTermination();
@@ -583,6 +584,7 @@ namespace scone
 				// this way the results are always consistent
 				{
 					SCONE_PROFILE_SCOPE( GetProfiler(), "SimTK::MultibodySystem::realize" );
+					ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Realize" );
 					m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
 				}
 
@@ -609,6 +611,15 @@ namespace scone
 		}
 	}
 
+	int ModelOpenSim3::RealizeDynamics() const
+	{
+		// IMPORTANT: we use the getNumRealizationsOfThisStage() instead of time or step
+		// because FixTkState() calls this multiple times before integration
+		auto& mbs = GetOsimModel().getMultibodySystem();
+		mbs.realize( GetTkState(), SimTK::Stage::Dynamics );
+		return mbs.getNumRealizationsOfThisStage( SimTK::Stage::Dynamics );
+	}
+
 	void ModelOpenSim3::RequestTermination()
 	{
 		Model::RequestTermination();
@@ -740,6 +751,7 @@ namespace scone
 
 	void ModelOpenSim3::CopyStateFromTk()
 	{
+		InvalidateStepCache();
 		SCONE_ASSERT( m_State.GetSize() >= GetOsimModel().getNumStateVariables() );
 		auto osvalues = GetOsimModel().getStateValues( GetTkState() );
 		for ( int i = 0; i < osvalues.size(); ++i )
@@ -748,6 +760,7 @@ namespace scone
 
 	void ModelOpenSim3::CopyStateToTk()
 	{
+		InvalidateStepCache();
 		SCONE_ASSERT( m_State.GetSize() >= GetOsimModel().getNumStateVariables() );
 		GetOsimModel().setStateValues( GetTkState(), &m_State.GetValues()[ 0 ] );
 
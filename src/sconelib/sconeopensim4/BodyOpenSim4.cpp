@@ -25,7 +25,7 @@ namespace scone
 		m_osBody( body ),
 		m_Model( model ),
 		m_ForceIndex( -1 ),
-		m_LastNumDynamicsRealizations( -1 )
+		m_ContactForceRealization( -1 )
 	{
 		ConnectContactForce( body.getName() );
 		if ( auto* body = dynamic_cast<const OpenSim::Body*>( &m_osBody ) ) {
@@ -262,19 +262,17 @@ namespace scone
 
 	const std::vector< scone::Real >& BodyOpenSim4::GetContactForceValues() const
 	{
+		// values are read from OpenSim once per realization of Dynamics
 		if ( m_ForceIndex != -1 )
 		{
-			m_osBody.getModel().getMultibodySystem().realize( m_Model.GetTkState(), SimTK::Stage::Dynamics );
-			int num_dyn = m_osBody.getModel().getMultibodySystem().getNumRealizationsOfThisStage( SimTK::Stage::Dynamics );
-
-			if ( m_LastNumDynamicsRealizations != num_dyn )
+			auto realization = m_Model.RealizeDynamics();
+			if ( realization != m_ContactForceRealization )
 			{
 				// TODO: find out if this can be done less clumsy in OpenSim
-				m_osBody.getModel().getMultibodySystem().realize( m_Model.GetTkState(), SimTK::Stage::Dynamics );
 				OpenSim::Array<double> forces = m_osBody.getModel().getForceSet().get( m_ForceIndex ).getRecordValues( m_Model.GetTkState() );
 				for ( int i = 0; i < forces.size(); ++i )
 					m_ContactForceValues[ i ] = forces[ i ];
-				m_LastNumDynamicsRealizations = num_dyn;
+				m_ContactForceRealization = realization;
 			}
 		}
 		return m_ContactForceValues;
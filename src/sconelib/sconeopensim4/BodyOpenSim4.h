@@ -75,7 +75,7 @@ namespace scone
 	private:
 		Vec3 m_LocalComPos;
 		int m_ForceIndex;
-		mutable int m_LastNumDynamicsRealizations;
+		mutable int m_ContactForceRealization;
 		mutable std::vector< Real > m_ContactForceValues;
 		std::vector< String > m_ContactForceLabels;
 	};
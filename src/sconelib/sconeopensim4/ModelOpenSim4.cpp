@@ -665,6 +665,7 @@ namespace scone
 
 				{
 					SCONE_PROFILE_SCOPE( "SimTK::TimeStepper::stepTo" );
+					ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Step" );
 					status = m_pTkTimeStepper->stepTo( target_time );
 				}
 
@@ -675,7 +676,10 @@ namespace scone
 
 				// Realize Acceleration, analysis components may need it
 				// this way the results are always consistent
-				m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
+				{
+					ScopedPerfCounters perf_counters( m_PerfCounters.get(), "Realize" );
+					m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
+				}
 
 				// update the sensor delays, analyses, and store data
 				UpdateSensorDelayAdapters();
@@ -700,6 +704,13 @@ namespace scone
 		}
 	}
 
+	int ModelOpenSim4::RealizeDynamics() const
+	{
+		auto& mbs = GetOsimModel().getMultibodySystem();
+		mbs.realize( GetTkState(), SimTK::Stage::Dynamics );
+		return mbs.getNumRealizationsOfThisStage( SimTK::Stage::Dynamics );
+	}
+
 	double ModelOpenSim4::GetTime() const
 	{
 		return GetTkState().getTime();
@@ -839,6 +850,7 @@ namespace scone
 
 	void ModelOpenSim4::CopyStateFromTk()
 	{
+		InvalidateStepCache();
 		SCONE_ASSERT( m_State.GetSize() >= GetOsimModel().getNumStateVariables() );
 		auto osvalues = GetOsimModel().getStateVariableValues( GetTkState() );
 		for ( int i = 0; i < osvalues.size(); ++i )
@@ -847,6 +859,7 @@ namespace scone
 
 	void ModelOpenSim4::CopyStateToTk()
 	{
+		InvalidateStepCache();
 		SCONE_ASSERT( m_State.GetSize() >= GetOsimModel().getNumStateVariables() );
 		GetOsimModel().setStateVariableValues( GetTkState(),
 				SimTK::Vector( m_State.GetSize(), &m_State.GetValues()[ 0 ] ) );
@@ -122,6 +122,9 @@ namespace scone
 		virtual void SetController( ControllerUP c ) override;
 		void InitializeOpenSimMuscleActivations( double override_activation = 0.0 );
 
+		/// Realize the Dynamics stage and return the number of realizations, which identifies the current state
+		int RealizeDynamics() const;
+
 	private:
 		void InitStateFromTk();
 		void CopyStateFromTk();
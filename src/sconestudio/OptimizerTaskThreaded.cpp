@@ -4,6 +4,7 @@
 #include "scone/core/Factories.h"
 #include "scone/optimization/opt_tools.h"
 #include "spot/optimizer.h"
+#include "scone/optimization/CmaOptimizerSpot.h"
 
 namespace scone
 {
@@ -53,6 +54,8 @@ namespace scone
 		if ( has_optimizer_ )
 		{
 			dynamic_cast<spot::optimizer&>( *optimizer_ ).interrupt();
+			if ( auto* cma = dynamic_cast<CmaOptimizerSpot*>( optimizer_.get() ) )
+				cma->StopAsync();
 			return true;
 		}
 		else return false;
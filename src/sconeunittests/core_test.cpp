@@ -0,0 +1,262 @@
+/*
+** core_test.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "scone/core/AsyncLogSink.h"
+#include "scone/core/AsyncOutputWriter.h"
+#include "scone/core/Benchmark.h"
+#include "scone/core/Log.h"
+#include "scone/core/ProfileAggregator.h"
+#include "scone/core/ProfileTimeline.h"
+#include "scone/core/Socket.h"
+#include "scone/core/string_tools.h"
+
+#include "xo/filesystem/filesystem.h"
+#include "xo/filesystem/path.h"
+#include "xo/system/test_case.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace scone;
+
+XO_TEST_CASE( socket_test )
+{
+	// length-prefixed messages of different sizes, including one that needs several receive calls
+	auto listener = Socket::Listen( "127.0.0.1:0" );
+	auto address = "127.0.0.1:" + to_str( listener.GetLocalPort() );
+	std::vector< std::vector< char > > messages;
+	for ( size_t size : { 0, 1, 1000, 4 << 20 } )
+	{
+		messages.emplace_back( size );
+		for ( size_t i = 0; i < size; ++i )
+			messages.back()[ i ] = char( i * 31 + size );
+	}
+
+	auto sender = std::thread( [&]() {
+		auto s = Socket::Connect( address );
+		for ( auto& m : messages )
+		{
+			uint64_t size = m.size();
+			s.Send( &size, sizeof( size ) );
+			s.Send( m.data(), m.size() );
+		}
+	} );
+
+	auto s = listener.Accept();
+	XO_CHECK( s.IsValid() );
+	for ( auto& m : messages )
+	{
+		uint64_t size = 0;
+		XO_CHECK( s.Receive( &size, sizeof( size ) ) );
+		XO_CHECK_MESSAGE( size == m.size(), to_str( size ) );
+		std::vector< char > buf( size );
+		XO_CHECK( s.Receive( buf.data(), buf.size() ) );
+		XO_CHECK( buf == m );
+	}
+	sender.join();
+
+	// the sender is closed after the last message
+	char c;
+	XO_CHECK( !s.Receive( &c, 1 ) );
+}
+
+XO_TEST_CASE( benchmark_results_test )
+{
+	PropNode pn;
+	pn.set( "computer", "test \"pc\"" );
+	pn.set( "cpu", "cpu\twith tab\nand newline" );
+	pn.set( "hardware_threads", 16 );
+	pn.set( "empty", "" );
+	auto& c = pn.add_child( "components" );
+	auto& step = c.add_child( "Step" );
+	step.set( "median_ns", 1234.5 );
+	step.set( "std_ns", 10 );
+	c.add_child( "Realize" ).set( "median_ns", -2e-3 );
+
+	// json round-trip, including escaped characters
+	auto folder = xo::temp_directory_path() / "SCONE/benchmark_results_test";
+	xo::create_directories( folder );
+	SaveBenchmarkResults( pn, folder / "results.json" );
+	auto loaded = LoadBenchmarkResults( folder / "results.json" );
+	XO_CHECK_MESSAGE( loaded.get< String >( "computer" ) == "test \"pc\"", loaded.get< String >( "computer" ) );
+	XO_CHECK( loaded.get< String >( "cpu" ) == "cpu\twith tab\nand newline" );
+	XO_CHECK( loaded.get< int >( "hardware_threads" ) == 16 );
+	XO_CHECK( loaded.get< String >( "empty" ) == "" );
+	XO_CHECK( loaded.get_child( "components" ).size() == 2 );
+	XO_CHECK( loaded.get_child( "components" ).get_child( "Step" ).get< double >( "median_ns" ) == 1234.5 );
+	XO_CHECK( loaded.get_child( "components" ).get_child( "Step" ).get< int >( "std_ns" ) == 10 );
+	XO_CHECK( loaded.get_child( "components" ).get_child( "Realize" ).get< double >( "median_ns" ) == -2e-3 );
+
+	// unicode escapes, including a surrogate pair
+	{
+		std::ofstream str( ( folder / "unicode.json" ).str() );
+		str << "{ \"name\": \"caf\\u00e9 \\ud83d\\ude00\\b\\f\\/\" }";
+	}
+	auto unicode = LoadBenchmarkResults( folder / "unicode.json" );
+	XO_CHECK_MESSAGE( unicode.get< String >( "name" ) == "caf\xc3\xa9 \xf0\x9f\x98\x80\b\f/", unicode.get< String >( "name" ) );
+
+	// regressions
+	auto make_results = []( double a, double b ) {
+		PropNode r;
+		r.set( "cpu", "test" );
+		auto& c = r.add_child( "components" );
+		auto& ca = c.add_child( "A" );
+		ca.set( "median_ns", a );
+		ca.set( "std_ns", 1.0 );
+		auto& cb = c.add_child( "B" );
+		cb.set( "median_ns", b );
+		cb.set( "std_ns", 1.0 );
+		return r;
+	};
+	auto regressions = FindBenchmarkRegressions( make_results( 100, 100 ), make_results( 100.5, 120 ), 3.0 );
+	XO_CHECK( regressions.size() == 1 && regressions.front() == "B" );
+	XO_CHECK( FindBenchmarkRegressions( make_results( 100, 100 ), make_results( 90, 100 ), 3.0 ).empty() );
+}
+
+XO_TEST_CASE( profile_aggregator_test )
+{
+	// each owner gets the scopes of its own evaluations
+	auto& pa = ProfileAggregator::GetInstance();
+	int a = 0, b = 0, c = 0;
+	pa.SetActive( &a, true );
+	pa.SetActive( &b, true );
+	XO_CHECK( ProfileAggregator::IsActive() );
+	{ ScopedProfileSample s( "EvalA" ); }
+	pa.FlushThread( &a );
+	for ( int i = 0; i < 2; ++i )
+	{
+		ScopedProfileSample s( "EvalB" );
+		ScopedProfileSample s2( "StepB" );
+	}
+	pa.FlushThread( &b );
+	{ ScopedProfileSample s( "EvalC" ); }
+	pa.FlushThread( &c ); // not active, discarded
+
+	XO_CHECK_MESSAGE( pa.GetEvaluationCount( &a ) == 1, to_str( pa.GetEvaluationCount( &a ) ) );
+	XO_CHECK_MESSAGE( pa.GetEvaluationCount( &b ) == 1, to_str( pa.GetEvaluationCount( &b ) ) );
+	XO_CHECK( pa.GetEvaluationCount( &c ) == 0 );
+	auto ra = pa.GetReport( &a );
+	auto rb = pa.GetReport( &b );
+	XO_CHECK( ra.get_child( "scopes" ).try_get_child( "EvalA" ) );
+	XO_CHECK( !ra.get_child( "scopes" ).try_get_child( "EvalB" ) );
+	XO_CHECK( !ra.get_child( "scopes" ).try_get_child( "EvalC" ) );
+	XO_CHECK( rb.get_child( "scopes" ).get_child( "EvalB" ).get< int >( "count" ) == 2 );
+	XO_CHECK( rb.get_child( "scopes" ).get_child( "EvalB" ).get_child( "StepB" ).get< int >( "count" ) == 2 );
+
+	// concurrent use of the same owner is rejected
+	bool rejected = false;
+	try { pa.SetActive( &a, true ); }
+	catch ( std::exception& ) { rejected = true; }
+	XO_CHECK( rejected );
+
+	// recording continues until all owners are inactive
+	pa.SetActive( &a, false );
+	XO_CHECK( ProfileAggregator::IsActive() );
+	XO_CHECK( pa.GetEvaluationCount( &a ) == 0 );
+	pa.SetActive( &b, false );
+	XO_CHECK( !ProfileAggregator::IsActive() );
+}
+
+XO_TEST_CASE( profile_timeline_test )
+{
+	// recording continues until each Start() is matched by Stop()
+	auto& pt = ProfileTimeline::GetInstance();
+	pt.Start( 100 );
+	pt.Start( 100 );
+	{ ScopedProfileSample s( "First" ); }
+	pt.Stop();
+	XO_CHECK( pt.IsRecording() );
+	{ ScopedProfileSample s( "Second" ); }
+	XO_CHECK_MESSAGE( pt.GetEventCount() == 2, to_str( pt.GetEventCount() ) );
+	pt.Stop();
+	XO_CHECK( !pt.IsRecording() );
+	XO_CHECK( !ProfileAggregator::IsActive() );
+	{ ScopedProfileSample s( "Third" ); }
+	XO_CHECK( pt.GetEventCount() == 2 );
+
+	// unmatched calls to Stop() are ignored, the next Start() clears the timeline
+	pt.Stop();
+	pt.Start( 100 );
+	XO_CHECK( pt.IsRecording() );
+	XO_CHECK( pt.GetEventCount() == 0 );
+	pt.Stop();
+	XO_CHECK( !pt.IsRecording() );
+}
+
+XO_TEST_CASE( async_log_sink_test )
+{
+	// other tests may log concurrently, so only lines with a marker are counted
+	auto count_lines = []( const xo::path& file ) {
+		std::ifstream str( file.str() );
+		int n = 0;
+		for ( String line; std::getline( str, line ); )
+			n += line.compare( 0, 14, "async_log_test" ) == 0;
+		return n;
+	};
+
+	auto folder = xo::temp_directory_path() / "SCONE/async_log_sink_test";
+	xo::create_directories( folder );
+	auto all_file = folder / "all_threads.log";
+	auto current_file = folder / "current_thread.log";
+	{
+		AsyncLogSink all_sink( all_file, xo::log::level::trace, xo::log::sink_mode::all_threads );
+		AsyncLogSink current_sink( current_file, xo::log::level::debug, xo::log::sink_mode::current_thread );
+
+		// threads exit before their messages are written
+		std::vector< std::thread > threads;
+		for ( int t = 0; t < 4; ++t )
+			threads.emplace_back( [t]() { for ( int i = 0; i < 100; ++i ) log::trace( "async_log_test thread ", t, " message ", i ); } );
+		for ( auto& t : threads )
+			t.join();
+		for ( int i = 0; i < 10; ++i )
+			log::debug( "async_log_test debug ", i );
+		log::trace( "async_log_test trace" );
+
+		all_sink.flush();
+		XO_CHECK_MESSAGE( count_lines( all_file ) == 411, to_str( count_lines( all_file ) ) );
+		XO_CHECK( AsyncLogSink::GetDroppedCount() == 0 );
+	}
+
+	// the files are complete and closed when the sinks are destroyed
+	XO_CHECK_MESSAGE( count_lines( all_file ) == 411, to_str( count_lines( all_file ) ) );
+	XO_CHECK_MESSAGE( count_lines( current_file ) == 10, to_str( count_lines( current_file ) ) );
+}
+
+XO_TEST_CASE( async_output_writer_test )
+{
+	AsyncOutputWriter writer;
+	std::promise< void > release;
+	auto released = release.get_future().share();
+	std::atomic_int first = 0, last = 0, other = 0;
+
+	// the first job blocks the writer thread, so that the next jobs with the same key are superseded
+	writer.Enqueue( "block", [released]() { released.wait(); } );
+	for ( int i = 1; i <= 5; ++i )
+		writer.Enqueue( "par", [&, i]() { ( i == 1 ? first : last ) = i; } );
+	writer.Enqueue( "other", [&]() { other = 1; } );
+	release.set_value();
+	writer.Flush();
+
+	XO_CHECK( first == 0 );
+	XO_CHECK_MESSAGE( last == 5, to_str( int( last ) ) );
+	XO_CHECK( other == 1 );
+	XO_CHECK_MESSAGE( writer.GetWrittenCount() == 3, to_str( writer.GetWrittenCount() ) );
+	XO_CHECK_MESSAGE( writer.GetCoalescedCount() == 4, to_str( writer.GetCoalescedCount() ) );
+
+	// failing jobs are logged, later jobs still run
+	writer.Enqueue( "par", []() { throw std::runtime_error( "test error" ); } );
+	writer.Enqueue( "other", [&]() { other = 2; } );
+	writer.Flush();
+	XO_CHECK( other == 2 );
+	XO_CHECK( writer.GetWrittenCount() == 5 );
+}
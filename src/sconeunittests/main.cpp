@@ -7,6 +7,8 @@
 */
 
 #include "scone/sconelib_config.h"
+#include "scone/core/Factories.h"
+#include "../sconebench/SyntheticModel.h"
 #include "xo/serialization/serialize.h"
 #include "xo/system/log_sink.h"
 #include "xo/system/test_case.h"
@@ -17,6 +19,7 @@ int main( int argc, const char* argv[] )
 {
 	xo::log::console_sink sink( xo::log::level::info );
 	scone::Initialize();
+	scone::GetModelFactory().register_type< scone::SyntheticModel >( "SyntheticModel" );
 
 	scone::add_scenario_tests( "scenarios/Tutorials" );
 	scone::add_scenario_tests( "scenarios/UnitTests" );
@@ -0,0 +1,52 @@
+/*
+** model_test.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "../sconebench/SyntheticModel.h"
+#include "scone/model/Leg.h"
+#include "scone/optimization/Params.h"
+
+#include "xo/system/test_case.h"
+
+using namespace scone;
+
+XO_TEST_CASE( model_step_cache_test )
+{
+	PropNode props;
+	ObjectiveInfo info;
+	SyntheticModel model( props, info );
+	const auto& cache = model.GetStepCache();
+	XO_CHECK( cache.GetComPos() == model.GetComPos() );
+	XO_CHECK( cache.GetBW() == model.GetBW() );
+
+	// values are updated after each step
+	auto com = cache.GetComPos();
+	model.AdvanceSimulationTo( 0.1 );
+	XO_CHECK( cache.GetComPos() != com );
+	XO_CHECK( cache.GetComPos() == model.GetComPos() );
+	XO_CHECK( cache.GetComVel() == model.GetComVel() );
+	XO_CHECK( cache.GetLinMom() == model.GetLinMom() );
+	XO_CHECK( cache.GetAngMom() == model.GetAngMom() );
+
+	Real total_force = 0.0;
+	for ( index_t i = 0; i < model.GetLegs().size(); ++i )
+	{
+		auto force = model.GetLegs()[ i ]->GetContactForce();
+		XO_CHECK( cache.GetLegContactForce( i ) == force );
+		XO_CHECK( std::abs( cache.GetLegLoad( i ) - xo::length( force ) / model.GetBW() ) < 1e-12 );
+		total_force += xo::length( force );
+	}
+	XO_CHECK( std::abs( cache.GetTotalContactForce() - total_force ) < 1e-9 );
+
+	// values are updated after the state is set, even if the step and time remain the same
+	auto values = model.GetState().GetValues();
+	values[ 2 ] += 1.0; // pelvis_tx
+	com = cache.GetComPos();
+	model.SetStateValues( values, model.GetTime() );
+	XO_CHECK( cache.GetComPos() != com );
+	XO_CHECK( cache.GetComPos() == model.GetComPos() );
+}
@@ -30,3 +30,37 @@ XO_TEST_CASE( optimization_test )
 
 	XO_CHECK_MESSAGE( o->GetBestFitness() < 1000.0, to_str( o->GetBestFitness() ) );
 }
+
+XO_TEST_CASE( checkpoint_test )
+{
+	auto test_folder = scone::GetFolder( scone::SCONE_ROOT_FOLDER ) / "resources/unittestdata/optimization_test";
+	PropNode pn = xo::load_file( test_folder / "schwefel_5.xml" );
+	auto& opt_pn = pn.get_child( "Optimizer" );
+	opt_pn.set( "max_generations", 50 );
+	opt_pn.set( "checkpoint_interval", 20 );
+	auto output_root = xo::temp_directory_path() / "SCONE/checkpoint_test";
+
+	OptimizerUP o = CreateOptimizer( pn, test_folder );
+	o->output_root = output_root;
+	o->Run();
+	auto folder = o->GetOutputFolder();
+	XO_CHECK( xo::file_exists( folder / "checkpoint.bin" ) );
+
+	// resuming continues in the same folder and reproduces the result
+	OptimizerUP resumed = CreateOptimizer( pn, test_folder );
+	resumed->output_root = output_root;
+	resumed->SetResumeFolder( folder );
+	XO_CHECK( resumed->IsResuming() && resumed->GetFitnessCache() );
+	resumed->Run();
+	XO_CHECK( resumed->GetOutputFolder() == folder );
+	XO_CHECK_MESSAGE( resumed->GetBestFitness() == o->GetBestFitness(), to_str( resumed->GetBestFitness() ) );
+
+	// checkpoints of a different scenario are rejected
+	PropNode other_pn = pn;
+	other_pn.get_child( "Optimizer" ).get_child( "Objective" ).set( "dim", 6 );
+	OptimizerUP other = CreateOptimizer( other_pn, test_folder );
+	bool rejected = false;
+	try { other->SetResumeFolder( folder ); }
+	catch ( std::exception& ) { rejected = true; }
+	XO_CHECK( rejected );
+}
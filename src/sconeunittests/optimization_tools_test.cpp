@@ -0,0 +1,513 @@
+/*
+** optimization_tools_test.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "scone/core/string_tools.h"
+#include "scone/optimization/EvaluationTelemetry.h"
+#include "scone/optimization/FairShareEvaluator.h"
+#include "scone/optimization/FitnessCache.h"
+#include "scone/optimization/NetworkEvaluator.h"
+#include "scone/optimization/ParamBindingPlan.h"
+#include "scone/optimization/SimulationObjective.h"
+#include "scone/optimization/SteadyStateCma.h"
+#include "scone/optimization/SurrogateEvaluator.h"
+#include "scone/optimization/opt_tools.h"
+#include "spot/evaluator.h"
+
+#include "xo/filesystem/filesystem.h"
+#include "xo/filesystem/path.h"
+#include "xo/string/string_tools.h"
+#include "xo/system/test_case.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace scone;
+namespace fs = std::filesystem;
+
+namespace
+{
+	// sum of squared parameter values
+	class SphereObjective : public spot::objective
+	{
+	public:
+		SphereObjective( size_t dim ) {
+			for ( index_t i = 0; i < dim; ++i )
+				info_.add( ParInfo( stringf( "x%d", int( i ) ), 0, 1, -10, 10 ) );
+			info_.set_minimize( true );
+		}
+		virtual fitness_t evaluate( const SearchPoint& point ) const override {
+			double f = 0.0;
+			for ( auto v : point.values() )
+				f += v * v;
+			return f;
+		}
+	};
+
+	// records the first parameter of each evaluation, negative values wait until the gate is opened
+	class GatedObjective : public spot::objective
+	{
+	public:
+		GatedObjective( std::vector< double >& log, std::mutex& log_mutex, std::shared_future< void > gate ) :
+			log_( log ), log_mutex_( log_mutex ), gate_( gate ) {
+			info_.add( ParInfo( "x", 0, 1, -10, 10 ) );
+		}
+		virtual fitness_t evaluate( const SearchPoint& point ) const override {
+			auto v = point.values()[ 0 ];
+			if ( v < 0 )
+				gate_.wait();
+			std::scoped_lock lock( log_mutex_ );
+			log_.push_back( v );
+			return v;
+		}
+		spot::search_point_vec points( const std::vector< double >& values ) const {
+			spot::search_point_vec pv;
+			for ( auto v : values )
+				pv.push_back( SearchPoint( info_, spot::par_vec{ v } ) );
+			return pv;
+		}
+	private:
+		std::vector< double >& log_;
+		std::mutex& log_mutex_;
+		std::shared_future< void > gate_;
+	};
+}
+
+XO_TEST_CASE( param_binding_plan_test )
+{
+	ObjectiveInfo info;
+	info.add( ParInfo( "a", 0, 1, -10, 10 ) );
+	info.add( ParInfo( "b", 0, 1, -10, 10 ) );
+	SearchPoint point( info, spot::par_vec{ 1.0, 2.0 } );
+
+	// record lookups, including one of a parameter that does not exist
+	ParamBinder recorder( point, nullptr );
+	XO_CHECK( *recorder.try_get( "a" ) == 1.0 );
+	XO_CHECK( !recorder.try_get( "c" ) );
+	XO_CHECK( *recorder.try_get( "b" ) == 2.0 );
+	XO_CHECK( !recorder.IsReplayed() );
+	auto plan = recorder.ExtractPlan( "S" );
+	XO_CHECK( plan.IsValidFor( "S", 2 ) && !plan.IsValidFor( "T", 2 ) && !plan.IsValidFor( "S", 3 ) );
+	XO_CHECK( plan.bindings.size() == 3 && plan.bindings[ 1 ].index == no_index && !plan.verified );
+
+	// replay with other values
+	SearchPoint other( info, spot::par_vec{ 3.0, 4.0 } );
+	ParamBinder replay( other, &plan );
+	XO_CHECK( *replay.try_get( "a" ) == 3.0 );
+	XO_CHECK( !replay.try_get( "c" ) );
+	XO_CHECK( *replay.try_get( "b" ) == 4.0 );
+	XO_CHECK( replay.IsReplayed() && replay.IsFirstReplay() );
+
+	// a verified plan is replayed by position
+	auto verified_plan = plan;
+	verified_plan.verified = true;
+	ParamBinder verified( other, &verified_plan );
+	XO_CHECK( *verified.try_get( "a" ) == 3.0 );
+	XO_CHECK( !verified.try_get( "c" ) );
+	XO_CHECK( *verified.try_get( "b" ) == 4.0 );
+	XO_CHECK( verified.IsReplayed() && !verified.IsFirstReplay() );
+
+	// a different lookup sequence falls back to regular lookups and keeps the replayed bindings
+	ParamBinder mismatch( other, &plan );
+	XO_CHECK( *mismatch.try_get( "a" ) == 3.0 );
+	XO_CHECK( *mismatch.try_get( "b" ) == 4.0 );
+	XO_CHECK( !mismatch.IsReplayed() );
+	auto new_plan = mismatch.ExtractPlan( "S" );
+	XO_CHECK( new_plan.bindings.size() == 2 && new_plan.bindings[ 0 ].index == 0 && new_plan.bindings[ 1 ].index == 1 );
+
+	// unused bindings also invalidate the plan
+	ParamBinder incomplete( other, &plan );
+	XO_CHECK( *incomplete.try_get( "a" ) == 3.0 );
+	XO_CHECK( !incomplete.IsReplayed() );
+	XO_CHECK( incomplete.ExtractPlan( "S" ).bindings.size() == 1 );
+}
+
+XO_TEST_CASE( steady_state_cma_test )
+{
+	// converges on a shifted sphere, with results returned in reverse order
+	const size_t dim = 5;
+	SteadyStateCma cma( dim, 0, 1.0, 123, true );
+	XO_CHECK( cma.lambda() == 4 + int( 3 * std::log( double( dim ) ) ) );
+	auto f = []( const SteadyStateCma::vec_t& x ) {
+		double s = 0.0;
+		for ( auto v : x )
+			s += ( v - 1.0 ) * ( v - 1.0 );
+		return s;
+	};
+
+	size_t completed = 0, decompositions = 0;
+	for ( int gen = 0; gen < 300; ++gen )
+	{
+		std::vector< SteadyStateCma::vec_t > samples;
+		for ( int i = 0; i < cma.lambda(); ++i )
+			samples.push_back( cma.Sample() );
+		std::reverse( samples.begin(), samples.end() );
+		for ( auto& x : samples )
+			completed += cma.Tell( x, f( x ) );
+
+		// the decomposition is requested once, until it is applied
+		if ( auto c = cma.GetPendingDecomposition(); !c.empty() )
+		{
+			XO_CHECK( cma.GetPendingDecomposition().empty() );
+			cma.SetDecomposition( SteadyStateCma::Decompose( dim, c ) );
+			++decompositions;
+		}
+	}
+	XO_CHECK_MESSAGE( completed == 300 && cma.generation() == 300, to_str( completed ) );
+	XO_CHECK( decompositions > 0 && decompositions <= 300 );
+	XO_CHECK_MESSAGE( f( cma.mean() ) < 1e-4, to_str( f( cma.mean() ) ) );
+	XO_CHECK( cma.sigma() < 0.1 );
+
+	// samples follow the covariance set by SetCovariance
+	SteadyStateCma corr_cma( 2, 0, 1.0, 123, true );
+	corr_cma.SetCovariance( { 1.0, 0.9, 0.9, 1.0 } );
+	double sxx = 0.0, syy = 0.0, sxy = 0.0;
+	for ( int i = 0; i < 10000; ++i )
+	{
+		auto x = corr_cma.Sample();
+		sxx += x[ 0 ] * x[ 0 ];
+		syy += x[ 1 ] * x[ 1 ];
+		sxy += x[ 0 ] * x[ 1 ];
+	}
+	auto correlation = sxy / std::sqrt( sxx * syy );
+	XO_CHECK_MESSAGE( std::abs( correlation - 0.9 ) < 0.02, to_str( correlation ) );
+	XO_CHECK( std::abs( corr_cma.std()[ 0 ] - 1.0 ) < 1e-9 );
+}
+
+XO_TEST_CASE( fitness_cache_test )
+{
+	ObjectiveInfo info;
+	info.add( ParInfo( "a", 0, 1, -1e40, 1e40 ) );
+	info.add( ParInfo( "b", 0, 1, -1e40, 1e40 ) );
+	auto point = [&]( double a, double b ) { return SearchPoint( info, spot::par_vec{ a, b } ); };
+
+	// keys are equal for values within the quantization, and differ otherwise
+	FitnessCache cache( 1e-9 );
+	auto key = cache.GetKey( point( 1.0, 2.0 ), "S" );
+	XO_CHECK( cache.GetKey( point( 1.0 + 1e-12, 2.0 ), "S" ) == key );
+	XO_CHECK( cache.GetKey( point( 1.0 + 1e-6, 2.0 ), "S" ) != key );
+	XO_CHECK( cache.GetKey( point( 2.0, 1.0 ), "S" ) != key );
+	XO_CHECK( cache.GetKey( point( 1.0, 2.0 ), "T" ) != key );
+
+	// values that overflow after quantization are still distinguished
+	XO_CHECK( cache.GetKey( point( 1e30, 0 ), "S" ) != cache.GetKey( point( 2e30, 0 ), "S" ) );
+	XO_CHECK( cache.GetKey( point( 1e30, 0 ), "S" ) != cache.GetKey( point( -1e30, 0 ), "S" ) );
+	auto nan = std::numeric_limits< double >::quiet_NaN();
+	XO_CHECK( cache.GetKey( point( nan, 0 ), "S" ) == cache.GetKey( point( nan, 0 ), "S" ) );
+
+	// round-trip through a file
+	cache.Insert( key, 1.0 / 3.0 );
+	cache.Insert( cache.GetKey( point( 1e30, 0 ), "S" ), -12345.678 );
+	XO_CHECK( cache.TryGet( key ) && *cache.TryGet( key ) == 1.0 / 3.0 );
+	XO_CHECK( !cache.TryGet( key + 1 ) );
+	auto folder = xo::temp_directory_path() / "SCONE/fitness_cache_test";
+	xo::create_directories( folder );
+	cache.Save( folder / "fitness_cache.txt" );
+
+	FitnessCache loaded( 1e-9 );
+	XO_CHECK( loaded.Load( folder / "fitness_cache.txt" ) == 2 );
+	XO_CHECK( loaded.TryGet( key ) && *loaded.TryGet( key ) == 1.0 / 3.0 );
+	XO_CHECK( loaded.TryGet( loaded.GetKey( point( 1e30, 0 ), "S" ) ) == -12345.678 );
+
+	// files with a different quantization are skipped
+	FitnessCache other( 1e-6 );
+	XO_CHECK( other.Load( folder / "fitness_cache.txt" ) == 0 );
+
+	// content signatures change with the props and the contents of the files
+	auto file = folder / "model.txt";
+	std::ofstream( file.str() ) << "model 1";
+	PropNode props;
+	props.set( "duration", 10 );
+	auto sig = FitnessCache::GetContentSignature( "S", props, { file } );
+	XO_CHECK( FitnessCache::GetContentSignature( "S", props, { file } ) == sig );
+	XO_CHECK( FitnessCache::GetContentSignature( "T", props, { file } ) != sig );
+	auto other_props = props;
+	other_props.set( "duration", 11 );
+	XO_CHECK( FitnessCache::GetContentSignature( "S", other_props, { file } ) != sig );
+	std::ofstream( file.str() ) << "model 2";
+	XO_CHECK( FitnessCache::GetContentSignature( "S", props, { file } ) != sig );
+}
+
+XO_TEST_CASE( network_evaluator_test )
+{
+	// a token is required for addresses other than localhost
+	bool rejected = false;
+	try { NetworkEvaluator( "*:0", 10.0 ); }
+	catch ( std::exception& ) { rejected = true; }
+	XO_CHECK( rejected );
+
+	NetworkEvaluator eval( "127.0.0.1:0", 10.0, "secret" );
+	SphereObjective objective( 2 ), other( 3 );
+	eval.SetScenario( objective, PropNode(), path( "." ) );
+
+	// objectives without a scenario are rejected
+	SearchPoint point( other.info(), spot::par_vec{ 1.0, 2.0, 3.0 } );
+	rejected = false;
+	try { eval.evaluate( other, { point }, xo::stop_token(), spot::priority_t() ); }
+	catch ( std::exception& ) { rejected = true; }
+	XO_CHECK( rejected );
+
+	// workers with the wrong token are disconnected
+	auto s = Socket::Connect( eval.GetAddress() );
+	String token = "wrong";
+	uint32_t type = 1, version = 3;
+	uint64_t pid = 1, token_size = token.size(), size = sizeof( version ) + sizeof( pid ) + sizeof( token_size ) + token.size();
+	XO_CHECK( s.Send( &type, sizeof( type ) ) && s.Send( &size, sizeof( size ) ) );
+	XO_CHECK( s.Send( &version, sizeof( version ) ) && s.Send( &pid, sizeof( pid ) ) );
+	XO_CHECK( s.Send( &token_size, sizeof( token_size ) ) && s.Send( token.data(), token.size() ) );
+	XO_CHECK( s.Receive( &type, sizeof( type ) ) && s.Receive( &size, sizeof( size ) ) );
+	XO_CHECK( type == 5 && size == 0 ); // goodbye
+}
+
+XO_TEST_CASE( fair_share_evaluator_test )
+{
+	std::vector< double > log;
+	std::mutex log_mutex;
+	std::promise< void > gate;
+	auto gate_future = gate.get_future().share();
+
+	// a single thread, blocked by a gated evaluation while the other evaluations are submitted
+	FairShareEvaluator fse( 1 );
+	GatedObjective blocker( log, log_mutex, gate_future ), a( log, log_mutex, gate_future ), b( log, log_mutex, gate_future ), c( log, log_mutex, gate_future );
+	xo::stop_token st;
+
+	auto submit = [&]( const GatedObjective& o, std::vector< double > values, spot::priority_t prio, size_t pending ) {
+		auto f = std::async( std::launch::async, [&fse, &o, &st, values, prio]() {
+			return fse.evaluate( o, o.points( values ), st, prio ); } );
+		while ( fse.GetPendingCount() < pending )
+			std::this_thread::yield();
+		return f;
+	};
+
+	auto f0 = submit( blocker, { -1 }, 0, 0 );
+	// wait until the blocker is running
+	while ( fse.GetObjectiveCount() == 0 || fse.GetPendingCount() > 0 )
+		std::this_thread::yield();
+	fse.SetWeight( b, 3.0 );
+	auto f1 = submit( a, { 1, 2 }, 0, 2 );
+	auto f2 = submit( a, { 3 }, 1, 3 ); // higher priority, is started before the earlier evaluations of a
+	auto f3 = submit( b, { 4, 5 }, 0, 5 ); // higher weight, is started before a
+	auto f4 = submit( c, { 6 }, 2, 6 ); // same load as a, but higher priority
+
+	// the blocker is still running, so it can only be removed after it is finished
+	fse.RemoveObjective( blocker );
+	XO_CHECK( fse.GetObjectiveCount() == 4 );
+
+	gate.set_value();
+	for ( auto* f : { &f0, &f1, &f2, &f3, &f4 } )
+		for ( auto& r : f->get() )
+			XO_CHECK( r );
+	XO_CHECK( log == std::vector< double >( { -1, 4, 5, 6, 3, 1, 2 } ) );
+	XO_CHECK( fse.GetObjectiveCount() == 3 );
+
+	for ( auto* o : { &a, &b, &c } )
+		fse.RemoveObjective( *o );
+	XO_CHECK( fse.GetObjectiveCount() == 0 );
+}
+
+XO_TEST_CASE( surrogate_evaluator_test )
+{
+	SphereObjective objective( 2 );
+	spot::sequential_evaluator target;
+	SurrogateEvaluator eval( target );
+	SurrogateEvaluator::Options opt;
+	opt.fraction = 0.5;
+	opt.random_fraction = 0.0;
+	opt.min_correlation = -1.0;
+	opt.archive_size = 100;
+	eval.SetOptions( objective, opt );
+
+	std::mt19937_64 rng( 123 );
+	std::uniform_real_distribution< double > uniform( -3.0, 3.0 );
+	auto make_batch = [&]() {
+		spot::search_point_vec points;
+		for ( int i = 0; i < 40; ++i )
+			points.emplace_back( objective.info(), spot::par_vec{ uniform( rng ), uniform( rng ) } );
+		return points;
+	};
+
+	// the first batch is evaluated completely, because there are no samples to fit the surrogate
+	auto results = eval.evaluate( objective, make_batch(), xo::stop_token(), spot::priority_t() );
+	XO_CHECK( eval.GetLastScreenedCount( objective ) == 0 );
+	XO_CHECK( std::all_of( results.begin(), results.end(), []( auto& r ) { return bool( r ); } ) );
+
+	// the surrogate fitted to a smooth function selects the best candidates
+	auto points = make_batch();
+	results = eval.evaluate( objective, points, xo::stop_token(), spot::priority_t() );
+	auto evaluated = eval.GetLastEvaluated( objective );
+	XO_CHECK( eval.GetLastScreenedCount( objective ) == 20 );
+	XO_CHECK( std::count( evaluated.begin(), evaluated.end(), true ) == 20 );
+	XO_CHECK_MESSAGE( eval.GetLastCorrelation( objective ) > 0.8, to_str( eval.GetLastCorrelation( objective ) ) );
+
+	double worst_evaluated = -1.0, best_screened = 1e9, best = 1e9;
+	index_t best_idx = 0;
+	for ( index_t i = 0; i < points.size(); ++i )
+	{
+		auto f = objective.evaluate( points[ i ] );
+		if ( f < best )
+			best = f, best_idx = i;
+		if ( evaluated[ i ] )
+		{
+			XO_CHECK( results[ i ].value() == f );
+			worst_evaluated = std::max( worst_evaluated, f );
+		}
+		else best_screened = std::min( best_screened, results[ i ].value() );
+	}
+	XO_CHECK( evaluated[ best_idx ] );
+
+	// placeholders are ranked below all evaluated candidates
+	XO_CHECK( best_screened > worst_evaluated );
+
+	// the number of evaluations is rounded down, unless it is below the minimum
+	opt.fraction = 0.25;
+	opt.min_evaluations = 0;
+	eval.SetOptions( objective, opt );
+	eval.evaluate( objective, make_batch(), xo::stop_token(), spot::priority_t() );
+	XO_CHECK( eval.GetLastScreenedCount( objective ) == 30 );
+	opt.min_evaluations = 15;
+	eval.SetOptions( objective, opt );
+	eval.evaluate( objective, make_batch(), xo::stop_token(), spot::priority_t() );
+	XO_CHECK( eval.GetLastScreenedCount( objective ) == 25 );
+
+	eval.RemoveObjective( objective );
+	eval.evaluate( objective, make_batch(), xo::stop_token(), spot::priority_t() );
+	XO_CHECK( eval.GetLastScreenedCount( objective ) == 0 );
+}
+
+XO_TEST_CASE( short_horizon_test )
+{
+	PropNode pn;
+	auto& so_pn = pn.add_child( "SimulationObjective" );
+	so_pn.set( "max_duration", 1.0 );
+	so_pn.set( "short_horizon", 0.5 );
+	so_pn.add_child( "SyntheticModel" );
+	auto& rc_pn = so_pn.add_child( "ReflexController" ).add_child( "MuscleReflex" );
+	rc_pn.set( "target", "muscle0" );
+	rc_pn.set( "KL", "~1<-10,10>" );
+	rc_pn.set( "L0", "~0.7<0,2>" );
+	so_pn.add_child( "EffortMeasure" ).set( "measure_type", "Wang2012" );
+	SimulationObjective so( so_pn, path() );
+	XO_CHECK( so.AdjustsGenerationResults() && so.info().minimize() );
+
+	spot::search_point_vec points;
+	for ( int i = 0; i < 6; ++i )
+		points.emplace_back( so.info(), spot::par_vec{ 1.0 + i, 0.7 } );
+
+	// screened candidates are ranked below the worst full-duration result, regardless of the order in which they finished
+	for ( auto order : { std::vector< index_t >{ 1, 3 }, std::vector< index_t >{ 3, 1 } } )
+	{
+		so.BeginGeneration();
+		std::vector< result< fitness_t > > results{ 10.0, 5.0, 30.0, 2.0, 20.0, xo::error_message( "canceled" ) };
+		for ( auto i : order )
+			so.AddPartialResult( points[ i ], results[ i ].value() );
+		so.EndGeneration( points, results );
+		XO_CHECK( results[ 0 ].value() == 10.0 && results[ 2 ].value() == 30.0 && results[ 4 ].value() == 20.0 && !results[ 5 ] );
+		XO_CHECK_MESSAGE( results[ 3 ].value() > 30.0 && results[ 1 ].value() > results[ 3 ].value(), to_str( results[ 3 ].value() ) );
+	}
+
+	// evaluated candidates that do not continue to max_duration are ranked last
+	so.BeginGeneration();
+	std::vector< result< fitness_t > > results;
+	for ( auto& p : points )
+		results.push_back( so.evaluate( p, xo::stop_token() ) );
+	auto evaluated = results;
+	so.EndGeneration( points, results );
+	double worst_full = 0.0, best_screened = std::numeric_limits< double >::max();
+	for ( index_t i = 0; i < points.size(); ++i )
+	{
+		XO_CHECK( results[ i ] );
+		if ( results[ i ].value() == evaluated[ i ].value() )
+			worst_full = std::max( worst_full, results[ i ].value() );
+		else best_screened = std::min( best_screened, results[ i ].value() );
+	}
+	XO_CHECK( best_screened > worst_full );
+}
+
+XO_TEST_CASE( find_par_files_test )
+{
+	auto root = fs::path( ( xo::temp_directory_path() / "SCONE/find_par_files_test" ).str() );
+	fs::remove_all( root );
+	for ( auto f : { "a/0010_x.par", "a/0100_y.par", "a/0020_z.par", "b/0005_w.par", "b/notes.txt" } )
+	{
+		fs::create_directories( ( root / f ).parent_path() );
+		std::ofstream( root / f ) << "p 1\n";
+	}
+	auto to_fs = []( const std::vector< path >& files ) {
+		std::vector< fs::path > r;
+		for ( auto& f : files )
+			r.push_back( fs::path( f.str() ).lexically_normal() );
+		return r;
+	};
+	auto expected = [&]( std::initializer_list< const char* > files ) {
+		std::vector< fs::path > r;
+		for ( auto f : files )
+			r.push_back( ( root / f ).lexically_normal() );
+		return r;
+	};
+
+	// last .par file of each folder
+	XO_CHECK( to_fs( FindParFiles( root.string() ) ) == expected( { "a/0100_y.par", "b/0005_w.par" } ) );
+
+	// wildcards match a single path element
+	XO_CHECK( to_fs( FindParFiles( ( root / "*" / "00?0_*.par" ).string() ) ) == expected( { "a/0010_x.par", "a/0020_z.par" } ) );
+	XO_CHECK( to_fs( FindParFiles( ( root / "b" / "*.par" ).string() ) ) == expected( { "b/0005_w.par" } ) );
+
+	// single file
+	XO_CHECK( to_fs( FindParFiles( ( root / "a/0010_x.par" ).string() ) ) == expected( { "a/0010_x.par" } ) );
+
+	// list file, with paths relative to the list file and comments
+	std::ofstream( root / "list.txt" ) << "a/0020_z.par\n# comment\n\nb/0005_w.par\n";
+	XO_CHECK( to_fs( FindParFiles( ( root / "list.txt" ).string() ) ) == expected( { "a/0020_z.par", "b/0005_w.par" } ) );
+
+	// no matches
+	bool has_error = false;
+	try { FindParFiles( ( root / "*" / "*.zml" ).string() ); }
+	catch ( std::exception& ) { has_error = true; }
+	XO_CHECK( has_error );
+}
+
+XO_TEST_CASE( evaluation_telemetry_test )
+{
+	// capacity is rounded up to a power of two, records that don't fit are dropped
+	EvaluationTelemetry telemetry( 3 );
+	for ( int i = 0; i < 6; ++i )
+		telemetry.Add( EvaluationRecord{ float( i ), 1.0f, 0.0f, 10.0f, 100.0f } );
+	auto records = telemetry.Collect();
+	XO_CHECK_MESSAGE( records.size() == 4, to_str( records.size() ) );
+	XO_CHECK( telemetry.GetDroppedCount() == 2 );
+	for ( int i = 0; i < 4; ++i )
+		XO_CHECK( records[ i ].create_time == float( i ) );
+	XO_CHECK( telemetry.Collect().empty() );
+
+	// slots are reused after collection, also from multiple threads
+	std::vector< std::thread > threads;
+	for ( int t = 0; t < 2; ++t )
+		threads.emplace_back( [&]() { telemetry.Add( EvaluationRecord{ 1.0f, 2.0f, 0.0f, 5.0f, 100.0f } ); } );
+	for ( auto& t : threads )
+		t.join();
+	records = telemetry.Collect();
+	XO_CHECK( records.size() == 2 );
+
+	// both evaluations ended before the duration
+	auto summary = EvaluationTelemetry::GetSummary( records, 10.0 );
+	XO_CHECK( summary.get< int >( "early_terminations" ) == 2 );
+	XO_CHECK( EvaluationTelemetry::GetSummary( {}, 10.0 ).size() == 0 );
+
+	// the log line includes the total number of dropped records
+	auto line = EvaluationTelemetry::GetLogLine( 7, records, 10.0, telemetry.GetDroppedCount() );
+	XO_CHECK_MESSAGE( line.compare( 0, 8, "7\t2\t2\t2\t" ) == 0, line );
+	XO_CHECK( xo::split_str( line, "\t" ).size() == xo::split_str( EvaluationTelemetry::GetLogHeader(), "\t" ).size() );
+}